@@ -36,3 +36,43 @@
 char atto_at_least_one_fail = 0;
 size_t atto_counter_assert_failures = 0;
 size_t atto_counter_assert_passes = 0;
+const char* atto_current_test = NULL;
+
+static atto_hook_fn hooks_before[ATTO_MAX_HOOKS];
+static atto_hook_fn hooks_after[ATTO_MAX_HOOKS];
+static size_t hooks_amount = 0;
+
+int
+atto_hook_add(const atto_hook_fn before, const atto_hook_fn after)
+{
+    if (hooks_amount >= ATTO_MAX_HOOKS)
+    {
+        return 1;
+    }
+    hooks_before[hooks_amount] = before;
+    hooks_after[hooks_amount] = after;
+    hooks_amount++;
+    return 0;
+}
+
+void
+atto_run_test(const atto_test_fn test, const char* const name)
+{
+    atto_current_test = name;
+    for (size_t i = 0; i < hooks_amount; i++)
+    {
+        if (hooks_before[i] != NULL)
+        {
+            hooks_before[i](name);
+        }
+    }
+    test();
+    for (size_t i = hooks_amount; i > 0; i--)
+    {
+        if (hooks_after[i - 1] != NULL)
+        {
+            hooks_after[i - 1](name);
+        }
+    }
+    atto_current_test = NULL;
+}
@@ -43,10 +43,14 @@ extern "C"
  */
 #define ATTO_VERSION "1.4.1"
 
+#include <float.h>  /* For LDBL_MAX */
 #include <math.h>   /* For fabs(), fabsf(), isnan(), isinf(), isfinite() */
 #include <stddef.h> /* For size_t */
 #include <stdio.h>  /* For printf() */
 #include <string.h> /* For strncmp(), memcmp() */
+#ifdef ATTO_ABORT_ON_FAIL
+    #include <stdlib.h> /* For abort() */
+#endif
 
 /**
  * Boolean indicating if all tests passed successfully (when 0) or not.
@@ -114,6 +118,44 @@ extern size_t atto_counter_assert_passes;
         atto_counter_assert_passes,            \
         atto_counter_assert_failures)
 
+/**
+ * Records the site of an assertion that passed into the flight recorder.
+ *
+ * Implemented by the optional `atto_flight.h` module. Called by every
+ * assertion that passes only when the test executable is compiled with
+ * `ATTO_FLIGHT_RECORDER` defined.
+ *
+ * @param file name of the source file of the assertion, a string literal.
+ * @param line line of the assertion in \p file.
+ */
+void
+atto_flight_record(const char* file, int line);
+
+/**
+ * Statement executed by every assertion that passes, after counting it.
+ *
+ * Records the assertion site into the flight recorder when compiled with
+ * `ATTO_FLIGHT_RECORDER` defined, otherwise does nothing.
+ */
+#ifdef ATTO_FLIGHT_RECORDER
+    #define ATTO_FLIGHT_RECORD() atto_flight_record(__FILE__, __LINE__)
+#else
+    #define ATTO_FLIGHT_RECORD() ((void) 0)
+#endif
+
+/**
+ * Statement executed by every assertion that fails, after reporting the
+ * failure and before stopping the test case.
+ *
+ * Aborts the process when compiled with `ATTO_ABORT_ON_FAIL` defined, so
+ * fuzzers and debuggers notice the failure, otherwise does nothing.
+ */
+#ifdef ATTO_ABORT_ON_FAIL
+    #define ATTO_ON_FAIL() (fflush(stdout), abort())
+#else
+    #define ATTO_ON_FAIL() ((void) 0)
+#endif
+
 /**
  * Verifies if the given boolean expression is true.
  *
@@ -144,15 +186,56 @@ extern size_t atto_counter_assert_passes;
             printf("FAIL | File: %s:%d | Test case: %s\n", __FILE__, __LINE__, __func__); \
             atto_counter_assert_failures++;                                               \
             atto_at_least_one_fail = 1;                                                   \
+            ATTO_ON_FAIL();                                                               \
             return;                                                                       \
         }                                                                                 \
         else                                                                              \
         {                                                                                 \
             atto_counter_assert_passes++;                                                 \
+            ATTO_FLIGHT_RECORD();                                                         \
         }                                                                                 \
     }                                                                                     \
     while (0)
 
+/**
+ * Verifies if the given boolean expression is true, printing more details
+ * on failure.
+ *
+ * Works exactly like atto_assert(), but on failure it also executes the
+ * `details` statement right after the failing location is printed and before
+ * the end of the line, so further information (e.g. the obtained values) can
+ * be printed on the same `FAIL` line. The details are only computed on the
+ * failure path, so they cost nothing when the assertion passes.
+ *
+ * Useful to build more specific assertion macros on top of.
+ *
+ * Example:
+ * ```
+ * atto_assert_details(x < 10, printf(" | x: %d", x));
+ * // FAIL | File: test.c:12 | Test case: test_x | x: 11
+ * ```
+ */
+#define atto_assert_details(expression, details)                                        \
+    do                                                                                  \
+    {                                                                                   \
+        if (!(expression))                                                              \
+        {                                                                               \
+            printf("FAIL | File: %s:%d | Test case: %s", __FILE__, __LINE__, __func__); \
+            details;                                                                    \
+            printf("\n");                                                               \
+            atto_counter_assert_failures++;                                             \
+            atto_at_least_one_fail = 1;                                                 \
+            ATTO_ON_FAIL();                                                             \
+            return;                                                                     \
+        }                                                                               \
+        else                                                                            \
+        {                                                                               \
+            atto_counter_assert_passes++;                                               \
+            ATTO_FLIGHT_RECORD();                                                       \
+        }                                                                               \
+    }                                                                                   \
+    while (0)
+
 /**
  * Verifies if the given boolean expression is true.
  *
@@ -367,6 +450,9 @@ extern size_t atto_counter_assert_passes;
  * Verifies that the floating point value is positive infinity.
  *
  * Otherwise stops the test case and reports on standard output.
+ * The value is evaluated only once and classified in its own type: only
+ * infinity exceeds the largest `long double`, so a `long double` too large
+ * for a `double` is still finite.
  *
  * Example:
  * ```
@@ -377,12 +463,14 @@ extern size_t atto_counter_assert_passes;
  * atto_plusinf(1);          // Fails
  * ```
  */
-#define atto_plusinf(value) atto_assert((isinf(value)) && ((value) > 0))
+#define atto_plusinf(value) atto_assert((value) > LDBL_MAX)
 
 /**
  * Verifies that the floating point value is negative infinity.
  *
  * Otherwise stops the test case and reports on standard output.
+ * The value is evaluated only once and classified in its own type, as for
+ * atto_plusinf().
  *
  * Example:
  * ```
@@ -393,7 +481,7 @@ extern size_t atto_counter_assert_passes;
  * atto_minusinf(1);          // Fails
  * ```
  */
-#define atto_minusinf(value) atto_assert((isinf(value)) && ((value) < 0))
+#define atto_minusinf(value) atto_assert((value) < -LDBL_MAX)
 
 /**
  * Verifies that the floating point value is finite, thus not NaN or
@@ -573,6 +661,83 @@ extern size_t atto_counter_assert_passes;
  */
 #define atto_fail() atto_assert(0)
 
+/**
+ * Maximum amount of hook pairs that can be registered with atto_hook_add().
+ */
+#ifndef ATTO_MAX_HOOKS
+    #define ATTO_MAX_HOOKS (8U)
+#endif
+
+/**
+ * Signature of a test case: a function without arguments returning `void`,
+ * which is required by the early `return` of the assertions.
+ */
+typedef void (*atto_test_fn)(void);
+
+/**
+ * Signature of a function called before or after each test case launched
+ * with atto_run().
+ *
+ * @param test_name name of the test case, as passed to atto_run().
+ */
+typedef void (*atto_hook_fn)(const char* test_name);
+
+/**
+ * Name of the test case currently being executed by atto_run(), NULL
+ * outside of it.
+ *
+ * The user should not change this value, but may freely read it.
+ */
+extern const char* atto_current_test;
+
+/**
+ * Registers a pair of functions to be called before and after each test
+ * case launched with atto_run().
+ *
+ * The `before` hooks are called in registration order, the `after` hooks in
+ * reverse order, so pairs nest properly. The `after` hook is called also when
+ * the test case fails. Mostly useful to the optional Atto modules to do some
+ * per-test-case bookkeeping, but also for the user to set up fixtures.
+ *
+ * @param before called before each test case. May be NULL.
+ * @param after called after each test case. May be NULL.
+ * @return 0 on success, 1 if #ATTO_MAX_HOOKS pairs are already registered.
+ */
+int
+atto_hook_add(atto_hook_fn before, atto_hook_fn after);
+
+/**
+ * Executes a test case, calling the registered hooks around it.
+ *
+ * Prefer atto_run(), which provides the name automatically.
+ *
+ * @param test test case to execute. Not NULL.
+ * @param name name of the test case. Not NULL.
+ */
+void
+atto_run_test(atto_test_fn test, const char* name);
+
+/**
+ * Executes a test case, calling the hooks registered with atto_hook_add()
+ * around it.
+ *
+ * Calling the test case function directly is still fine: atto_run() is only
+ * needed when per-test-case features (hooks, reports of the optional modules)
+ * are used.
+ *
+ * Example:
+ * ```
+ * int main(void)
+ * {
+ *     atto_run(test_sqrt_valid_values);
+ *     atto_run(test_sqrt_negative_values);
+ *     atto_report();
+ *     return atto_at_least_one_fail;
+ * }
+ * ```
+ */
+#define atto_run(test) atto_run_test((test), #test)
+
 #ifdef __cplusplus
 }
 #endif
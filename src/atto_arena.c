@@ -0,0 +1,134 @@
+/**
+ * @file
+ * @internal
+ * Atto arena - per-test-case bump allocator with automatic reset and poisoning
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_arena.h"
+#include <stdint.h> /* For uintptr_t */
+
+/** Default backing memory, as a union to have a reasonable base alignment. */
+static union
+{
+    long double alignment_ld;
+    void* alignment_ptr;
+    unsigned char bytes[ATTO_ARENA_SIZE];
+} default_storage;
+
+static struct
+{
+    unsigned char* base;
+    size_t size;
+    size_t used;
+    size_t high_water;
+    const char* high_water_test;
+    size_t failed_allocations;
+    int hooked;
+} arena = {default_storage.bytes, ATTO_ARENA_SIZE, 0U, 0U, NULL, 0U, 0};
+
+static void
+arena_after_test(const char* const test_name)
+{
+    (void) test_name;
+    atto_arena_reset();
+}
+
+void*
+atto_alloc(const size_t size)
+{
+    if (!arena.hooked)
+    {
+        arena.hooked = atto_hook_add(NULL, arena_after_test) == 0;
+    }
+    const uintptr_t base = (uintptr_t) arena.base;
+    const uintptr_t aligned = (base + arena.used + (ATTO_ARENA_ALIGNMENT - 1U))
+                              & ~(uintptr_t) (ATTO_ARENA_ALIGNMENT - 1U);
+    const size_t start = (size_t) (aligned - base);
+    if (start > arena.size || size > arena.size - start)
+    {
+        arena.failed_allocations++;
+        return NULL;
+    }
+    arena.used = start + size;
+    if (arena.used > arena.high_water)
+    {
+        arena.high_water = arena.used;
+        arena.high_water_test = atto_current_test;
+    }
+    return arena.base + start;
+}
+
+void
+atto_arena_reset(void)
+{
+#if ATTO_ARENA_POISON
+    memset(arena.base, ATTO_ARENA_POISON_BYTE, arena.used);
+#endif
+    arena.used = 0U;
+}
+
+void
+atto_arena_use(void* const buffer, const size_t size)
+{
+    atto_arena_reset();
+    if (buffer == NULL)
+    {
+        arena.base = default_storage.bytes;
+        arena.size = ATTO_ARENA_SIZE;
+    }
+    else
+    {
+        arena.base = buffer;
+        arena.size = size;
+    }
+}
+
+size_t
+atto_arena_used(void)
+{
+    return arena.used;
+}
+
+size_t
+atto_arena_high_water(void)
+{
+    return arena.high_water;
+}
+
+void
+atto_arena_report(void)
+{
+    printf("ARENA | Size: %zu B | High-water mark: %zu B | Test case: %s"
+           " | Failed allocations: %zu\n",
+           arena.size,
+           arena.high_water,
+           arena.high_water_test == NULL ? "-" : arena.high_water_test,
+           arena.failed_allocations);
+}
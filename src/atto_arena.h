@@ -0,0 +1,154 @@
+/**
+ * @file
+ * Atto arena - per-test-case bump allocator with automatic reset and poisoning
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_ARENA_H
+#define ATTO_ARENA_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Size in bytes of the static memory backing the arena by default.
+ *
+ * Use atto_arena_use() to back the arena with a different buffer instead,
+ * e.g. a memory-mapped one.
+ */
+#ifndef ATTO_ARENA_SIZE
+    #define ATTO_ARENA_SIZE (1024U * 1024U)
+#endif
+
+/**
+ * Alignment in bytes of every allocation. Must be a power of 2.
+ */
+#ifndef ATTO_ARENA_ALIGNMENT
+    #define ATTO_ARENA_ALIGNMENT (16U)
+#endif
+
+/**
+ * Whether the released memory is overwritten with #ATTO_ARENA_POISON_BYTE
+ * (when 1) or not (when 0).
+ *
+ * Poisoning makes use-after-reset and reads of uninitialised memory visible
+ * as a recognisable pattern, at the cost of writing the memory used by each
+ * test case once more.
+ */
+#ifndef ATTO_ARENA_POISON
+    #define ATTO_ARENA_POISON (1)
+#endif
+
+/**
+ * Byte pattern written to released memory when #ATTO_ARENA_POISON is 1.
+ */
+#ifndef ATTO_ARENA_POISON_BYTE
+    #define ATTO_ARENA_POISON_BYTE (0xA5U)
+#endif
+
+/**
+ * Allocates memory from the arena, valid until the end of the current test
+ * case.
+ *
+ * Just a pointer bump: there is no need (and no way) to free single
+ * allocations. All of them are released at once when the test case launched
+ * with atto_run() ends, as the first call registers the reset with
+ * atto_hook_add(). Outside of atto_run() call atto_arena_reset() manually.
+ *
+ * Example:
+ * ```
+ * uint32_t* const table = atto_alloc(1000 * sizeof(uint32_t));
+ * atto_neq(table, NULL);
+ * ```
+ *
+ * @param size amount of bytes to allocate.
+ * @return memory aligned to #ATTO_ARENA_ALIGNMENT or NULL if the arena has
+ * not enough space left.
+ */
+void*
+atto_alloc(size_t size);
+
+/**
+ * Releases all allocations at once, poisoning the released memory if
+ * #ATTO_ARENA_POISON is 1.
+ */
+void
+atto_arena_reset(void);
+
+/**
+ * Backs the arena with the given buffer instead of the default static one.
+ *
+ * Releases all current allocations.
+ *
+ * @param buffer memory to allocate from, or NULL to use the default static
+ * buffer again.
+ * @param size size of \p buffer in bytes.
+ */
+void
+atto_arena_use(void* buffer, size_t size);
+
+/**
+ * Amount of bytes currently allocated from the arena, including padding.
+ *
+ * @return used bytes.
+ */
+size_t
+atto_arena_used(void);
+
+/**
+ * Largest amount of bytes ever allocated from the arena at once.
+ *
+ * Useful to size #ATTO_ARENA_SIZE for an embedded target.
+ *
+ * @return high-water mark in bytes.
+ */
+size_t
+atto_arena_high_water(void);
+
+/**
+ * Prints a brief report of the arena on standard output: its size, its
+ * high-water mark and the test case that reached it, and the amount of
+ * failed allocations.
+ *
+ * ```
+ * ARENA | Size: 1048576 B | High-water mark: 81936 B | Test case: test_big_tree | Failed allocations: 0
+ * ```
+ */
+void
+atto_arena_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_ARENA_H */
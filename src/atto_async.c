@@ -0,0 +1,336 @@
+/**
+ * @file
+ * @internal
+ * Atto async - cooperative execution of I/O-bound test cases as coroutines
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE /* For ucontext, MAP_ANONYMOUS, MAP_STACK */
+#endif
+
+#include "atto_async.h"
+#include "atto_vclock.h"
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/** Amount of ready file descriptors fetched at once from the event loop. */
+#define ASYNC_MAX_EVENTS (64)
+
+typedef enum
+{
+    TASK_READY,
+    TASK_WAITING_FD,
+    TASK_SLEEPING,
+    TASK_DONE,
+} task_state_t;
+
+typedef struct
+{
+    ucontext_t context;
+    atto_test_fn test;
+    const char* name;
+    task_state_t state;
+    uint64_t wake_ns;
+    int fd;
+} async_task_t;
+
+static async_task_t tasks[ATTO_ASYNC_MAX_TASKS];
+static unsigned char* stacks[ATTO_ASYNC_MAX_TASKS];  // Kept mapped across runs
+static size_t tasks_amount = 0U;
+static size_t tasks_alive = 0U;
+static int running = 0;
+static async_task_t* current_task = NULL;
+static ucontext_t scheduler_context;
+static int epoll_fd = -1;
+
+static void
+task_entry(void)
+{
+    current_task->test();
+    current_task->state = TASK_DONE;
+    // Returning resumes the scheduler through uc_link
+}
+
+/** Prepares the coroutine of a task, with a guard page below its stack. */
+static int
+task_init(const size_t idx)
+{
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    async_task_t* const task = &tasks[idx];
+
+    if (stacks[idx] == NULL)
+    {
+        void* const mapping = mmap(NULL,
+                                   ATTO_ASYNC_STACK_SIZE + page,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+                                   -1,
+                                   0);
+        if (mapping == MAP_FAILED)
+        {
+            return 1;
+        }
+        mprotect(mapping, page, PROT_NONE);  // Stack overflows fault immediately
+        stacks[idx] = mapping;
+    }
+    if (getcontext(&task->context) != 0)
+    {
+        return 1;
+    }
+    task->context.uc_stack.ss_sp = stacks[idx] + page;
+    task->context.uc_stack.ss_size = ATTO_ASYNC_STACK_SIZE;
+    task->context.uc_link = &scheduler_context;
+    makecontext(&task->context, task_entry, 0);
+    task->state = TASK_READY;
+    task->fd = -1;
+    task->wake_ns = 0U;
+    return 0;
+}
+
+int
+atto_async_spawn(const atto_test_fn test, const char* const name)
+{
+    if (tasks_amount >= ATTO_ASYNC_MAX_TASKS)
+    {
+        return 1;
+    }
+    tasks[tasks_amount].test = test;
+    tasks[tasks_amount].name = name;
+    if (running)
+    {
+        // Spawned by a running test case: the loop may resume it right away
+        if (task_init(tasks_amount) != 0)
+        {
+            return 1;
+        }
+        tasks_alive++;
+    }
+    tasks_amount++;
+    return 0;
+}
+
+static void
+task_resume(async_task_t* const task)
+{
+    current_task = task;
+    atto_current_test = task->name;
+    swapcontext(&scheduler_context, &task->context);
+    current_task = NULL;
+    atto_current_test = NULL;
+}
+
+static void
+task_suspend(void)
+{
+    swapcontext(&current_task->context, &scheduler_context);
+}
+
+/** Sleeps on the virtual clock suspend only the calling coroutine. */
+static int
+task_vclock_sleeper(const uint64_t duration_ns)
+{
+    if (current_task == NULL)
+    {
+        return 0;
+    }
+    atto_async_sleep_ns(duration_ns);
+    return 1;
+}
+
+/** Wake-up time of the earliest sleeping task, UINT64_MAX for none. */
+static uint64_t
+earliest_wake_ns(void)
+{
+    uint64_t earliest = UINT64_MAX;
+
+    for (size_t i = 0U; i < tasks_amount; i++)
+    {
+        if (tasks[i].state == TASK_SLEEPING && tasks[i].wake_ns < earliest)
+        {
+            earliest = tasks[i].wake_ns;
+        }
+    }
+    return earliest;
+}
+
+/** Milliseconds until the earliest sleeping task wakes up, -1 for none. */
+static int
+earliest_wake_timeout_ms(const uint64_t now)
+{
+    const uint64_t earliest = earliest_wake_ns();
+
+    if (earliest == UINT64_MAX)
+    {
+        return -1;
+    }
+    if (earliest <= now || atto_vclock_is_enabled())
+    {
+        return 0;  // With virtual time, never wait for a sleep to expire
+    }
+    const uint64_t timeout_ms = (earliest - now + 999999U) / 1000000U;
+    return timeout_ms > INT_MAX ? INT_MAX : (int) timeout_ms;
+}
+
+int
+atto_async_run(void)
+{
+    struct epoll_event events[ASYNC_MAX_EVENTS];
+
+    if (epoll_fd < 0)
+    {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0)
+        {
+            return 1;
+        }
+    }
+    for (size_t i = 0U; i < tasks_amount; i++)
+    {
+        if (task_init(i) != 0)
+        {
+            tasks_amount = 0U;
+            return 1;
+        }
+    }
+    atto_vclock_set_sleeper(task_vclock_sleeper);
+    tasks_alive = tasks_amount;
+    running = 1;
+    while (tasks_alive > 0U)
+    {
+        int any_ready = 0;
+        for (size_t i = 0U; i < tasks_amount; i++)
+        {
+            if (tasks[i].state == TASK_READY)
+            {
+                task_resume(&tasks[i]);
+                if (tasks[i].state == TASK_DONE)
+                {
+                    tasks_alive--;
+                }
+                any_ready |= tasks[i].state == TASK_READY;  // It yielded
+            }
+        }
+        if (tasks_alive == 0U)
+        {
+            break;
+        }
+        const int timeout_ms = any_ready ? 0 : earliest_wake_timeout_ms(atto_vclock_now_ns());
+        const int ready_fds = epoll_wait(epoll_fd, events, ASYNC_MAX_EVENTS, timeout_ms);
+        if (ready_fds == 0 && !any_ready && atto_vclock_is_enabled())
+        {
+            // Every test case is blocked: jump to the earliest wake-up
+            const uint64_t now = atto_vclock_now_ns();
+            const uint64_t earliest = earliest_wake_ns();
+            if (earliest != UINT64_MAX && earliest > now)
+            {
+                atto_vclock_advance_ns(earliest - now);
+            }
+        }
+        for (int i = 0; i < ready_fds; i++)
+        {
+            async_task_t* const task = events[i].data.ptr;
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, task->fd, NULL);
+            task->fd = -1;
+            task->state = TASK_READY;
+        }
+        const uint64_t now = atto_vclock_now_ns();
+        for (size_t i = 0U; i < tasks_amount; i++)
+        {
+            if (tasks[i].state == TASK_SLEEPING && tasks[i].wake_ns <= now)
+            {
+                tasks[i].state = TASK_READY;
+            }
+        }
+    }
+    running = 0;
+    atto_vclock_set_sleeper(NULL);
+    tasks_amount = 0U;
+    return 0;
+}
+
+int
+atto_async_wait_fd(const int fd, const unsigned int events)
+{
+    const short poll_events = (short) (((events & ATTO_ASYNC_READ) ? POLLIN : 0)
+                                       | ((events & ATTO_ASYNC_WRITE) ? POLLOUT : 0));
+
+    if (current_task == NULL)
+    {
+        struct pollfd pollfd = {.fd = fd, .events = poll_events, .revents = 0};
+        int result;
+        do
+        {
+            result = poll(&pollfd, 1U, -1);
+        }
+        while (result < 0 && errno == EINTR);
+        return result > 0 ? 0 : -1;
+    }
+    struct epoll_event event = {
+        .events = (uint32_t) (((events & ATTO_ASYNC_READ) ? EPOLLIN : 0U)
+                              | ((events & ATTO_ASYNC_WRITE) ? EPOLLOUT : 0U)),
+        .data.ptr = current_task,
+    };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        return -1;
+    }
+    current_task->fd = fd;
+    current_task->state = TASK_WAITING_FD;
+    task_suspend();
+    return 0;
+}
+
+void
+atto_async_sleep_ns(const uint64_t duration_ns)
+{
+    if (current_task == NULL)
+    {
+        atto_vclock_sleep_ns(duration_ns);
+        return;
+    }
+    current_task->wake_ns = atto_vclock_now_ns() + duration_ns;
+    current_task->state = TASK_SLEEPING;
+    task_suspend();
+}
+
+void
+atto_async_yield(void)
+{
+    if (current_task != NULL)
+    {
+        current_task->state = TASK_READY;
+        task_suspend();
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * @file
+ * Atto async - cooperative execution of I/O-bound test cases as coroutines
+ *
+ * Requires Linux (`epoll`, `ucontext`) and the Atto vclock module.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_ASYNC_H
+#define ATTO_ASYNC_H
+
+#include "atto.h"
+#include <stdint.h> /* For uint64_t */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of test cases that can be spawned before atto_async_run().
+ */
+#ifndef ATTO_ASYNC_MAX_TASKS
+    #define ATTO_ASYNC_MAX_TASKS (256U)
+#endif
+
+/**
+ * Size of the stack of each coroutine in bytes, excluding its guard page.
+ *
+ * The stacks are mapped with `mmap()` once and reused, so only the touched
+ * pages use actual memory.
+ */
+#ifndef ATTO_ASYNC_STACK_SIZE
+    #define ATTO_ASYNC_STACK_SIZE (64U * 1024U)
+#endif
+
+/**
+ * Event flag for atto_async_wait_fd(): wait until the file descriptor is
+ * readable.
+ */
+#define ATTO_ASYNC_READ (1U)
+
+/**
+ * Event flag for atto_async_wait_fd(): wait until the file descriptor is
+ * writable.
+ */
+#define ATTO_ASYNC_WRITE (2U)
+
+/**
+ * Schedules a test case to be executed as a coroutine by atto_async_run().
+ *
+ * Prefer atto_async(), which provides the name automatically.
+ *
+ * Can also be called by a test case running in atto_async_run(), which then
+ * executes the spawned one too before returning.
+ *
+ * @param test test case to execute. Not NULL.
+ * @param name name of the test case. Not NULL.
+ * @return 0 on success, 1 if #ATTO_ASYNC_MAX_TASKS test cases are already
+ * scheduled or, when called by a running test case, its stack could not be
+ * allocated.
+ */
+int
+atto_async_spawn(atto_test_fn test, const char* name);
+
+/**
+ * Schedules a test case to be executed as a coroutine by atto_async_run().
+ *
+ * The test case is a normal Atto test case: a failing assertion stops it
+ * early as usual and updates the usual counters. Instead of blocking, it
+ * should wait with atto_async_wait_fd() and atto_async_sleep_ns(), so the
+ * other test cases can run in the meantime.
+ *
+ * Example:
+ * ```
+ * atto_async(test_client_reconnects);
+ * atto_async(test_server_timeout);
+ * atto_async_run();  // Both overlap their waits on one thread
+ * ```
+ */
+#define atto_async(test) atto_async_spawn((test), #test)
+
+/**
+ * Executes all scheduled test cases until each of them returns.
+ *
+ * Each test case is a stackful coroutine. When it waits on a file
+ * descriptor or sleeps, the next ready test case is resumed; when none is
+ * ready, the event loop sleeps in `epoll_wait()` until a file descriptor is
+ * ready or the earliest sleep expires. Hundreds of waiting test cases thus
+ * overlap their waits on one thread, without any locking.
+ *
+ * #atto_current_test is kept up to date at each switch. The hooks of
+ * atto_hook_add() are not called, as they expect test cases to run one after
+ * the other.
+ *
+ * @return 0 on success, 1 if the event loop or the stacks could not be
+ * created.
+ */
+int
+atto_async_run(void);
+
+/**
+ * Suspends the calling test case until the file descriptor is ready.
+ *
+ * When called outside of atto_async_run() it simply blocks with `poll()`.
+ * Only one test case at a time may wait on the same file descriptor.
+ *
+ * @param fd file descriptor to wait for.
+ * @param events #ATTO_ASYNC_READ, #ATTO_ASYNC_WRITE or both.
+ * @return 0 when ready, -1 if the file descriptor cannot be waited for.
+ */
+int
+atto_async_wait_fd(int fd, unsigned int events);
+
+/**
+ * Suspends the calling test case for at least the given duration.
+ *
+ * The duration is measured on the clock of atto_vclock_now_ns(). When the
+ * virtual time is enabled with atto_vclock_enable(), the clock jumps forward
+ * as soon as all test cases are blocked, so the sleep takes no real time.
+ * Sleeps through the virtual clock (e.g. an interposed `nanosleep()`) also
+ * suspend only the calling test case.
+ *
+ * When called outside of atto_async_run() it simply calls
+ * atto_vclock_sleep_ns().
+ *
+ * @param duration_ns how long to sleep in nanoseconds.
+ */
+void
+atto_async_sleep_ns(uint64_t duration_ns);
+
+/**
+ * Lets the other ready test cases run before resuming the calling one.
+ *
+ * Does nothing when called outside of atto_async_run().
+ */
+void
+atto_async_yield(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_ASYNC_H */
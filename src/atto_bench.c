@@ -0,0 +1,326 @@
+/**
+ * @file
+ * @internal
+ * Atto bench - benchmark regression checks against a baseline file with a
+ * Mann-Whitney U test
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_bench.h"
+#include <stdlib.h> /* For qsort() */
+
+/** Baseline and new samples of one benchmark. */
+typedef struct
+{
+    char name[ATTO_BENCH_NAME_LEN + 1U];
+    size_t baseline_len;
+    uint64_t baseline[ATTO_BENCH_MAX_SAMPLES];
+    size_t samples_len;
+    uint64_t samples[ATTO_BENCH_MAX_SAMPLES];
+} bench_t;
+
+/** A sample and the set it belongs to, for ranking both sets together. */
+typedef struct
+{
+    uint64_t ns;
+    int is_new;
+} ranked_t;
+
+static bench_t benches[ATTO_BENCH_MAX_BENCHMARKS];
+static size_t benches_amount = 0U;
+static ranked_t ranked[2U * ATTO_BENCH_MAX_SAMPLES];
+static uint64_t sorted[ATTO_BENCH_MAX_SAMPLES];
+
+/** Outcome of the last comparison, printed on failure. */
+static struct
+{
+    char name[ATTO_BENCH_NAME_LEN + 1U];
+    int has_baseline;
+    double change_percent;
+    double p;
+} last;
+
+/** Copies a name, truncating it to the maximum length. */
+static void
+copy_name(char* const destination, const char* const name)
+{
+    size_t len = 0U;
+    for (; len < ATTO_BENCH_NAME_LEN && name[len] != '\0'; len++) { destination[len] = name[len]; }
+    destination[len] = '\0';
+}
+
+/** Benchmark with the given name, added if missing, or NULL if full. */
+static bench_t*
+find_bench(const char* const name)
+{
+    char truncated[ATTO_BENCH_NAME_LEN + 1U];
+    copy_name(truncated, name);
+    for (size_t i = 0U; i < benches_amount; i++)
+    {
+        if (strcmp(benches[i].name, truncated) == 0)
+        {
+            return &benches[i];
+        }
+    }
+    if (benches_amount >= ATTO_BENCH_MAX_BENCHMARKS)
+    {
+        return NULL;
+    }
+    bench_t* const bench = &benches[benches_amount++];
+    copy_name(bench->name, truncated);
+    bench->baseline_len = 0U;
+    bench->samples_len = 0U;
+    return bench;
+}
+
+static int
+compare_ns(const void* const a, const void* const b)
+{
+    const uint64_t x = *(const uint64_t*) a;
+    const uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+static int
+compare_ranked(const void* const a, const void* const b)
+{
+    return compare_ns(&((const ranked_t*) a)->ns, &((const ranked_t*) b)->ns);
+}
+
+/** Median of the samples, which are not modified. */
+static double
+median(const uint64_t* const samples, const size_t len)
+{
+    memcpy(sorted, samples, len * sizeof(samples[0]));
+    qsort(sorted, len, sizeof(sorted[0]), compare_ns);
+    if (len % 2U == 1U)
+    {
+        return (double) sorted[len / 2U];
+    }
+    return ((double) sorted[len / 2U - 1U] + (double) sorted[len / 2U]) / 2.0;
+}
+
+int
+atto_bench_load(const char* const path)
+{
+    FILE* const file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return 1;
+    }
+    char name[256];
+    size_t len = 0U;
+    int error = 0;
+    while (!error && fscanf(file, "%255s %zu", name, &len) == 2)
+    {
+        bench_t* const bench = find_bench(name);
+        for (size_t i = 0U; !error && i < len; i++)
+        {
+            unsigned long long ns = 0U;
+            error = fscanf(file, "%llu", &ns) != 1;
+            if (bench != NULL && i < ATTO_BENCH_MAX_SAMPLES)
+            {
+                bench->baseline[i] = (uint64_t) ns;
+            }
+        }
+        if (bench != NULL)
+        {
+            bench->baseline_len = len < ATTO_BENCH_MAX_SAMPLES ? len : ATTO_BENCH_MAX_SAMPLES;
+        }
+    }
+    error |= !feof(file);
+    fclose(file);
+    return error;
+}
+
+int
+atto_bench_save(const char* const path)
+{
+    // Written aside and renamed over it, so a crash or full disk keeps the old one
+    char temp_path[FILENAME_MAX];
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int) sizeof(temp_path))
+    {
+        return 1;
+    }
+    FILE* const file = fopen(temp_path, "w");
+    if (file == NULL)
+    {
+        return 1;
+    }
+    int error = 0;
+    for (size_t i = 0U; i < benches_amount; i++)
+    {
+        const bench_t* const bench = &benches[i];
+        const int has_samples = bench->samples_len > 0U;
+        const uint64_t* const samples = has_samples ? bench->samples : bench->baseline;
+        const size_t len = has_samples ? bench->samples_len : bench->baseline_len;
+        error |= fprintf(file, "%s %zu", bench->name, len) < 0;
+        for (size_t s = 0U; s < len; s++)
+        {
+            error |= fprintf(file, " %llu", (unsigned long long) samples[s]) < 0;
+        }
+        error |= fprintf(file, "\n") < 0;
+    }
+    error |= fclose(file) != 0;
+    if (!error && rename(temp_path, path) != 0)
+    {
+        // Windows does not rename over an existing file
+        remove(path);
+        error = rename(temp_path, path) != 0;
+    }
+    if (error)
+    {
+        remove(temp_path);
+    }
+    return error;
+}
+
+void
+atto_bench_clear(void)
+{
+    benches_amount = 0U;
+}
+
+double
+atto_bench_p_slower(const uint64_t* const baseline,
+                    size_t baseline_len,
+                    const uint64_t* const samples,
+                    size_t samples_len)
+{
+    baseline_len = baseline_len < ATTO_BENCH_MAX_SAMPLES ? baseline_len : ATTO_BENCH_MAX_SAMPLES;
+    samples_len = samples_len < ATTO_BENCH_MAX_SAMPLES ? samples_len : ATTO_BENCH_MAX_SAMPLES;
+    if (baseline_len == 0U || samples_len == 0U)
+    {
+        return 1.0;
+    }
+    const size_t total = baseline_len + samples_len;
+    for (size_t i = 0U; i < baseline_len; i++)
+    {
+        ranked[i].ns = baseline[i];
+        ranked[i].is_new = 0;
+    }
+    for (size_t i = 0U; i < samples_len; i++)
+    {
+        ranked[baseline_len + i].ns = samples[i];
+        ranked[baseline_len + i].is_new = 1;
+    }
+    qsort(ranked, total, sizeof(ranked[0]), compare_ranked);
+
+    // Rank sum of the new samples, ties getting their average rank
+    double rank_sum = 0.0;
+    double ties_correction = 0.0;
+    for (size_t first = 0U; first < total;)
+    {
+        size_t end = first + 1U;
+        while (end < total && ranked[end].ns == ranked[first].ns) { end++; }
+        const double average_rank = ((double) first + 1.0 + (double) end) / 2.0;
+        const double tied = (double) (end - first);
+        ties_correction += tied * tied * tied - tied;
+        for (size_t i = first; i < end; i++)
+        {
+            rank_sum += ranked[i].is_new ? average_rank : 0.0;
+        }
+        first = end;
+    }
+    const double n1 = (double) samples_len;
+    const double n2 = (double) baseline_len;
+    const double n = n1 + n2;
+    const double u = rank_sum - n1 * (n1 + 1.0) / 2.0;
+    const double mean = n1 * n2 / 2.0;
+    const double variance = n1 * n2 / 12.0 * ((n + 1.0) - ties_correction / (n * (n - 1.0)));
+    if (variance <= 0.0)
+    {
+        return 1.0;  // All samples identical
+    }
+    const double z = (u - mean - 0.5) / sqrt(variance);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+/** Prints the p-value, coarsely when very small as it is only approximate. */
+static void
+print_p_value(const double p)
+{
+    if (p < 0.001)
+    {
+        printf("p<0.001");
+    }
+    else if (p < 0.01)
+    {
+        printf("p<0.01");
+    }
+    else
+    {
+        printf("p=%.3f", p);
+    }
+}
+
+int
+atto_bench_regressed(const char* const name,
+                     const uint64_t* const samples,
+                     size_t samples_len,
+                     const double max_slowdown_percent)
+{
+    samples_len = samples_len < ATTO_BENCH_MAX_SAMPLES ? samples_len : ATTO_BENCH_MAX_SAMPLES;
+    const double new_median = samples_len == 0U ? 0.0 : median(samples, samples_len);
+    bench_t* const bench = find_bench(name);
+    copy_name(last.name, name);
+    last.has_baseline = bench != NULL && bench->baseline_len > 0U;
+    last.change_percent = 0.0;
+    last.p = 1.0;
+    printf("BENCH | %s | Samples: %zu | Median: %.0f ns", last.name, samples_len, new_median);
+    if (last.has_baseline)
+    {
+        const double baseline_median = median(bench->baseline, bench->baseline_len);
+        last.change_percent = baseline_median > 0.0
+                                  ? (new_median / baseline_median - 1.0) * 100.0
+                                  : 0.0;
+        last.p = atto_bench_p_slower(bench->baseline, bench->baseline_len, samples, samples_len);
+        printf(" | Baseline: %.0f ns | Change: %+.1f%% | ", baseline_median, last.change_percent);
+        print_p_value(last.p);
+        printf("\n");
+    }
+    else
+    {
+        printf(" | No baseline\n");
+    }
+    if (bench != NULL)
+    {
+        memcpy(bench->samples, samples, samples_len * sizeof(samples[0]));
+        bench->samples_len = samples_len;
+    }
+    return last.has_baseline && last.p < ATTO_BENCH_ALPHA
+           && last.change_percent > max_slowdown_percent;
+}
+
+void
+atto_bench_print_last(void)
+{
+    printf(" | atto_bench %s: %+.1f%% slower, ", last.name, last.change_percent);
+    print_p_value(last.p);
+}
@@ -0,0 +1,235 @@
+/**
+ * @file
+ * Atto bench - benchmark regression checks against a baseline file with a
+ * Mann-Whitney U test
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_BENCH_H
+#define ATTO_BENCH_H
+
+#include "atto.h"
+#include "atto_time.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of timing samples per benchmark. Extra samples are ignored.
+ */
+#ifndef ATTO_BENCH_MAX_SAMPLES
+    #define ATTO_BENCH_MAX_SAMPLES (256U)
+#endif
+
+/**
+ * Maximum amount of distinct benchmarks in a baseline file.
+ */
+#ifndef ATTO_BENCH_MAX_BENCHMARKS
+    #define ATTO_BENCH_MAX_BENCHMARKS (32U)
+#endif
+
+/**
+ * Maximum length of a benchmark name, without the null terminator.
+ * Longer names are truncated.
+ */
+#ifndef ATTO_BENCH_NAME_LEN
+    #define ATTO_BENCH_NAME_LEN (47U)
+#endif
+
+/**
+ * Significance level: a slowdown is a regression only if the probability of
+ * observing it by chance (the p-value) is below this value.
+ */
+#ifndef ATTO_BENCH_ALPHA
+    #define ATTO_BENCH_ALPHA (0.01)
+#endif
+
+/**
+ * Amount of untimed executions of the benchmarked body before the samples,
+ * to warm up caches and branch predictors.
+ */
+#ifndef ATTO_BENCH_WARMUP
+    #define ATTO_BENCH_WARMUP (3U)
+#endif
+
+/**
+ * Loads the baseline samples of all benchmarks from a text file.
+ *
+ * A missing file is not an error for the benchmarks: without a baseline they
+ * just record their samples and pass.
+ *
+ * @param path baseline file, as written by atto_bench_save(). Not NULL.
+ * @return 0 if the file was loaded, 1 if it could not be read or is invalid.
+ */
+int
+atto_bench_load(const char* path);
+
+/**
+ * Saves the samples of all benchmarks into a text file, to be the baseline of
+ * the next runs.
+ *
+ * Benchmarks which did not run keep their loaded baseline samples.
+ * One line per benchmark: its name, the amount of samples and the samples in
+ * nanoseconds, separated by spaces.
+ *
+ * The file is written under the same path with a `.tmp` suffix first, then
+ * renamed over the old one, so a crash or a full disk while saving leaves
+ * the old baseline intact.
+ *
+ * @param path baseline file to overwrite. Not NULL.
+ * @return 0 on success, 1 if the file could not be written.
+ */
+int
+atto_bench_save(const char* path);
+
+/**
+ * Forgets all baseline and recorded samples.
+ */
+void
+atto_bench_clear(void);
+
+/**
+ * One-sided p-value of the Mann-Whitney U test that the samples are
+ * stochastically greater (slower) than the baseline samples.
+ *
+ * Non-parametric, so it does not assume normally distributed timings and is
+ * robust to outliers. Uses the normal approximation with tie and continuity
+ * corrections, good for at least about 10 samples per set.
+ *
+ * @param baseline baseline samples. Not NULL.
+ * @param baseline_len amount of baseline samples in
+ * [1, #ATTO_BENCH_MAX_SAMPLES].
+ * @param samples new samples. Not NULL.
+ * @param samples_len amount of new samples in [1, #ATTO_BENCH_MAX_SAMPLES].
+ * @return p-value in [0, 1], 1 if either set is empty.
+ */
+double
+atto_bench_p_slower(const uint64_t* baseline,
+                    size_t baseline_len,
+                    const uint64_t* samples,
+                    size_t samples_len);
+
+/**
+ * Compares the samples of a benchmark against its baseline, records them
+ * for atto_bench_save() and prints a `BENCH` line with the outcome.
+ *
+ * ```
+ * BENCH | parse_header | Samples: 100 | Median: 1380 ns | Baseline: 1228 ns
+ *       | Change: +12.4% | p<0.01
+ * ```
+ *
+ * @param name name of the benchmark, without spaces. Not NULL.
+ * @param samples timing samples in nanoseconds. Not NULL.
+ * @param samples_len amount of samples.
+ * @param max_slowdown_percent largest tolerated slowdown of the median, in
+ * percent.
+ * @return 1 if the median is slower than the baseline by more than
+ * \p max_slowdown_percent and the difference is statistically significant
+ * (p-value below #ATTO_BENCH_ALPHA), otherwise 0, also without a baseline.
+ */
+int
+atto_bench_regressed(const char* name,
+                     const uint64_t* samples,
+                     size_t samples_len,
+                     double max_slowdown_percent);
+
+/**
+ * Prints the outcome of the last atto_bench_regressed() call on the current
+ * line of the standard output, without terminating the line.
+ *
+ * Format: `| atto_bench parse_header: +12.4% slower, p<0.01`
+ */
+void
+atto_bench_print_last(void);
+
+/**
+ * Verifies that already collected timing samples are not a significant
+ * regression of more than the given percentage compared to the baseline.
+ *
+ * Otherwise stops the test case and reports on standard output, including
+ * the slowdown and the p-value on the `FAIL` line.
+ *
+ * Example:
+ * ```
+ * atto_bench_samples("parse_header", samples_ns, 100U, 5.0);
+ * // FAIL | File: test.c:42 | Test case: test_parser
+ * //      | atto_bench parse_header: +12.4% slower, p<0.01
+ * ```
+ */
+#define atto_bench_samples(name, samples, samples_len, max_slowdown_percent)             \
+    atto_assert_details(                                                                 \
+        !atto_bench_regressed((name), (samples), (samples_len), (max_slowdown_percent)), \
+        atto_bench_print_last())
+
+/**
+ * Times a body of code multiple times and verifies that it is not a
+ * significant regression of more than the given percentage compared to the
+ * baseline.
+ *
+ * The body is the last argument and may contain commas. It is executed
+ * #ATTO_BENCH_WARMUP times untimed, then timed once per sample with
+ * atto_time_ns(), so it should take at least a few microseconds: loop inside
+ * it for shorter operations. Without a baseline the benchmark just records
+ * its samples and passes.
+ *
+ * Example:
+ * ```
+ * atto_bench_load("atto_bench.txt");
+ * atto_bench("parse_header", 100U, 5.0, for (int i = 0; i < 1000; i++) { parse_header(data); });
+ * atto_bench_save("atto_bench.txt");
+ * ```
+ */
+#define atto_bench(name, samples, max_slowdown_percent, ...)                                   \
+    do                                                                                         \
+    {                                                                                          \
+        static uint64_t atto_bench_ns[ATTO_BENCH_MAX_SAMPLES];                                 \
+        const size_t atto_bench_len = (size_t) (samples) < ATTO_BENCH_MAX_SAMPLES              \
+                                          ? (size_t) (samples)                                 \
+                                          : ATTO_BENCH_MAX_SAMPLES;                            \
+        for (size_t atto_bench_idx = 0U; atto_bench_idx < ATTO_BENCH_WARMUP; atto_bench_idx++) \
+        {                                                                                      \
+            __VA_ARGS__;                                                                       \
+        }                                                                                      \
+        for (size_t atto_bench_idx = 0U; atto_bench_idx < atto_bench_len; atto_bench_idx++)    \
+        {                                                                                      \
+            const uint64_t atto_bench_start = atto_time_ns();                                  \
+            __VA_ARGS__;                                                                       \
+            atto_bench_ns[atto_bench_idx] = atto_time_ns() - atto_bench_start;                 \
+        }                                                                                      \
+        atto_bench_samples((name), atto_bench_ns, atto_bench_len, (max_slowdown_percent));     \
+    }                                                                                          \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_BENCH_H */
@@ -0,0 +1,157 @@
+/**
+ * @file
+ * @internal
+ * Atto check - level-gated and sampled invariant checks for production builds
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_check.h"
+
+#if (ATTO_CHECK_RING_SIZE & (ATTO_CHECK_RING_SIZE - 1U)) != 0U || ATTO_CHECK_RING_SIZE < 2U
+    #error "ATTO_CHECK_RING_SIZE must be a power of 2, at least 2"
+#endif
+
+/**
+ * One queued failure, in a bounded multi-producer queue in the style of
+ * D. Vyukov. The sequence is the lap of the ring the slot is free for, plus 1
+ * once filled, so the zero-initialised ring is empty.
+ */
+typedef struct
+{
+    atomic_size_t sequence;
+    const char* file;
+    int line;
+    const char* expression;
+    unsigned int level;
+} check_slot_t;
+
+atomic_uint atto_check_threshold = ATTO_LEVEL_PARANOID;
+
+static check_slot_t ring[ATTO_CHECK_RING_SIZE];
+static atomic_size_t enqueue_position = 0U;
+static size_t dequeue_position = 0U;
+static atomic_size_t dropped = 0U;
+static atomic_size_t failures = 0U;
+
+/** First position of the lap of the ring the position belongs to. */
+static size_t
+lap_of(const size_t position)
+{
+    return position & ~(size_t) (ATTO_CHECK_RING_SIZE - 1U);
+}
+
+void
+atto_check_set_threshold(const unsigned int level)
+{
+    atomic_store_explicit(&atto_check_threshold, level, memory_order_relaxed);
+}
+
+void
+atto_check_fail(const char* const file,
+                const int line,
+                const char* const expression,
+                const unsigned int level)
+{
+    atomic_fetch_add_explicit(&failures, 1U, memory_order_relaxed);
+    size_t position = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+    for (;;)
+    {
+        check_slot_t* const slot = &ring[position & (ATTO_CHECK_RING_SIZE - 1U)];
+        const size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence == lap_of(position))
+        {
+            if (atomic_compare_exchange_weak_explicit(&enqueue_position,
+                                                      &position,
+                                                      position + 1U,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                slot->file = file;
+                slot->line = line;
+                slot->expression = expression;
+                slot->level = level;
+                atomic_store_explicit(&slot->sequence, lap_of(position) + 1U, memory_order_release);
+                return;
+            }
+            // The position was updated by the failed exchange: try again
+        }
+        else if (sequence < lap_of(position))
+        {
+            atomic_fetch_add_explicit(&dropped, 1U, memory_order_relaxed);  // Ring is full
+            return;
+        }
+        else
+        {
+            position = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+        }
+    }
+}
+
+size_t
+atto_check_flush(void)
+{
+    size_t reported = 0U;
+    for (;;)
+    {
+        check_slot_t* const slot = &ring[dequeue_position & (ATTO_CHECK_RING_SIZE - 1U)];
+        const size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence != lap_of(dequeue_position) + 1U)
+        {
+            break;  // Empty, or the producer is still writing the slot
+        }
+        printf("FAIL | File: %s:%d | Check: %s | Level: %u\n",
+               slot->file,
+               slot->line,
+               slot->expression,
+               slot->level);
+        atomic_store_explicit(&slot->sequence,
+                              lap_of(dequeue_position) + ATTO_CHECK_RING_SIZE,
+                              memory_order_release);
+        dequeue_position++;
+        reported++;
+    }
+    const size_t lost = atomic_exchange_explicit(&dropped, 0U, memory_order_relaxed);
+    if (lost > 0U)
+    {
+        printf("CHECK | Dropped failures: %zu\n", lost);
+    }
+    reported += lost;
+    if (reported > 0U)
+    {
+        atto_counter_assert_failures += reported;
+        atto_at_least_one_fail = 1;
+    }
+    return reported;
+}
+
+size_t
+atto_check_failures(void)
+{
+    return atomic_load_explicit(&failures, memory_order_relaxed);
+}
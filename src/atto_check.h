@@ -0,0 +1,221 @@
+/**
+ * @file
+ * Atto check - level-gated and sampled invariant checks for production builds
+ *
+ * Requires C11 atomics and thread-local storage. Unlike the assertions of
+ * the core, the checks do not stop the function they are in nor print:
+ * failures are queued into a lock-free ring, to be reported later by a
+ * single thread, so the checks can stay compiled into soak-test and canary
+ * builds running under production load.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_CHECK_H
+#define ATTO_CHECK_H
+
+#include "atto.h"
+
+#if defined(__cplusplus) || !defined(__STDC_VERSION__) || __STDC_VERSION__ < 201112L
+    #error "Atto check requires C11"
+#endif
+
+#include <stdatomic.h> /* For atomic_uint */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of failures queued until the next atto_check_flush().
+ *
+ * Must be a power of 2, at least 2. Further failures are only counted as
+ * dropped.
+ */
+#ifndef ATTO_CHECK_RING_SIZE
+    #define ATTO_CHECK_RING_SIZE (256U)
+#endif
+
+/**
+ * Level of the costliest checks, e.g. walking a whole data structure, only
+ * worth running in the test suite.
+ */
+#define ATTO_LEVEL_PARANOID (0U)
+
+/**
+ * Level of the checks of debug builds.
+ */
+#define ATTO_LEVEL_DEBUG (1U)
+
+/**
+ * Level of the checks still worth running in long soak tests.
+ */
+#define ATTO_LEVEL_SOAK (2U)
+
+/**
+ * Level of the cheapest checks, kept even in canary builds under production
+ * load.
+ */
+#define ATTO_LEVEL_CANARY (3U)
+
+/**
+ * Checks with a level below this threshold are skipped.
+ *
+ * Defaults to #ATTO_LEVEL_PARANOID, running all checks. Change it at any
+ * time with atto_check_set_threshold(), e.g. to #ATTO_LEVEL_CANARY at the
+ * start of a canary build.
+ */
+extern atomic_uint atto_check_threshold;
+
+/**
+ * Skips the checks with a level below the given one from now on, in all
+ * threads.
+ *
+ * @param level new threshold, e.g. #ATTO_LEVEL_SOAK.
+ */
+void
+atto_check_set_threshold(unsigned int level);
+
+/**
+ * Queues a failure of a check, without blocking nor printing.
+ *
+ * Called by the check macros, rarely needed directly. Safe to call from
+ * multiple threads at the same time. When the ring is full, the failure is
+ * only counted as dropped.
+ *
+ * @param file source file of the check.
+ * @param line source line of the check.
+ * @param expression the checked expression, as text.
+ * @param level level of the check.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((cold))
+#endif
+void
+atto_check_fail(const char* file, int line, const char* expression, unsigned int level);
+
+/**
+ * Reports the queued failures of the checks on standard output and counts
+ * them as failed assertions of the core.
+ *
+ * One `FAIL` line per queued failure, followed by a `CHECK` line with the
+ * amount of dropped ones, if any:
+ *
+ * ```
+ * FAIL | File: cache.c:120 | Check: entry->refs > 0 | Level: 2
+ * CHECK | Dropped failures: 12
+ * ```
+ *
+ * Call it from a single thread at a time, e.g. periodically from a reporter
+ * thread or at the end of a test case.
+ *
+ * @return amount of failures reported, including the dropped ones.
+ */
+size_t
+atto_check_flush(void);
+
+/**
+ * Amount of failures of the checks since the start of the process,
+ * including the dropped ones and the ones not flushed yet.
+ *
+ * @return total failures.
+ */
+size_t
+atto_check_failures(void);
+
+/**
+ * True when checks of the given level are currently enabled.
+ *
+ * A relaxed atomic load, which is a plain load on mainstream CPUs, and a
+ * comparison: a single branch, always predicted right as the threshold
+ * rarely changes.
+ */
+#define ATTO_CHECK_ENABLED(level)                                                                 \
+    ((unsigned int) (level) >= atomic_load_explicit(&atto_check_threshold, memory_order_relaxed))
+
+/**
+ * Checks that the expression is true, when the level of the check is at
+ * least the threshold. Otherwise the expression is not even evaluated.
+ *
+ * A failure is queued with atto_check_fail() and the execution continues,
+ * so it can be used in any function, also returning a value.
+ *
+ * Example:
+ * ```
+ * atto_check(ATTO_LEVEL_CANARY, node->len <= NODE_CAPACITY);
+ * atto_check(ATTO_LEVEL_PARANOID, tree_is_balanced(tree));
+ * ```
+ */
+#define atto_check(level, x)                                  \
+    do                                                        \
+    {                                                         \
+        if (ATTO_CHECK_ENABLED(level) && !(x))                \
+        {                                                     \
+            atto_check_fail(__FILE__, __LINE__, #x, (level)); \
+        }                                                     \
+    }                                                         \
+    while (0)
+
+/**
+ * Checks that the expression is true only every `every_n`-th time this site
+ * is reached by each thread, starting from the first one, when the level of
+ * the check is at least the threshold.
+ *
+ * For hot paths where even a cheap check on each call costs too much. Each
+ * site has its own thread-local countdown, so there is no contention between
+ * threads.
+ *
+ * An `every_n` of 0 never checks, e.g. to disable sampling at run time; 1
+ * checks every time. `every_n` may be evaluated more than once.
+ *
+ * Example:
+ * ```
+ * atto_check_sampled(ATTO_LEVEL_SOAK, 1000, heap_is_valid(&heap));
+ * ```
+ */
+#define atto_check_sampled(level, every_n, x)                                             \
+    do                                                                                    \
+    {                                                                                     \
+        static _Thread_local unsigned int atto_check_countdown = 0U;                      \
+        if (ATTO_CHECK_ENABLED(level) && (every_n) != 0U && atto_check_countdown-- == 0U) \
+        {                                                                                 \
+            atto_check_countdown = (unsigned int) (every_n) - 1U;                         \
+            if (!(x))                                                                     \
+            {                                                                             \
+                atto_check_fail(__FILE__, __LINE__, #x, (level));                         \
+            }                                                                             \
+        }                                                                                 \
+    }                                                                                     \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_CHECK_H */
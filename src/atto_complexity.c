@@ -0,0 +1,182 @@
+/**
+ * @file
+ * @internal
+ * Atto complexity - empirical asymptotic complexity of a body of code
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_complexity.h"
+#include <math.h> /* For log2(), sqrt() */
+
+static const char* const class_names[ATTO_COMPLEXITY_CLASSES] = {
+    "O(1)", "O(log n)", "O(n)", "O(n log n)", "O(n^2)"};
+static const char* const curve_names[ATTO_COMPLEXITY_CLASSES] = {
+    "1", "log n", "n", "n log n", "n^2"};
+
+/** Value of the function of the complexity class at the input size. */
+static double
+class_function(const size_t complexity, const size_t n)
+{
+    const double x = (double) n;
+    const double log_x = log2(x < 2.0 ? 2.0 : x);
+    switch (complexity)
+    {
+        case ATTO_O_LOG_N:
+            return log_x;
+        case ATTO_O_N:
+            return x;
+        case ATTO_O_N_LOG_N:
+            return x * log_x;
+        case ATTO_O_N_SQUARED:
+            return x * x;
+        default:
+            return 1.0;
+    }
+}
+
+const char*
+atto_complexity_name(const atto_complexity_class_t complexity)
+{
+    return (size_t) complexity < ATTO_COMPLEXITY_CLASSES ? class_names[complexity] : "O(?)";
+}
+
+void
+atto_complexity_fit(atto_complexity_result_t* const result)
+{
+    result->best = ATTO_O_1;
+    for (size_t c = 0U; c < ATTO_COMPLEXITY_CLASSES; c++)
+    {
+        // Minimising sum((1 - k * f / t)^2) gives k = sum(f / t) / sum((f / t)^2)
+        double sum_ratio = 0.0;
+        double sum_ratio_squared = 0.0;
+        for (size_t i = 0U; i < result->points; i++)
+        {
+            const double ratio = class_function(c, result->n[i]) / result->ns[i];
+            sum_ratio += ratio;
+            sum_ratio_squared += ratio * ratio;
+        }
+        const double k = sum_ratio_squared > 0.0 ? sum_ratio / sum_ratio_squared : 0.0;
+        double sum_residuals_squared = 0.0;
+        for (size_t i = 0U; i < result->points; i++)
+        {
+            const double residual = 1.0 - k * class_function(c, result->n[i]) / result->ns[i];
+            sum_residuals_squared += residual * residual;
+        }
+        result->coefficient[c] = k;
+        result->error[c]
+            = result->points == 0U ? 0.0 : sqrt(sum_residuals_squared / (double) result->points);
+        if (result->error[c] < result->error[result->best])
+        {
+            result->best = (atto_complexity_class_t) c;
+        }
+    }
+}
+
+/** Fastest timing of the body at the input size, timed at least `repeats` times for `min_ns`. */
+static uint64_t
+fastest_ns(const atto_complexity_setup_fn setup,
+           const atto_complexity_body_fn body,
+           const size_t n,
+           const size_t repeats,
+           const uint64_t min_ns)
+{
+    const uint64_t started = atto_time_ns();
+    uint64_t fastest = UINT64_MAX;
+    for (size_t r = 0U; r < repeats || atto_time_ns() - started < min_ns; r++)
+    {
+        if (setup != NULL)
+        {
+            setup(n);
+        }
+        const uint64_t start = atto_time_ns();
+        body(n);
+        const uint64_t elapsed = atto_time_ns() - start;
+        fastest = elapsed < fastest ? elapsed : fastest;
+    }
+    return fastest;
+}
+
+void
+atto_complexity_measure(atto_complexity_result_t* const result,
+                        const atto_complexity_setup_fn setup,
+                        const atto_complexity_body_fn body,
+                        const size_t* const sizes,
+                        const size_t sizes_len)
+{
+    result->points = sizes_len < ATTO_COMPLEXITY_MAX_SIZES ? sizes_len : ATTO_COMPLEXITY_MAX_SIZES;
+    if (result->points > 0U)
+    {
+        // Warms up the caches and the CPU clock
+        (void) fastest_ns(setup, body, sizes[result->points - 1U], 1U, 0U);
+    }
+    for (size_t i = 0U; i < result->points; i++)
+    {
+        const uint64_t fastest
+            = fastest_ns(setup, body, sizes[i], ATTO_COMPLEXITY_REPEATS, ATTO_COMPLEXITY_MIN_NS);
+        result->n[i] = sizes[i];
+        result->ns[i] = fastest == 0U ? 1.0 : (double) fastest;  // Below the clock resolution
+    }
+    atto_complexity_fit(result);
+}
+
+/** Prints the relative residual of the fit of one class at each size. */
+static void
+print_residuals(const atto_complexity_result_t* const result, const size_t c)
+{
+    printf(" | Residuals of %s:", class_names[c]);
+    for (size_t i = 0U; i < result->points; i++)
+    {
+        const double fitted = result->coefficient[c] * class_function(c, result->n[i]);
+        printf("%s %zu: %+.1f%%",
+               i == 0U ? "" : ",",
+               result->n[i],
+               100.0 * (result->ns[i] - fitted) / result->ns[i]);
+    }
+}
+
+void
+atto_complexity_print(const atto_complexity_result_t* const result,
+                      const atto_complexity_class_t expected)
+{
+    const size_t best = (size_t) result->best;
+    printf(" | Best: %s | Expected: %s | Fit: %.3g * %s ns | Errors:",
+           class_names[best],
+           atto_complexity_name(expected),
+           result->coefficient[best],
+           curve_names[best]);
+    for (size_t c = 0U; c < ATTO_COMPLEXITY_CLASSES; c++)
+    {
+        printf("%s %s %.1f%%", c == 0U ? "" : ",", class_names[c], 100.0 * result->error[c]);
+    }
+    print_residuals(result, best);
+    if ((size_t) expected != best && (size_t) expected < ATTO_COMPLEXITY_CLASSES)
+    {
+        print_residuals(result, (size_t) expected);
+    }
+}
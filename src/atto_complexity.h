@@ -0,0 +1,219 @@
+/**
+ * @file
+ * Atto complexity - empirical asymptotic complexity of a body of code
+ *
+ * Times the code at increasing input sizes and fits the timings against the
+ * common complexity classes, to catch a change from O(n log n) to O(n^2)
+ * that no unit test with small inputs would notice.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_COMPLEXITY_H
+#define ATTO_COMPLEXITY_H
+
+#include "atto.h"
+#include "atto_time.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of input sizes of a measurement. Extra sizes are ignored.
+ */
+#ifndef ATTO_COMPLEXITY_MAX_SIZES
+    #define ATTO_COMPLEXITY_MAX_SIZES (32U)
+#endif
+
+/**
+ * Minimum amount of timed executions per input size, of which the fastest is
+ * kept, as it is the one least disturbed by the rest of the system.
+ */
+#ifndef ATTO_COMPLEXITY_REPEATS
+    #define ATTO_COMPLEXITY_REPEATS (5U)
+#endif
+
+/**
+ * Minimum time in nanoseconds spent timing each input size: fast bodies are
+ * executed more than #ATTO_COMPLEXITY_REPEATS times, until reaching it, so
+ * their fastest timing is as reliable as the one of slow bodies.
+ */
+#ifndef ATTO_COMPLEXITY_MIN_NS
+    #define ATTO_COMPLEXITY_MIN_NS (ATTO_MS(2))
+#endif
+
+/**
+ * Complexity classes, from the best to the worst.
+ */
+typedef enum
+{
+    ATTO_O_1,         /**< Constant: O(1). */
+    ATTO_O_LOG_N,     /**< Logarithmic: O(log n). */
+    ATTO_O_N,         /**< Linear: O(n). */
+    ATTO_O_N_LOG_N,   /**< Linearithmic: O(n log n). */
+    ATTO_O_N_SQUARED, /**< Quadratic: O(n^2). */
+} atto_complexity_class_t;
+
+/**
+ * Amount of complexity classes the timings are fitted against.
+ */
+#define ATTO_COMPLEXITY_CLASSES (5U)
+
+/**
+ * Prepares the input of size `n` for the body, outside of the measured time.
+ *
+ * Called before each timed execution, so the body may consume its input,
+ * e.g. sort it in place.
+ *
+ * @param n input size.
+ */
+typedef void (*atto_complexity_setup_fn)(size_t n);
+
+/**
+ * Code under test, working on the input of size `n` prepared by the setup.
+ *
+ * @param n input size.
+ */
+typedef void (*atto_complexity_body_fn)(size_t n);
+
+/**
+ * Timings at each input size and their fit against each complexity class.
+ */
+typedef struct
+{
+    size_t points;                               /**< Amount of input sizes. */
+    size_t n[ATTO_COMPLEXITY_MAX_SIZES];         /**< Input sizes. */
+    double ns[ATTO_COMPLEXITY_MAX_SIZES];        /**< Fastest timing per size. */
+    double coefficient[ATTO_COMPLEXITY_CLASSES]; /**< Fitted `c` of `c * f(n)`. */
+    double error[ATTO_COMPLEXITY_CLASSES];       /**< RMS relative residual. */
+    atto_complexity_class_t best;                /**< Class with the smallest error. */
+} atto_complexity_result_t;
+
+/**
+ * Name of a complexity class, e.g. "O(n log n)".
+ *
+ * @param complexity class to name.
+ * @return the name, never NULL.
+ */
+const char*
+atto_complexity_name(atto_complexity_class_t complexity);
+
+/**
+ * Fits the timings of the result against each complexity class.
+ *
+ * For each class `f`, finds the `c` minimising the sum of the squared
+ * relative residuals `(ns - c * f(n)) / ns`, so each input size weighs the
+ * same although the timings span orders of magnitude. The class with the
+ * smallest root mean square of the relative residuals is the best one.
+ *
+ * Called by atto_complexity_measure(), useful on its own for timings
+ * obtained otherwise.
+ *
+ * @param result with `points`, `n` and `ns` set, where to store the fit.
+ * The input sizes should be at least 2, as `log n` is 0 below.
+ */
+void
+atto_complexity_fit(atto_complexity_result_t* result);
+
+/**
+ * Times the body at each of the given input sizes and fits the timings
+ * against each complexity class with atto_complexity_fit().
+ *
+ * Each size is timed with atto_time_ns() at least #ATTO_COMPLEXITY_REPEATS
+ * times and for at least #ATTO_COMPLEXITY_MIN_NS, calling the setup before
+ * each execution, and the fastest timing is kept. An untimed execution at
+ * the largest size warms up the caches and the CPU clock first.
+ * The sizes should be geometrically spaced, e.g. doubling, and large enough
+ * for the body to take at least a few microseconds.
+ *
+ * @param result where to store the timings and the fit. Not NULL.
+ * @param setup prepares the input of each execution. May be NULL.
+ * @param body code under test. Not NULL.
+ * @param sizes input sizes, each at least 2. Not NULL.
+ * @param sizes_len amount of sizes in [2, #ATTO_COMPLEXITY_MAX_SIZES].
+ */
+void
+atto_complexity_measure(atto_complexity_result_t* result,
+                        atto_complexity_setup_fn setup,
+                        atto_complexity_body_fn body,
+                        const size_t* sizes,
+                        size_t sizes_len);
+
+/**
+ * Prints the fit on the current line of the standard output, without
+ * terminating the line: the best class with its fitted curve, the error of
+ * every class and the relative residuals at each size of the fit of the best
+ * class, then of the expected one if different.
+ *
+ * @param result as filled by atto_complexity_measure(). Not NULL.
+ * @param expected the expected complexity class.
+ */
+void
+atto_complexity_print(const atto_complexity_result_t* result, atto_complexity_class_t expected);
+
+/**
+ * Verifies if the complexity class best fitting the timings of the body at
+ * the given input sizes is not worse than the expected one.
+ *
+ * `sizes` must be an array, not a pointer, as its length is obtained with
+ * `sizeof`. Otherwise stops the test case and reports on standard output,
+ * including the fitted curve and the residuals of the best and the expected
+ * class on the `FAIL` line.
+ *
+ * Example:
+ * ```
+ * static const size_t sizes[] = {1024, 2048, 4096, 8192, 16384, 32768};
+ * atto_complexity(shuffle_array, sort_array, sizes, ATTO_O_N_LOG_N);
+ * // FAIL | File: test_sort.c:42 | Test case: test_sort_scales | Best: O(n^2)
+ * //      | Expected: O(n log n) | Fit: 0.81 * n^2 ns | Errors: O(1) 96.3%, ...
+ * //      | Residuals of O(n^2): 1024: +2.1%, 2048: -0.4%, ...
+ * //      | Residuals of O(n log n): 1024: -48.4%, 2048: +19.3%, ...
+ * ```
+ */
+#define atto_complexity(setup, body, sizes, expected_class)                  \
+    do                                                                       \
+    {                                                                        \
+        static atto_complexity_result_t atto_complexity_result;              \
+        atto_complexity_measure(&atto_complexity_result,                     \
+                                (setup),                                     \
+                                (body),                                      \
+                                (sizes),                                     \
+                                sizeof(sizes) / sizeof((sizes)[0]));         \
+        atto_assert_details(atto_complexity_result.best <= (expected_class), \
+                            atto_complexity_print(&atto_complexity_result,   \
+                                                  (expected_class)));        \
+    }                                                                        \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_COMPLEXITY_H */
@@ -0,0 +1,253 @@
+/**
+ * @file
+ * @internal
+ * Atto ct - detection of timing leaks with the dudect methodology
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_ct.h"
+#include <math.h>   /* For sqrt(), pow() */
+#include <stdlib.h> /* For qsort() */
+#if defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h> /* For __rdtsc(), _mm_lfence(), _mm_mfence() */
+#elif defined(__x86_64__)
+    #include <x86intrin.h> /* For __rdtsc(), _mm_lfence(), _mm_mfence() */
+#endif
+
+/** Running mean and variance of the measurements of one class (Welford). */
+typedef struct
+{
+    double n;
+    double mean;
+    double m2;
+} welch_class_t;
+
+/** Index of the uncropped test, followed by the cropped ones. */
+#define UNCROPPED (0U)
+#define TESTS     (1U + ATTO_CT_CROPS)
+
+static welch_class_t tests[TESTS][2];
+static uint64_t crop_cycles[TESTS];
+static double crop_percentiles[TESTS];
+static uint64_t calibration[ATTO_CT_CALIBRATION];
+static uint64_t random_state;
+static uint8_t inputs[ATTO_CT_BATCH][ATTO_CT_INPUT_SIZE];
+static size_t input_classes[ATTO_CT_BATCH];
+
+uint64_t
+atto_ct_cycles(void)
+{
+#if defined(__x86_64__) || (defined(_MSC_VER) && defined(_M_X64))
+    _mm_lfence();  // Earlier instructions must complete before reading
+    const uint64_t cycles = (uint64_t) __rdtsc();
+    _mm_lfence();  // Later instructions must not start before reading
+    return cycles;
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks) : : "memory");
+    return ticks;
+#else
+    return atto_time_ns();
+#endif
+}
+
+/** Waits for the pending stores of the generators to reach the cache. */
+static void
+drain_stores(void)
+{
+#if defined(__x86_64__) || (defined(_MSC_VER) && defined(_M_X64))
+    _mm_mfence();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("dsb sy" : : : "memory");
+#endif
+}
+
+/** Next value of a xorshift64* pseudo-random sequence. */
+static uint64_t
+next_random(void)
+{
+    random_state ^= random_state >> 12U;
+    random_state ^= random_state << 25U;
+    random_state ^= random_state >> 27U;
+    return random_state * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+/** Adds one measurement to the running statistics of its class. */
+static void
+welch_push(welch_class_t* const class_stats, const double value)
+{
+    class_stats->n += 1.0;
+    const double delta = value - class_stats->mean;
+    class_stats->mean += delta / class_stats->n;
+    class_stats->m2 += delta * (value - class_stats->mean);
+}
+
+/** Welch's t-statistic of the difference of the means of class A and B. */
+static double
+welch_t(const welch_class_t* const classes)
+{
+    const welch_class_t* const a = &classes[0];
+    const welch_class_t* const b = &classes[1];
+    if (a->n < 2.0 || b->n < 2.0)
+    {
+        return 0.0;
+    }
+    const double variance_a = a->m2 / (a->n - 1.0);
+    const double variance_b = b->m2 / (b->n - 1.0);
+    const double standard_error = sqrt(variance_a / a->n + variance_b / b->n);
+    if (standard_error <= 0.0)
+    {
+        return a->mean == b->mean ? 0.0 : (a->mean - b->mean) * (double) INFINITY;
+    }
+    return (a->mean - b->mean) / standard_error;
+}
+
+/** Ascending order for qsort(). */
+static int
+compare_cycles(const void* const a, const void* const b)
+{
+    const uint64_t x = *(const uint64_t*) a;
+    const uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+/** Thresholds of the cropped tests from the sorted calibration measurements. */
+static void
+calibrate_crops(void)
+{
+    qsort(calibration, ATTO_CT_CALIBRATION, sizeof(calibration[0]), compare_cycles);
+    for (size_t i = 0U; i < ATTO_CT_CROPS; i++)
+    {
+        const double fraction = 1.0 - pow(0.5, 10.0 * (double) (i + 1U) / ATTO_CT_CROPS);
+        crop_cycles[1U + i] = calibration[(size_t) (fraction * ATTO_CT_CALIBRATION)];
+        crop_percentiles[1U + i] = 100.0 * fraction;
+    }
+}
+
+/** Feeds one measurement to the calibration or to the t-tests. */
+static void
+record(const size_t index, const size_t class_idx, const uint64_t cycles)
+{
+    if (index < ATTO_CT_CALIBRATION)
+    {
+        calibration[index] = cycles;
+        if (index == ATTO_CT_CALIBRATION - 1U)
+        {
+            calibrate_crops();
+        }
+        return;
+    }
+    for (size_t test = 0U; test < TESTS; test++)
+    {
+        if (cycles < crop_cycles[test])
+        {
+            welch_push(&tests[test][class_idx], (double) cycles);
+        }
+    }
+}
+
+double
+atto_ct_measure(atto_ct_result_t* const result,
+                const atto_ct_gen_fn class_a,
+                const atto_ct_gen_fn class_b,
+                const atto_ct_body_fn body,
+                const size_t measurements)
+{
+    memset(tests, 0, sizeof(tests));
+    crop_cycles[UNCROPPED] = UINT64_MAX;
+    crop_percentiles[UNCROPPED] = 100.0;
+    for (size_t test = 1U; test < TESTS; test++)
+    {
+        crop_cycles[test] = 0U;  // Discarding all until calibrated by this run
+        crop_percentiles[test] = 0.0;
+    }
+    random_state = UINT64_C(0x9E3779B97F4A7C15);
+    for (size_t done = 0U; done < measurements;)
+    {
+        const size_t remaining = measurements - done;
+        const size_t batch = remaining < ATTO_CT_BATCH ? remaining : ATTO_CT_BATCH;
+        for (size_t i = 0U; i < batch; i++)
+        {
+            input_classes[i] = (size_t) (next_random() >> 63U);
+            (input_classes[i] == 0U ? class_a : class_b)(inputs[i], ATTO_CT_INPUT_SIZE);
+        }
+        drain_stores();  // Otherwise they slow down the first measurements
+        for (size_t i = 0U; i < batch; i++, done++)
+        {
+            const uint64_t start = atto_ct_cycles();
+            body(inputs[i], ATTO_CT_INPUT_SIZE);
+            record(done, input_classes[i], atto_ct_cycles() - start);
+        }
+    }
+
+    memset(result, 0, sizeof(*result));
+    result->percentile = 100.0;
+    result->crop_cycles = UINT64_MAX;
+    result->measurements = measurements;
+    for (size_t test = 0U; test < TESTS; test++)
+    {
+        const double samples = tests[test][0].n + tests[test][1].n;
+        if (test != UNCROPPED && samples < ATTO_CT_MIN_SAMPLES)
+        {
+            continue;
+        }
+        const double t = welch_t(tests[test]);
+        if (test == UNCROPPED || fabs(t) > fabs(result->t))
+        {
+            result->t = t;
+            result->percentile = crop_percentiles[test];
+            result->crop_cycles = crop_cycles[test];
+            result->samples_a = (size_t) tests[test][0].n;
+            result->samples_b = (size_t) tests[test][1].n;
+        }
+    }
+    result->insufficient = tests[UNCROPPED][0].n + tests[UNCROPPED][1].n < ATTO_CT_MIN_SAMPLES;
+    return result->insufficient ? (double) INFINITY : fabs(result->t);
+}
+
+void
+atto_ct_print(const atto_ct_result_t* const result)
+{
+    if (result->insufficient)
+    {
+        printf(" | Insufficient samples");
+    }
+    printf(" | t: %.2f", result->t);
+    if (result->crop_cycles == UINT64_MAX)
+    {
+        printf(" | Crop: none");
+    }
+    else
+    {
+        printf(" | Crop: p%.3g (< %llu cycles)",
+               result->percentile,
+               (unsigned long long) result->crop_cycles);
+    }
+    printf(" | Class A: %zu | Class B: %zu", result->samples_a, result->samples_b);
+}
@@ -0,0 +1,240 @@
+/**
+ * @file
+ * Atto ct - detection of timing leaks with the dudect methodology
+ *
+ * Measures the execution time of the code under test in CPU cycles on two
+ * classes of inputs and checks with Welch's t-test that the two timing
+ * distributions are indistinguishable, as described in "Dude, is my code
+ * constant time?" by O. Reparaz, J. Balasch and I. Verbauwhede.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_CT_H
+#define ATTO_CT_H
+
+#include "atto.h"
+#include "atto_time.h"
+#include <stdint.h> /* For uint8_t */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Largest absolute value of the t-statistic still considered constant time.
+ *
+ * As in dudect, values above 10 mean the timing almost certainly depends on
+ * the input class. The usual TVLA threshold of 4.5 is stricter but prone to
+ * false positives on noisy machines with millions of samples.
+ */
+#ifndef ATTO_CT_T_THRESHOLD
+    #define ATTO_CT_T_THRESHOLD (10.0)
+#endif
+
+/**
+ * Amount of cropped t-tests run in parallel with the uncropped one.
+ *
+ * Test `i` discards the measurements above the percentile
+ * `1 - 0.5^(10 (i + 1) / ATTO_CT_CROPS)` of the calibration measurements,
+ * as in dudect, so the outliers caused by interrupts and context switches do
+ * not hide a leak.
+ */
+#ifndef ATTO_CT_CROPS
+    #define ATTO_CT_CROPS (100U)
+#endif
+
+/**
+ * Amount of first measurements used only to compute the cropping thresholds,
+ * also warming up caches and branch predictors.
+ */
+#ifndef ATTO_CT_CALIBRATION
+    #define ATTO_CT_CALIBRATION (1000U)
+#endif
+
+/**
+ * Minimum amount of measurements a cropped t-test needs to be considered:
+ * fewer than these give unreliable t-statistics. The uncropped one needs
+ * them too, after the #ATTO_CT_CALIBRATION ones, or the whole measurement
+ * is insufficient.
+ */
+#ifndef ATTO_CT_MIN_SAMPLES
+    #define ATTO_CT_MIN_SAMPLES (1000U)
+#endif
+
+/**
+ * Maximum size in bytes of one input of the measured body.
+ */
+#ifndef ATTO_CT_INPUT_SIZE
+    #define ATTO_CT_INPUT_SIZE (512U)
+#endif
+
+/**
+ * Amount of inputs generated before measuring them back to back.
+ *
+ * Generating the inputs in between the measurements would leak the different
+ * amount of work of the generators into the measurements, e.g. through the
+ * branch predictors. Uses `ATTO_CT_BATCH * ATTO_CT_INPUT_SIZE` bytes of
+ * static memory.
+ */
+#ifndef ATTO_CT_BATCH
+    #define ATTO_CT_BATCH (64U)
+#endif
+
+/**
+ * Generator of one input of a class, called outside of the measured time.
+ *
+ * The classic choice is a fixed input for one class and a fresh random input
+ * for the other one (fix-vs-random).
+ *
+ * @param input where to write the input, of #ATTO_CT_INPUT_SIZE bytes.
+ * @param size #ATTO_CT_INPUT_SIZE.
+ */
+typedef void (*atto_ct_gen_fn)(uint8_t* input, size_t size);
+
+/**
+ * Code under test, measured on one input per call.
+ *
+ * @param input as written by one of the generators.
+ * @param size #ATTO_CT_INPUT_SIZE.
+ */
+typedef void (*atto_ct_body_fn)(const uint8_t* input, size_t size);
+
+/**
+ * Outcome of atto_ct_measure(): the t-test with the largest absolute
+ * t-statistic among the uncropped and the cropped ones.
+ */
+typedef struct
+{
+    double t;             /**< t-statistic, positive when class A is slower. */
+    double percentile;    /**< Percentile where the test crops, 100 for none. */
+    uint64_t crop_cycles; /**< Measurements at or above are discarded. */
+    size_t samples_a;     /**< Measurements of class A used by the test. */
+    size_t samples_b;     /**< Measurements of class B used by the test. */
+    size_t measurements;  /**< All measurements, including the calibration. */
+    int insufficient;     /**< 1 if fewer than #ATTO_CT_MIN_SAMPLES were tested. */
+} atto_ct_result_t;
+
+/**
+ * Current value of the cycle counter of the CPU, or of atto_time_ns() on
+ * CPUs without one accessible from user space.
+ *
+ * Reads the time-stamp counter on x86, serialised with `lfence`, and the
+ * virtual counter on AArch64.
+ *
+ * @return counter value, only meaningful as a difference of two calls.
+ */
+uint64_t
+atto_ct_cycles(void);
+
+/**
+ * Measures the body on randomly interleaved inputs of the two classes and
+ * runs online Welch's t-tests on the measurements.
+ *
+ * The class of each measurement is chosen by a deterministic pseudo-random
+ * sequence, so slow drifts of the machine affect both classes equally.
+ * The inputs are generated in batches of #ATTO_CT_BATCH before measuring.
+ * Each measurement is streamed into running means and variances of the
+ * uncropped and the #ATTO_CT_CROPS cropped tests, so memory stays constant
+ * for any amount of measurements.
+ *
+ * Not reentrant.
+ *
+ * @param result where to store the most significant t-test. Not NULL.
+ * @param class_a generator of the inputs of class A. Not NULL.
+ * @param class_b generator of the inputs of class B. Not NULL.
+ * @param body code under test. Not NULL.
+ * @param measurements amount of measurements, including the
+ * #ATTO_CT_CALIBRATION ones. Millions give the best sensitivity.
+ * @return absolute value of the t-statistic of \p result, or infinity if
+ * fewer than #ATTO_CT_MIN_SAMPLES measurements are left after the
+ * calibration, so no leak can be ruled out.
+ */
+double
+atto_ct_measure(atto_ct_result_t* result,
+                atto_ct_gen_fn class_a,
+                atto_ct_gen_fn class_b,
+                atto_ct_body_fn body,
+                size_t measurements);
+
+/**
+ * Prints the outcome of atto_ct_measure() on the current line of the
+ * standard output, without terminating the line.
+ *
+ * Format: `| t: 42.17 | Crop: p90.1 (< 2210 cycles) | Class A: 49811 | Class B: 50189`,
+ * preceded by `| Insufficient samples` if too few measurements were left
+ * after the calibration.
+ *
+ * @param result outcome of atto_ct_measure(). Not NULL.
+ */
+void
+atto_ct_print(const atto_ct_result_t* result);
+
+/**
+ * Verifies if the execution time of the body does not depend on which of the
+ * two classes its input belongs to, with `n_samples` measurements.
+ *
+ * Otherwise, when the absolute t-statistic of any of the t-tests exceeds
+ * #ATTO_CT_T_THRESHOLD, stops the test case and reports on standard output,
+ * including the t-statistic and the sample counts on the `FAIL` line.
+ *
+ * Also fails when fewer than #ATTO_CT_MIN_SAMPLES measurements are left
+ * after the #ATTO_CT_CALIBRATION ones.
+ *
+ * Passing is evidence, not proof: leaks too small for the amount of
+ * measurements and the noise of the machine stay undetected.
+ *
+ * Example:
+ * ```
+ * static void fixed_tag(uint8_t* tag, size_t size) { memset(tag, 0, 16); }
+ * static void random_tag(uint8_t* tag, size_t size) { fill_random(tag, 16); }
+ * static void verify(const uint8_t* tag, size_t size) { ok = tag_equal(expected, tag, 16); }
+ *
+ * atto_constant_time(fixed_tag, random_tag, verify, 1000000);
+ * // FAIL | File: test_mac.c:42 | Test case: test_tag_equal_ct | t: 214.52
+ * //      | Crop: p68.2 (< 88 cycles) | Class A: 331120 | Class B: 331530
+ * ```
+ */
+#define atto_constant_time(class_a_gen, class_b_gen, body, n_samples)                        \
+    do                                                                                       \
+    {                                                                                        \
+        static atto_ct_result_t atto_ct_result;                                              \
+        atto_ct_measure(&atto_ct_result, (class_a_gen), (class_b_gen), (body), (n_samples)); \
+        atto_assert_details(!atto_ct_result.insufficient                                     \
+                                && atto_ct_result.t <= ATTO_CT_T_THRESHOLD                   \
+                                && atto_ct_result.t >= -ATTO_CT_T_THRESHOLD,                 \
+                            atto_ct_print(&atto_ct_result));                                 \
+    }                                                                                        \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_CT_H */
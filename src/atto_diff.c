@@ -0,0 +1,335 @@
+/**
+ * @file
+ * @internal
+ * Atto diff - differential testing of optimised kernels against a reference
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For sysconf() */
+#endif
+
+#include "atto_diff.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+/** Alignment of each input and output in the batch buffers. */
+#define SLOT_ALIGNMENT (64U)
+
+/** Buffer of each thread, on its own cache lines. */
+typedef struct
+{
+    _Alignas(SLOT_ALIGNMENT) unsigned char bytes[ATTO_DIFF_BATCH_SIZE];
+} diff_buffer_t;
+
+/** State shared by all threads of the current run. */
+static struct
+{
+    const atto_diff_config_t* config;
+    atto_diff_cmp_fn cmp;
+    atto_diff_fn ref_fn;
+    atto_diff_fn opt_fn;
+    atto_diff_gen_fn gen_fn;
+    size_t batches;
+    size_t batch_inputs;
+    size_t input_slot;
+    size_t output_slot;
+    atomic_size_t next_batch;
+    atomic_size_t first_index;
+    atomic_size_t compared;
+    pthread_t threads[ATTO_DIFF_MAX_THREADS];
+    diff_buffer_t buffers[ATTO_DIFF_MAX_THREADS];
+} diff;
+
+/** Rounds the size up to a multiple of the slot alignment, at least 1. */
+static size_t
+slot_size(const size_t size)
+{
+    const size_t slots = (size + SLOT_ALIGNMENT - 1U) / SLOT_ALIGNMENT;
+    return (slots == 0U ? 1U : slots) * SLOT_ALIGNMENT;
+}
+
+/** Lowers the first diverging index to the given one, if smaller. */
+static void
+lower_first_index(const size_t index)
+{
+    size_t current = atomic_load(&diff.first_index);
+    while (index < current
+           && !atomic_compare_exchange_weak(&diff.first_index, &current, index))
+    {
+        // On failure the current value is reloaded: retry while still larger
+    }
+}
+
+/** Compares one batch: inputs, then reference outputs, then optimised ones. */
+static void
+compare_batch(unsigned char* const buffer, const size_t batch)
+{
+    const atto_diff_config_t* const config = diff.config;
+    unsigned char* const inputs = buffer;
+    unsigned char* const ref_outputs = inputs + diff.batch_inputs * diff.input_slot;
+    unsigned char* const opt_outputs = ref_outputs + diff.batch_inputs * diff.output_slot;
+    const size_t first = batch * diff.batch_inputs;
+
+    for (size_t i = 0U; i < diff.batch_inputs; i++)
+    {
+        diff.gen_fn(config->seed, first + i, inputs + i * diff.input_slot, config->input_size);
+    }
+    // Each implementation runs over the whole batch, keeping its code and
+    // data hot, while the batch itself stays in the L1 cache
+    for (size_t i = 0U; i < diff.batch_inputs; i++)
+    {
+        diff.ref_fn(inputs + i * diff.input_slot, ref_outputs + i * diff.output_slot);
+    }
+    for (size_t i = 0U; i < diff.batch_inputs; i++)
+    {
+        diff.opt_fn(inputs + i * diff.input_slot, opt_outputs + i * diff.output_slot);
+    }
+    size_t compared = 0U;
+    for (size_t i = 0U; i < diff.batch_inputs; i++)
+    {
+        compared++;
+        if (!diff.cmp(ref_outputs + i * diff.output_slot,
+                      opt_outputs + i * diff.output_slot,
+                      config->output_size,
+                      config->tolerance))
+        {
+            lower_first_index(first + i);
+            break;
+        }
+    }
+    atomic_fetch_add(&diff.compared, compared);
+}
+
+/** Claims batches in order until all are done or a smaller divergence is known. */
+static void*
+diff_worker(void* const arg)
+{
+    unsigned char* const buffer = diff.buffers[(size_t) (uintptr_t) arg].bytes;
+    for (;;)
+    {
+        const size_t batch = atomic_fetch_add(&diff.next_batch, 1U);
+        if (batch >= diff.batches || batch * diff.batch_inputs > atomic_load(&diff.first_index))
+        {
+            break;
+        }
+        compare_batch(buffer, batch);
+    }
+    return NULL;
+}
+
+/** Amount of threads to start, including the calling one. */
+static size_t
+threads_to_use(const size_t requested, const size_t batches)
+{
+    size_t threads = requested;
+    if (threads == 0U)
+    {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t) cpus : 1U;
+    }
+    threads = threads > ATTO_DIFF_MAX_THREADS ? ATTO_DIFF_MAX_THREADS : threads;
+    threads = threads > batches ? batches : threads;
+    return threads == 0U ? 1U : threads;
+}
+
+int
+atto_diff_exact(const void* const ref_output,
+                const void* const opt_output,
+                const size_t output_size,
+                const double tolerance)
+{
+    (void) tolerance;
+    return memcmp(ref_output, opt_output, output_size) == 0;
+}
+
+int
+atto_diff_fdelta(const void* const ref_output,
+                 const void* const opt_output,
+                 const size_t output_size,
+                 const double tolerance)
+{
+    const float* const ref = ref_output;
+    const float* const opt = opt_output;
+    for (size_t i = 0U; i < output_size / sizeof(float); i++)
+    {
+        if (isnan(ref[i]) || isnan(opt[i]))
+        {
+            if (!isnan(ref[i]) || !isnan(opt[i]))
+            {
+                return 0;
+            }
+        }
+        else if (fabs((double) ref[i] - (double) opt[i]) > tolerance)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/** Maps the bits of a float to an integer growing with its value, -0 as +0. */
+static int64_t
+ordered_bits(const float value)
+{
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? -(int64_t) (bits & INT32_MAX) : (int64_t) bits;
+}
+
+int
+atto_diff_ulp(const void* const ref_output,
+              const void* const opt_output,
+              const size_t output_size,
+              const double tolerance)
+{
+    const float* const ref = ref_output;
+    const float* const opt = opt_output;
+    for (size_t i = 0U; i < output_size / sizeof(float); i++)
+    {
+        if (isnan(ref[i]) || isnan(opt[i]))
+        {
+            if (!isnan(ref[i]) || !isnan(opt[i]))
+            {
+                return 0;
+            }
+        }
+        else
+        {
+            const int64_t distance = ordered_bits(ref[i]) - ordered_bits(opt[i]);
+            if ((double) (distance < 0 ? -distance : distance) > tolerance)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+uint64_t
+atto_diff_state(const uint64_t seed, const size_t index)
+{
+    uint64_t state = seed ^ ((uint64_t) index * UINT64_C(0xD1B54A32D192ED03));
+    return atto_diff_next(&state);
+}
+
+uint64_t
+atto_diff_next(uint64_t* const state)
+{
+    *state += UINT64_C(0x9E3779B97F4A7C15);
+    uint64_t z = *state;
+    z = (z ^ (z >> 30U)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27U)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31U);
+}
+
+void
+atto_diff_random_bytes(const uint64_t seed,
+                       const size_t index,
+                       void* const input,
+                       const size_t input_size)
+{
+    unsigned char* const bytes = input;
+    uint64_t state = atto_diff_state(seed, index);
+    for (size_t i = 0U; i < input_size; i += sizeof(uint64_t))
+    {
+        const uint64_t value = atto_diff_next(&state);
+        const size_t left = input_size - i;
+        memcpy(bytes + i, &value, left < sizeof(value) ? left : sizeof(value));
+    }
+}
+
+int
+atto_diff_run(atto_diff_result_t* const result,
+              const atto_diff_config_t* const config,
+              const atto_diff_fn ref_fn,
+              const atto_diff_fn opt_fn,
+              const atto_diff_gen_fn gen_fn,
+              const size_t batches)
+{
+    diff.config = config;
+    diff.cmp = config->cmp == NULL ? atto_diff_exact : config->cmp;
+    diff.ref_fn = ref_fn;
+    diff.opt_fn = opt_fn;
+    diff.gen_fn = gen_fn;
+    diff.batches = batches;
+    diff.input_slot = slot_size(config->input_size);
+    diff.output_slot = slot_size(config->output_size);
+    diff.batch_inputs = ATTO_DIFF_BATCH_SIZE / (diff.input_slot + 2U * diff.output_slot);
+    atomic_store(&diff.next_batch, 0U);
+    atomic_store(&diff.first_index, SIZE_MAX);
+    atomic_store(&diff.compared, 0U);
+
+    result->seed = config->seed;
+    result->batches = batches;
+    result->batch_inputs = diff.batch_inputs;
+    result->threads = 0U;
+    if (diff.batch_inputs > 0U)
+    {
+        result->threads = threads_to_use(config->threads, batches);
+        size_t started = 1U;
+        while (started < result->threads
+               && pthread_create(&diff.threads[started],
+                                 NULL,
+                                 diff_worker,
+                                 (void*) (uintptr_t) started)
+                      == 0)
+        {
+            started++;
+        }
+        diff_worker((void*) (uintptr_t) 0U);
+        for (size_t i = 1U; i < started; i++) { pthread_join(diff.threads[i], NULL); }
+        result->threads = started;
+    }
+    result->compared = atomic_load(&diff.compared);
+    result->first_index = atomic_load(&diff.first_index);
+    result->diverged = result->first_index != SIZE_MAX;
+    return diff.batch_inputs > 0U && !result->diverged;
+}
+
+void
+atto_diff_print(const atto_diff_result_t* const result)
+{
+    printf(" | Seed: 0x%016llx", (unsigned long long) result->seed);
+    if (result->batch_inputs == 0U)
+    {
+        printf(" | Input and outputs larger than a batch of %u B", ATTO_DIFF_BATCH_SIZE);
+        return;
+    }
+    if (result->diverged)
+    {
+        printf(" | First divergence: %zu", result->first_index);
+    }
+    printf(" | Compared: %zu | Batches: %zu | Inputs per batch: %zu | Threads: %zu",
+           result->compared,
+           result->batches,
+           result->batch_inputs,
+           result->threads);
+}
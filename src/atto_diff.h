@@ -0,0 +1,298 @@
+/**
+ * @file
+ * Atto diff - differential testing of optimised kernels against a reference
+ *
+ * Requires POSIX threads and C11 atomics. Both implementations run on the
+ * same generated inputs, batch by batch, and their outputs are compared with
+ * a pluggable comparator. Every input is derived from a seed and its index
+ * only, so the first diverging input is reported as that pair and can be
+ * regenerated in isolation, in a debugger, on any machine.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_DIFF_H
+#define ATTO_DIFF_H
+
+#include "atto.h"
+#include <stdint.h> /* For uint64_t */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of threads comparing batches at the same time.
+ */
+#ifndef ATTO_DIFF_MAX_THREADS
+    #define ATTO_DIFF_MAX_THREADS (16U)
+#endif
+
+/**
+ * Bytes of the buffer of each thread, holding one batch of inputs and both
+ * of their outputs.
+ *
+ * Sized to fit into the L1 data cache, so the optimised implementation
+ * reads the inputs the reference one just touched without a cache miss.
+ */
+#ifndef ATTO_DIFF_BATCH_SIZE
+    #define ATTO_DIFF_BATCH_SIZE (32768U)
+#endif
+
+/**
+ * Generates the input at the given index.
+ *
+ * Must depend only on the seed and the index, not on previous calls, so
+ * any input can be regenerated alone. Called by multiple threads at the
+ * same time.
+ *
+ * @param seed seed of the whole run.
+ * @param index index of the input, from 0.
+ * @param input where to store the input. Not NULL.
+ * @param input_size size of the input in bytes.
+ */
+typedef void (*atto_diff_gen_fn)(uint64_t seed, size_t index, void* input, size_t input_size);
+
+/**
+ * Implementation under test, either the reference or the optimised one.
+ *
+ * Called by multiple threads at the same time, so it must not use the Atto
+ * assertions.
+ *
+ * @param input the generated input.
+ * @param output where to store the output.
+ */
+typedef void (*atto_diff_fn)(const void* input, void* output);
+
+/**
+ * Compares the output of the optimised implementation to the reference one.
+ *
+ * @param ref_output output of the reference implementation.
+ * @param opt_output output of the optimised implementation.
+ * @param output_size size of each output in bytes.
+ * @param tolerance accepted difference, meaning depending on the comparator.
+ * @return 1 if the outputs match, 0 if they diverge.
+ */
+typedef int (*atto_diff_cmp_fn)(const void* ref_output,
+                                const void* opt_output,
+                                size_t output_size,
+                                double tolerance);
+
+/**
+ * Shape of the inputs and outputs and how to compare them.
+ */
+typedef struct
+{
+    size_t input_size;    /**< Size of each input in bytes. */
+    size_t output_size;   /**< Size of each output in bytes. */
+    atto_diff_cmp_fn cmp; /**< Comparator, NULL for atto_diff_exact(). */
+    double tolerance;     /**< Passed to the comparator. */
+    uint64_t seed;        /**< Seed of the generated inputs. */
+    size_t threads;       /**< Threads to use, 0 for all online CPUs. */
+} atto_diff_config_t;
+
+/**
+ * Outcome of a differential run.
+ */
+typedef struct
+{
+    uint64_t seed;       /**< Seed of the generated inputs. */
+    size_t batches;      /**< Amount of batches requested. */
+    size_t batch_inputs; /**< Amount of inputs per batch, 0 if too large. */
+    size_t threads;      /**< Amount of threads used. */
+    size_t compared;     /**< Amount of inputs compared. */
+    int diverged;        /**< 1 if any output diverged. */
+    size_t first_index;  /**< Smallest diverging index, if diverged. */
+} atto_diff_result_t;
+
+/**
+ * Compares the outputs byte by byte.
+ *
+ * @param ref_output output of the reference implementation.
+ * @param opt_output output of the optimised implementation.
+ * @param output_size size of each output in bytes.
+ * @param tolerance ignored.
+ * @return 1 if the outputs are identical, 0 otherwise.
+ */
+int
+atto_diff_exact(const void* ref_output,
+                const void* opt_output,
+                size_t output_size,
+                double tolerance);
+
+/**
+ * Compares the outputs as arrays of floats, as atto_fdelta() does.
+ *
+ * NaN matches only NaN.
+ *
+ * @param ref_output output of the reference implementation.
+ * @param opt_output output of the optimised implementation.
+ * @param output_size size of each output in bytes, a multiple of
+ * `sizeof(float)`.
+ * @param tolerance largest accepted absolute difference of each float.
+ * @return 1 if all floats are close enough, 0 otherwise.
+ */
+int
+atto_diff_fdelta(const void* ref_output,
+                 const void* opt_output,
+                 size_t output_size,
+                 double tolerance);
+
+/**
+ * Compares the outputs as arrays of floats, by the amount of representable
+ * floats between them: the units in the last place (ULP).
+ *
+ * Scales with the magnitude of the values, unlike atto_diff_fdelta(), so it
+ * suits kernels reordering floating-point operations. `+0` and `-0` are 0 ULP
+ * apart. NaN matches only NaN.
+ *
+ * @param ref_output output of the reference implementation.
+ * @param opt_output output of the optimised implementation.
+ * @param output_size size of each output in bytes, a multiple of
+ * `sizeof(float)`.
+ * @param tolerance largest accepted distance in ULP of each float.
+ * @return 1 if all floats are close enough, 0 otherwise.
+ */
+int
+atto_diff_ulp(const void* ref_output,
+              const void* opt_output,
+              size_t output_size,
+              double tolerance);
+
+/**
+ * Pseudo-random state of the input at the given index, for generators
+ * drawing values with atto_diff_next().
+ *
+ * @param seed seed of the whole run.
+ * @param index index of the input.
+ * @return the initial state, different for each seed and index.
+ */
+uint64_t
+atto_diff_state(uint64_t seed, size_t index);
+
+/**
+ * Next pseudo-random value of a SplitMix64 sequence.
+ *
+ * @param state state to advance. Not NULL.
+ * @return a uniformly distributed 64-bit value.
+ */
+uint64_t
+atto_diff_next(uint64_t* state);
+
+/**
+ * Generator filling the whole input with pseudo-random bytes.
+ *
+ * @param seed seed of the whole run.
+ * @param index index of the input.
+ * @param input where to store the input. Not NULL.
+ * @param input_size size of the input in bytes.
+ */
+void
+atto_diff_random_bytes(uint64_t seed, size_t index, void* input, size_t input_size);
+
+/**
+ * Runs the reference and the optimised implementations on the same inputs
+ * and compares their outputs.
+ *
+ * The inputs are split into batches filling #ATTO_DIFF_BATCH_SIZE together
+ * with their outputs. Threads claim the batches in order and, for each
+ * batch, generate all inputs, run the reference on all of them, then the
+ * optimised implementation on all of them, then compare. After a divergence,
+ * the batches past it are skipped, while the ones before it are completed,
+ * so the reported index is the smallest diverging one, whatever the amount
+ * of threads.
+ *
+ * Not reentrant: only one differential run at a time.
+ *
+ * @param result where to store the outcome. Not NULL.
+ * @param config shape of inputs and outputs and the comparator. Not NULL.
+ * @param ref_fn reference implementation. Not NULL.
+ * @param opt_fn optimised implementation. Not NULL.
+ * @param gen_fn input generator. Not NULL.
+ * @param batches amount of batches to compare.
+ * @return 1 if all compared outputs match, 0 if any diverged or an input
+ * and its outputs do not fit into #ATTO_DIFF_BATCH_SIZE.
+ */
+int
+atto_diff_run(atto_diff_result_t* result,
+              const atto_diff_config_t* config,
+              atto_diff_fn ref_fn,
+              atto_diff_fn opt_fn,
+              atto_diff_gen_fn gen_fn,
+              size_t batches);
+
+/**
+ * Prints the outcome on the current line of the standard output, without
+ * terminating the line.
+ *
+ * Format: `| Seed: 0x... | First divergence: 1234 | Compared: 8192 | ...`
+ *
+ * @param result outcome to print. Not NULL.
+ */
+void
+atto_diff_print(const atto_diff_result_t* result);
+
+/**
+ * Verifies if the optimised implementation gives the same outputs as the
+ * reference one on all inputs of the given amount of batches.
+ *
+ * Otherwise stops the test case and reports on standard output the seed
+ * and the index of the first diverging input on the `FAIL` line: calling
+ * the generator with them gives back that input.
+ * Fails also when an input and its outputs do not fit into a batch.
+ *
+ * Example:
+ * ```
+ * static const atto_diff_config_t config = {
+ *     .input_size = 64U * sizeof(float),
+ *     .output_size = sizeof(float),
+ *     .cmp = atto_diff_ulp,
+ *     .tolerance = 4.0,
+ *     .seed = 42U,
+ * };
+ * atto_differential(&config, sum_scalar, sum_avx2, random_floats, 1000U);
+ * // FAIL | File: test.c:42 | Test case: test_sum | Seed: 0x000000000000002a
+ * //      | First divergence: 5171 | Compared: 5172 | Batches: 1000 | ...
+ * ```
+ */
+#define atto_differential(config, ref_fn, opt_fn, gen_fn, batches)                 \
+    do                                                                             \
+    {                                                                              \
+        atto_diff_result_t atto_diff_result;                                       \
+        const int atto_diff_passed = atto_diff_run(                                \
+            &atto_diff_result, (config), (ref_fn), (opt_fn), (gen_fn), (batches)); \
+        atto_assert_details(atto_diff_passed, atto_diff_print(&atto_diff_result)); \
+    }                                                                              \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_DIFF_H */
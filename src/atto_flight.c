@@ -0,0 +1,203 @@
+/**
+ * @file
+ * @internal
+ * Atto flight - recorder of the last assertions that passed, dumped on crash
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_WIN32) && !defined(_XOPEN_SOURCE)
+    #define _XOPEN_SOURCE 700 /* For sigaltstack() */
+#endif
+
+#include "atto_flight.h"
+#include <signal.h>    /* For sigaction(), sigaltstack(), raise() */
+#include <stdatomic.h> /* For atomic_size_t */
+#include <stdint.h>    /* For uint64_t */
+#include <unistd.h>    /* For write() */
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h> /* For __rdtsc() */
+#endif
+
+#if (ATTO_FLIGHT_SIZE & (ATTO_FLIGHT_SIZE - 1U)) != 0U
+    #error "ATTO_FLIGHT_SIZE must be a power of 2"
+#endif
+
+/** Size of the alternate stack the signal handlers run on. */
+#define ALT_STACK_SIZE (64U * 1024U)
+
+/** One recorded assertion site. */
+typedef struct
+{
+    const char* file;
+    int line;
+    uint64_t ticks;
+} flight_entry_t;
+
+static flight_entry_t ring[ATTO_FLIGHT_SIZE];
+static atomic_size_t recorded = 0U;
+
+static const int crash_signals[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL};
+#define CRASH_SIGNALS (sizeof(crash_signals) / sizeof(crash_signals[0]))
+static struct sigaction previous_actions[CRASH_SIGNALS];
+static char alt_stack[ALT_STACK_SIZE];
+
+/** Cheapest available monotonic tick counter. */
+static uint64_t
+ticks_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint64_t) __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (uint64_t) atomic_load_explicit(&recorded, memory_order_relaxed);
+#endif
+}
+
+void
+atto_flight_record(const char* const file, const int line)
+{
+    const size_t sequence = atomic_fetch_add_explicit(&recorded, 1U, memory_order_relaxed);
+    flight_entry_t* const entry = &ring[sequence & (ATTO_FLIGHT_SIZE - 1U)];
+    entry->ticks = ticks_now();
+    entry->file = file;
+    entry->line = line;
+}
+
+/** Async-signal-safe replacement of fputs(). */
+static void
+write_str(const int fd, const char* const str)
+{
+    size_t len = 0U;
+    while (str[len] != '\0') { len++; }
+    if (write(fd, str, len) < 0)
+    {
+        return;  // Nothing better to do while crashing
+    }
+}
+
+/** Async-signal-safe replacement of printf("%llu"). */
+static void
+write_uint(const int fd, uint64_t value)
+{
+    char digits[24];
+    size_t start = sizeof(digits) - 1U;
+    digits[start] = '\0';
+    do
+    {
+        digits[--start] = (char) ('0' + (int) (value % 10U));
+        value /= 10U;
+    }
+    while (value != 0U);
+    write_str(fd, &digits[start]);
+}
+
+void
+atto_flight_dump(const int fd)
+{
+    const uint64_t now = ticks_now();
+    const size_t total = atomic_load_explicit(&recorded, memory_order_relaxed);
+    const size_t kept = total < ATTO_FLIGHT_SIZE ? total : ATTO_FLIGHT_SIZE;
+
+    write_str(fd, "FLIGHT | Test case: ");
+    write_str(fd, atto_current_test == NULL ? "-" : atto_current_test);
+    write_str(fd, " | Last ");
+    write_uint(fd, kept);
+    write_str(fd, " of ");
+    write_uint(fd, total);
+    write_str(fd, " passed assertions, oldest first\n");
+    for (size_t i = 0U; i < kept; i++)
+    {
+        const size_t sequence = total - kept + i;
+        const flight_entry_t* const entry = &ring[sequence & (ATTO_FLIGHT_SIZE - 1U)];
+        write_str(fd, "FLIGHT | #");
+        write_uint(fd, sequence);
+        write_str(fd, " | File: ");
+        write_str(fd, entry->file == NULL ? "?" : entry->file);
+        write_str(fd, ":");
+        write_uint(fd, (uint64_t) entry->line);
+        write_str(fd, " | Age: ");
+        write_uint(fd, now >= entry->ticks ? now - entry->ticks : 0U);
+        write_str(fd, " ticks\n");
+    }
+}
+
+void
+atto_flight_clear(void)
+{
+    atomic_store_explicit(&recorded, 0U, memory_order_relaxed);
+}
+
+size_t
+atto_flight_recorded(void)
+{
+    return atomic_load_explicit(&recorded, memory_order_relaxed);
+}
+
+/** Dumps the recorder, then lets the previous handler deal with the signal. */
+static void
+crash_handler(const int signal_number)
+{
+    write_str(STDOUT_FILENO, "FLIGHT | Signal: ");
+    write_uint(STDOUT_FILENO, (uint64_t) signal_number);
+    write_str(STDOUT_FILENO, "\n");
+    atto_flight_dump(STDOUT_FILENO);
+    for (size_t i = 0U; i < CRASH_SIGNALS; i++)
+    {
+        if (crash_signals[i] == signal_number)
+        {
+            sigaction(signal_number, &previous_actions[i], NULL);
+        }
+    }
+    // Still blocked in here: delivered to the previous handler once returning
+    raise(signal_number);
+}
+
+int
+atto_flight_install(void)
+{
+    stack_t stack;
+    stack.ss_sp = alt_stack;
+    stack.ss_size = sizeof(alt_stack);
+    stack.ss_flags = 0;
+    int error = sigaltstack(&stack, NULL) != 0;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = crash_handler;
+    action.sa_flags = SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0U; i < CRASH_SIGNALS; i++)
+    {
+        error |= sigaction(crash_signals[i], &action, &previous_actions[i]) != 0;
+    }
+    return error;
+}
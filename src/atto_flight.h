@@ -0,0 +1,116 @@
+/**
+ * @file
+ * Atto flight - recorder of the last assertions that passed, dumped on crash
+ *
+ * Requires POSIX signals and C11 atomics. Enabled by compiling the test
+ * executable with `ATTO_FLIGHT_RECORDER` defined, otherwise the assertions
+ * record nothing.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_FLIGHT_H
+#define ATTO_FLIGHT_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Amount of most recent assertion sites kept by the flight recorder.
+ *
+ * Must be a power of 2. Older sites are overwritten.
+ */
+#ifndef ATTO_FLIGHT_SIZE
+    #define ATTO_FLIGHT_SIZE (64U)
+#endif
+
+/**
+ * Installs the handlers of the crash signals (`SIGSEGV`, `SIGABRT`, `SIGBUS`,
+ * `SIGFPE`, `SIGILL`) dumping the flight recorder on standard output.
+ *
+ * The handlers are async-signal-safe and run on an alternate signal stack,
+ * so they also work after a stack overflow of the calling thread. After the
+ * dump the previous handler of the signal is restored and the signal raised
+ * again, so the process still terminates (or a debugger still stops) as it
+ * would without the flight recorder.
+ *
+ * Example:
+ * ```
+ * int main(void)
+ * {
+ *     atto_flight_install();
+ *     test_parser();  // Crashes
+ *     // FLIGHT | Signal: 11
+ *     // FLIGHT | Test case: - | Last 2 of 2 passed assertions, oldest first
+ *     // FLIGHT | #0 | File: test.c:12 | Age: 4210 ticks
+ *     // FLIGHT | #1 | File: test.c:13 | Age: 1890 ticks
+ * }
+ * ```
+ *
+ * @return 0 on success, 1 if any handler could not be installed.
+ */
+int
+atto_flight_install(void);
+
+/**
+ * Writes the content of the flight recorder, oldest site first, to a file
+ * descriptor.
+ *
+ * Async-signal-safe. The age of each site is in ticks of the CPU timestamp
+ * counter (nanoseconds or a plain sequence on other platforms) before the
+ * dump.
+ *
+ * @param fd file descriptor to write to, e.g. `STDOUT_FILENO`.
+ */
+void
+atto_flight_dump(int fd);
+
+/**
+ * Forgets all recorded assertion sites.
+ */
+void
+atto_flight_clear(void);
+
+/**
+ * Amount of assertion sites recorded since the start or the last
+ * atto_flight_clear(), including the overwritten ones.
+ *
+ * @return amount of records.
+ */
+size_t
+atto_flight_recorded(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_FLIGHT_H */
@@ -0,0 +1,156 @@
+/**
+ * @file
+ * @internal
+ * Atto fuzz - test cases that are also libFuzzer fuzz targets
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For stat() */
+#endif
+
+#include "atto_fuzz.h"
+#include "atto_pool.h"
+#include <dirent.h>   /* For opendir(), readdir() */
+#include <fcntl.h>    /* For open() */
+#include <sys/mman.h> /* For mmap() */
+#include <sys/stat.h> /* For stat() */
+#include <unistd.h>   /* For close() */
+
+/** Corpus replayed in parallel, each worker taking every n-th input. */
+typedef struct
+{
+    atto_fuzz_fn target;
+    const char* corpus_dir;
+} fuzz_job_t;
+
+/** Maps one input and calls the target on it, reporting a failure. */
+static void
+replay_input(const atto_fuzz_fn target, const char* const path, const size_t size)
+{
+    static const uint8_t empty[1] = {0U};
+    const size_t failures = atto_counter_assert_failures;
+    if (size == 0U)
+    {
+        target(empty, 0U);
+    }
+    else
+    {
+        const int fd = open(path, O_RDONLY);
+        void* const mapped = fd < 0 ? MAP_FAILED : mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        if (mapped == MAP_FAILED)
+        {
+            printf("FAIL | File: %s:%d | Test case: %s | Input: %s | Cannot be mapped\n",
+                   __FILE__,
+                   __LINE__,
+                   atto_current_test == NULL ? "-" : atto_current_test,
+                   path);
+            atto_counter_assert_failures++;
+            atto_at_least_one_fail = 1;
+            return;
+        }
+        target((const uint8_t*) mapped, size);
+        munmap(mapped, size);
+    }
+    if (atto_counter_assert_failures != failures)
+    {
+        printf("FUZZ | Input: %s\n", path);
+    }
+}
+
+/** Replays every regular file with index `worker` modulo `workers`. */
+static size_t
+replay_share(void* const job_ctx, const size_t worker, const size_t workers)
+{
+    const fuzz_job_t* const job = job_ctx;
+    DIR* const dir = opendir(job->corpus_dir);
+    if (dir == NULL)
+    {
+        return 0U;
+    }
+    char path[ATTO_FUZZ_PATH_LEN];
+    size_t index = 0U;
+    size_t replayed = 0U;
+    const struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        struct stat info;
+        const int len = snprintf(path, sizeof(path), "%s/%s", job->corpus_dir, entry->d_name);
+        if (entry->d_name[0] == '.' || len < 0 || (size_t) len >= sizeof(path)
+            || stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            continue;
+        }
+        if (index++ % workers == worker)
+        {
+            replay_input(job->target, path, (size_t) info.st_size);
+            replayed++;
+        }
+    }
+    closedir(dir);
+    return replayed;
+}
+
+/** Reports the share of a crashed worker. */
+static void
+share_crashed(void* const job_ctx, const size_t worker)
+{
+    const fuzz_job_t* const job = job_ctx;
+    printf("FAIL | File: %s:%d | Test case: %s | Corpus: %s | Worker: %zu | Crashed\n",
+           __FILE__,
+           __LINE__,
+           atto_current_test == NULL ? "-" : atto_current_test,
+           job->corpus_dir,
+           worker);
+}
+
+size_t
+atto_fuzz_replay(const atto_fuzz_fn target, const char* const corpus_dir, size_t workers)
+{
+    DIR* const dir = opendir(corpus_dir);
+    if (dir == NULL)
+    {
+        printf("FAIL | File: %s:%d | Test case: %s | Corpus: %s | Cannot be opened\n",
+               __FILE__,
+               __LINE__,
+               atto_current_test == NULL ? "-" : atto_current_test,
+               corpus_dir);
+        atto_counter_assert_failures++;
+        atto_at_least_one_fail = 1;
+        return 0U;
+    }
+    closedir(dir);
+    fuzz_job_t job = {.target = target, .corpus_dir = corpus_dir};
+    workers = workers > ATTO_FUZZ_MAX_WORKERS ? ATTO_FUZZ_MAX_WORKERS : workers;
+    return atto_pool_run(replay_share, share_crashed, &job, workers);
+}
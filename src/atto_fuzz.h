@@ -0,0 +1,155 @@
+/**
+ * @file
+ * Atto fuzz - test cases that are also libFuzzer fuzz targets
+ *
+ * Requires POSIX directories, `mmap()` and `fork()` to replay corpora.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_FUZZ_H
+#define ATTO_FUZZ_H
+
+#include "atto.h"
+#include <stdint.h> /* For uint8_t */
+
+#if defined(ATTO_FUZZING) && !defined(ATTO_ABORT_ON_FAIL)
+    #error "ATTO_FUZZING requires ATTO_ABORT_ON_FAIL, so the fuzzer notices failed assertions"
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum length of the path of a corpus input, including the directory.
+ */
+#ifndef ATTO_FUZZ_PATH_LEN
+    #define ATTO_FUZZ_PATH_LEN (4096U)
+#endif
+
+/**
+ * Maximum amount of worker processes of atto_fuzz_replay().
+ */
+#ifndef ATTO_FUZZ_MAX_WORKERS
+    #define ATTO_FUZZ_MAX_WORKERS (64U)
+#endif
+
+/**
+ * Fuzz target: checks invariants with Atto assertions on one input.
+ *
+ * @param data the input bytes.
+ * @param size length of the input in bytes.
+ */
+typedef void (*atto_fuzz_fn)(const uint8_t* data, size_t size);
+
+/**
+ * Defines a fuzz target, followed by its body checking invariants on the
+ * input with the usual Atto assertions.
+ *
+ * In a regular build the target is a static function with the given name,
+ * to be replayed on a corpus with atto_fuzz_replay() as part of the test
+ * suite.
+ *
+ * When compiled with `ATTO_FUZZING` and `ATTO_ABORT_ON_FAIL` defined, it also
+ * defines `LLVMFuzzerTestOneInput()` calling the target, so the file builds
+ * as a libFuzzer fuzzer, e.g. with
+ * `clang -fsanitize=fuzzer,address -DATTO_FUZZING -DATTO_ABORT_ON_FAIL`.
+ * Any failed assertion then aborts, which the fuzzer reports as a crash.
+ * Only one target per fuzzer executable, and its `main()` must be excluded
+ * with `#ifndef ATTO_FUZZING`, as libFuzzer provides its own.
+ *
+ * Example:
+ * ```
+ * ATTO_FUZZ_TARGET(fuzz_codec, data, size)
+ * {
+ *     uint8_t encoded[1024];
+ *     uint8_t decoded[512];
+ *     if (size > sizeof(decoded)) { return; }
+ *     const size_t encoded_len = encode(data, size, encoded);
+ *     atto_eq(decode(encoded, encoded_len, decoded), size);
+ *     atto_memeq(decoded, data, size);
+ * }
+ *
+ * #ifndef ATTO_FUZZING
+ * static void
+ * test_codec_corpus(void)
+ * {
+ *     atto_gt(atto_fuzz_replay(fuzz_codec, "corpus/codec", 4U), 0U);
+ * }
+ * #endif
+ * ```
+ */
+#ifdef ATTO_FUZZING
+    #define ATTO_FUZZ_TARGET(name, data, size)                        \
+        static void name(const uint8_t* data, size_t size);           \
+        int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size); \
+        int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)  \
+        {                                                             \
+            name(data, size);                                         \
+            return 0;                                                 \
+        }                                                             \
+        static void name(const uint8_t* data, size_t size)
+#else
+    #define ATTO_FUZZ_TARGET(name, data, size) static void name(const uint8_t* data, size_t size)
+#endif
+
+/**
+ * Calls the fuzz target on every file of a corpus directory, e.g. the inputs
+ * collected by the fuzzer or regression inputs of crashes found in the past.
+ *
+ * Each file is memory-mapped and passed as is. Hidden files and
+ * sub-directories are skipped. When an input fails any assertion, prints a
+ * `FUZZ` line with the path of the input right after the `FAIL` line:
+ *
+ * ```
+ * FAIL | File: test_codec.c:31 | Test case: fuzz_codec
+ * FUZZ | Input: corpus/codec/crash-5f1d0e2a
+ * ```
+ *
+ * With more than 1 worker, the inputs are distributed across forked worker
+ * processes. The counters of passed and failed assertions of the workers
+ * are added to the counters of the calling process at the end.
+ *
+ * @param target fuzz target defined with ATTO_FUZZ_TARGET(). Not NULL.
+ * @param corpus_dir directory of inputs. Not NULL.
+ * @param workers amount of worker processes in [1, #ATTO_FUZZ_MAX_WORKERS],
+ * 0 or 1 to replay all inputs in the calling process.
+ * @return amount of replayed inputs, 0 if the directory could not be opened,
+ * which also counts as a failed assertion, as does an input which cannot be
+ * mapped or a crashed worker.
+ */
+size_t
+atto_fuzz_replay(atto_fuzz_fn target, const char* corpus_dir, size_t workers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_FUZZ_H */
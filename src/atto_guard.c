@@ -0,0 +1,325 @@
+/**
+ * @file
+ * @internal
+ * Atto guard - buffers placed against inaccessible pages to catch overruns
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+    #define _DEFAULT_SOURCE /* For MAP_ANONYMOUS, sigsetjmp() */
+#endif
+
+#include "atto_guard.h"
+#include <setjmp.h>   /* For sigsetjmp(), siglongjmp() */
+#include <signal.h>   /* For sigaction() */
+#include <stdint.h>   /* For uintptr_t */
+#include <sys/mman.h> /* For mmap(), mprotect() */
+#include <unistd.h>   /* For sysconf(), write() */
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+    #define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#if (ATTO_GUARD_ALIGNMENT & (ATTO_GUARD_ALIGNMENT - 1U)) != 0U
+    #error "ATTO_GUARD_ALIGNMENT must be a power of 2"
+#endif
+
+/** One guarded buffer and the mapping around it. */
+typedef struct
+{
+    unsigned char* map;
+    size_t map_len;
+    unsigned char* guard;
+    unsigned char* buffer;
+    size_t len;
+    const char* file;
+    int line;
+    int freed;
+} guarded_t;
+
+static guarded_t guarded[ATTO_GUARD_MAX_BUFFERS];
+static size_t guarded_amount = 0U;
+static int hooked = 0;
+static int installed = 0;
+static size_t page_size = 0U;
+
+static const int fault_signals[] = {SIGSEGV, SIGBUS};
+#define FAULT_SIGNALS (sizeof(fault_signals) / sizeof(fault_signals[0]))
+static struct sigaction previous_actions[FAULT_SIGNALS];
+
+static sigjmp_buf recovery;
+static volatile sig_atomic_t recovery_armed = 0;
+static atto_test_fn guarded_test = NULL;
+static const guarded_t* volatile fault_buffer = NULL;
+static const unsigned char* volatile fault_address = NULL;
+
+/** Async-signal-safe replacement of fputs(). */
+static void
+write_str(const char* const str)
+{
+    size_t len = 0U;
+    while (str[len] != '\0') { len++; }
+    if (write(STDOUT_FILENO, str, len) < 0)
+    {
+        return;  // Nothing better to do while crashing
+    }
+}
+
+/** Async-signal-safe replacement of printf("%llu"). */
+static void
+write_uint(uint64_t value)
+{
+    char digits[24];
+    size_t start = sizeof(digits) - 1U;
+    digits[start] = '\0';
+    do
+    {
+        digits[--start] = (char) ('0' + (int) (value % 10U));
+        value /= 10U;
+    }
+    while (value != 0U);
+    write_str(&digits[start]);
+}
+
+/** Prints the failure caused by the last fault, async-signal-safe. */
+static void
+write_fault(void)
+{
+    const guarded_t* const buffer = fault_buffer;
+    const unsigned char* const address = fault_address;
+    write_str("FAIL | File: ");
+    write_str(buffer->file);
+    write_str(":");
+    write_uint((uint64_t) buffer->line);
+    write_str(" | Test case: ");
+    write_str(atto_current_test == NULL ? "-" : atto_current_test);
+    write_str(" | Guarded buffer: ");
+    write_uint(buffer->len);
+    if (buffer->freed)
+    {
+        write_str(" B | Use after free at offset: ");
+    }
+    else if (address < buffer->buffer)
+    {
+        write_str(" B | Underflow at offset: ");
+    }
+    else
+    {
+        write_str(" B | Overflow at offset: ");
+    }
+    if (address < buffer->buffer)
+    {
+        write_str("-");
+        write_uint((uint64_t) (buffer->buffer - address));
+    }
+    else
+    {
+        write_uint((uint64_t) (address - buffer->buffer));
+    }
+    write_str("\n");
+}
+
+/** Guarded buffer whose inaccessible memory contains the address, if any. */
+static const guarded_t*
+find_faulting(const unsigned char* const address)
+{
+    for (size_t i = 0U; i < guarded_amount; i++)
+    {
+        const guarded_t* const buffer = &guarded[i];
+        const int in_guard = address >= buffer->guard
+                             && address < buffer->guard + page_size;
+        const int in_map = address >= buffer->map && address < buffer->map + buffer->map_len;
+        if (in_guard || (buffer->freed && in_map))
+        {
+            return buffer;
+        }
+    }
+    return NULL;
+}
+
+/** Recovers from a fault on a guard page, otherwise defers to the previous handler. */
+static void
+fault_handler(const int signal_number, siginfo_t* const info, void* const context)
+{
+    (void) context;
+    const guarded_t* const buffer = find_faulting((const unsigned char*) info->si_addr);
+    if (buffer != NULL)
+    {
+        fault_buffer = buffer;
+        fault_address = (const unsigned char*) info->si_addr;
+        if (recovery_armed)
+        {
+            recovery_armed = 0;
+            siglongjmp(recovery, 1);
+        }
+        write_fault();
+    }
+    for (size_t i = 0U; i < FAULT_SIGNALS; i++)
+    {
+        if (fault_signals[i] == signal_number)
+        {
+            sigaction(signal_number, &previous_actions[i], NULL);
+        }
+    }
+    // Returning repeats the faulting access, now handled by the previous handler
+}
+
+/** Catches the faults on guard pages from now on. */
+static void
+install_handlers(void)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = fault_handler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0U; i < FAULT_SIGNALS; i++)
+    {
+        sigaction(fault_signals[i], &action, &previous_actions[i]);
+    }
+    installed = 1;
+}
+
+/** Unmaps the buffers of the test case that just ended. */
+static void
+guard_after_test(const char* const test_name)
+{
+    (void) test_name;
+    atto_guard_release();
+}
+
+void*
+atto_guard_alloc(const size_t len,
+                 const atto_guard_edge_t edge,
+                 const char* const file,
+                 const int line)
+{
+    if (!hooked)
+    {
+        hooked = atto_hook_add(NULL, guard_after_test) == 0;
+    }
+    if (!installed)
+    {
+        install_handlers();
+    }
+    if (page_size == 0U)
+    {
+        page_size = (size_t) sysconf(_SC_PAGESIZE);
+    }
+    const size_t page = page_size;
+    if (guarded_amount >= ATTO_GUARD_MAX_BUFFERS || len > SIZE_MAX - 2U * page)
+    {
+        return NULL;
+    }
+    const size_t data_pages = len == 0U ? 1U : (len + page - 1U) / page;
+    const size_t map_len = (data_pages + 1U) * page;
+    unsigned char* const map
+        = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
+    {
+        return NULL;
+    }
+    guarded_t* const buffer = &guarded[guarded_amount];
+    buffer->map = map;
+    buffer->map_len = map_len;
+    if (edge == ATTO_GUARD_LEFT)
+    {
+        buffer->guard = map;
+        buffer->buffer = map + page;
+    }
+    else
+    {
+        buffer->guard = map + data_pages * page;
+        buffer->buffer = (unsigned char*) ((uintptr_t) (buffer->guard - len)
+                                           & ~(uintptr_t) (ATTO_GUARD_ALIGNMENT - 1U));
+    }
+    if (mprotect(buffer->guard, page, PROT_NONE) != 0)
+    {
+        munmap(map, map_len);
+        return NULL;
+    }
+    buffer->len = len;
+    buffer->file = file;
+    buffer->line = line;
+    buffer->freed = 0;
+    guarded_amount++;  // Only now visible to the fault handler
+    return buffer->buffer;
+}
+
+void
+atto_guarded_free(void* const buffer)
+{
+    for (size_t i = 0U; i < guarded_amount; i++)
+    {
+        if (guarded[i].buffer == buffer && !guarded[i].freed
+            && mprotect(guarded[i].map, guarded[i].map_len, PROT_NONE) == 0)
+        {
+            guarded[i].freed = 1;
+            return;
+        }
+    }
+}
+
+void
+atto_guard_release(void)
+{
+    for (size_t i = 0U; i < guarded_amount; i++)
+    {
+        munmap(guarded[i].map, guarded[i].map_len);
+    }
+    guarded_amount = 0U;
+}
+
+/** Takes the place of the test case, resuming here after a fault. */
+static void
+guarded_trampoline(void)
+{
+    if (sigsetjmp(recovery, 1) == 0)
+    {
+        recovery_armed = 1;
+        guarded_test();
+    }
+    else
+    {
+        fflush(stdout);  // Keeps the order with the output written before
+        write_fault();
+        atto_counter_assert_failures++;
+        atto_at_least_one_fail = 1;
+        ATTO_ON_FAIL();
+    }
+    recovery_armed = 0;
+}
+
+void
+atto_guard_run_test(const atto_test_fn test, const char* const name)
+{
+    guarded_test = test;
+    atto_run_test(guarded_trampoline, name);
+    guarded_test = NULL;
+}
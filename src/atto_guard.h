@@ -0,0 +1,199 @@
+/**
+ * @file
+ * Atto guard - buffers placed against inaccessible pages to catch overruns
+ *
+ * Requires POSIX `mmap()`, `mprotect()` and signals. The overruns are caught
+ * by the hardware at full speed, without instrumenting the code under test.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_GUARD_H
+#define ATTO_GUARD_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of guarded buffers allocated at the same time, including
+ * the freed ones, until atto_guard_release().
+ */
+#ifndef ATTO_GUARD_MAX_BUFFERS
+    #define ATTO_GUARD_MAX_BUFFERS (256U)
+#endif
+
+/**
+ * Alignment in bytes of the buffers guarded on the right edge. Must be a
+ * power of 2.
+ *
+ * With 1 the end of every buffer touches the guard page, so even a 1-byte
+ * overrun faults. Larger alignments leave up to `alignment - 1` unguarded
+ * bytes after the end of buffers whose length is not a multiple of it, but
+ * may be required by the code under test, e.g. for SIMD loads.
+ */
+#ifndef ATTO_GUARD_ALIGNMENT
+    #define ATTO_GUARD_ALIGNMENT (1U)
+#endif
+
+/**
+ * Edge of a buffer that is placed against the inaccessible page.
+ */
+typedef enum
+{
+    ATTO_GUARD_RIGHT, /**< Catches overflows past the end of the buffer. */
+    ATTO_GUARD_LEFT,  /**< Catches underflows before its start. */
+} atto_guard_edge_t;
+
+/**
+ * Edge guarded by atto_guarded_alloc(), e.g. to run the whole suite once more
+ * with `-DATTO_GUARD_DEFAULT_EDGE=ATTO_GUARD_LEFT` to catch underflows.
+ */
+#ifndef ATTO_GUARD_DEFAULT_EDGE
+    #define ATTO_GUARD_DEFAULT_EDGE ATTO_GUARD_RIGHT
+#endif
+
+/**
+ * Maps a buffer right against an inaccessible (`PROT_NONE`) guard page.
+ *
+ * Prefer the atto_guarded_alloc() and atto_guarded_alloc_edge() macros,
+ * which provide the allocation site automatically.
+ *
+ * The first call installs the handlers of `SIGSEGV` and `SIGBUS` catching
+ * accesses to the guard pages and registers atto_guard_release() with
+ * atto_hook_add(), so every guarded buffer is unmapped when the test case
+ * launched with atto_run() ends.
+ *
+ * Each buffer takes at least 2 pages of address space, so use it for the
+ * buffers handed to the code under test, not for every allocation.
+ *
+ * @param len length of the buffer in bytes.
+ * @param edge which edge of the buffer to guard.
+ * @param file source file of the allocation site, reported on a fault.
+ * @param line line of the allocation site, reported on a fault.
+ * @return the buffer, filled with zeros, or NULL if it could not be mapped
+ * or #ATTO_GUARD_MAX_BUFFERS are already allocated.
+ */
+void*
+atto_guard_alloc(size_t len, atto_guard_edge_t edge, const char* file, int line);
+
+/**
+ * Allocates a guarded buffer of `len` bytes against the edge selected with
+ * #ATTO_GUARD_DEFAULT_EDGE, by default the right one.
+ *
+ * Any access past the end of the buffer faults immediately. When the test
+ * case was launched with atto_guard_run(), the fault stops it and counts as
+ * a failed assertion, reported with the allocation site of the buffer:
+ *
+ * ```
+ * uint8_t* const out = atto_guarded_alloc(16);
+ * base64_decode(out, "AAAAAAAAAAAAAAAAAAAAAA==");  // Writes 17 bytes
+ * // FAIL | File: test_base64.c:42 | Test case: test_decode | Guarded buffer: 16 B
+ * //      | Overflow at offset: 16
+ * ```
+ */
+#define atto_guarded_alloc(len) atto_guard_alloc((len), ATTO_GUARD_DEFAULT_EDGE, __FILE__, __LINE__)
+
+/**
+ * Allocates a guarded buffer of `len` bytes against the given edge, either
+ * #ATTO_GUARD_RIGHT or #ATTO_GUARD_LEFT.
+ *
+ * Example:
+ * ```
+ * int16_t* const samples = atto_guarded_alloc_edge(64 * sizeof(int16_t), ATTO_GUARD_LEFT);
+ * ```
+ */
+#define atto_guarded_alloc_edge(len, edge) atto_guard_alloc((len), (edge), __FILE__, __LINE__)
+
+/**
+ * Makes a guarded buffer completely inaccessible, so any later use faults
+ * and is reported as a use after free.
+ *
+ * The address space is returned to the system by atto_guard_release().
+ * Does nothing when \p buffer is NULL or not a live guarded buffer.
+ *
+ * @param buffer as returned by atto_guard_alloc().
+ */
+void
+atto_guarded_free(void* buffer);
+
+/**
+ * Unmaps all guarded buffers, including the freed ones.
+ *
+ * Called automatically at the end of each test case launched with atto_run()
+ * after the first guarded allocation. Outside of atto_run() call it manually.
+ */
+void
+atto_guard_release(void);
+
+/**
+ * Executes a test case as atto_run_test(), but recovering from a fault on a
+ * guard page: the test case stops there, the fault counts as a failed
+ * assertion and the following test cases run as usual.
+ *
+ * Prefer atto_guard_run(), which provides the name automatically.
+ * Not reentrant.
+ *
+ * @param test test case function to execute. Not NULL.
+ * @param name name of the test case.
+ */
+void
+atto_guard_run_test(atto_test_fn test, const char* name);
+
+/**
+ * Executes a test case with atto_run(), turning a fault on a guard page into
+ * a failed assertion of the test case, reported with the allocation site of
+ * the buffer.
+ *
+ * Without it, the fault is still reported the same way but then the process
+ * is terminated by the signal, as it would without guarded buffers.
+ *
+ * The test case is left with a `siglongjmp()`, so the optimiser may have
+ * delayed its stores to non-volatile variables past the faulting access.
+ *
+ * Example:
+ * ```
+ * int main(void)
+ * {
+ *     atto_guard_run(test_decode);
+ *     atto_guard_run(test_encode);
+ *     atto_report();
+ *     return atto_at_least_one_fail;
+ * }
+ * ```
+ */
+#define atto_guard_run(test) atto_guard_run_test((test), #test)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_GUARD_H */
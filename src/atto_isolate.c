@@ -0,0 +1,573 @@
+/**
+ * @file
+ * @internal
+ * Atto isolate - restores global and static variables after each test case
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE /* For dl_iterate_phdr() */
+#endif
+
+#include "atto_isolate.h"
+#include <fcntl.h>
+#include <link.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** Bit of a /proc/self/pagemap entry set when the page was written to. */
+#define SOFT_DIRTY_BIT (UINT64_C(1) << 55U)
+
+/** Amount of pagemap entries read at once. */
+#define PAGEMAP_CHUNK (512U)
+
+/** Fields of the symbols and relocations of the native ELF class. */
+#if __ELF_NATIVE_CLASS == 64
+    #define SYMBOL_TYPE(info)       ELF64_ST_TYPE(info)
+    #define SYMBOL_BIND(info)       ELF64_ST_BIND(info)
+    #define RELOCATION_SYMBOL(info) ELF64_R_SYM(info)
+    #define RELOCATION_TYPE(info)   ELF64_R_TYPE(info)
+#else
+    #define SYMBOL_TYPE(info)       ELF32_ST_TYPE(info)
+    #define SYMBOL_BIND(info)       ELF32_ST_BIND(info)
+    #define RELOCATION_SYMBOL(info) ELF32_R_SYM(info)
+    #define RELOCATION_TYPE(info)   ELF32_R_TYPE(info)
+#endif
+
+/** Relocation copying a variable of a shared library into the executable. */
+#if defined(__x86_64__)
+    #define COPY_RELOCATION R_X86_64_COPY
+#elif defined(__i386__)
+    #define COPY_RELOCATION R_386_COPY
+#elif defined(__aarch64__)
+    #define COPY_RELOCATION R_AARCH64_COPY
+#elif defined(__arm__)
+    #define COPY_RELOCATION R_ARM_COPY
+#elif defined(__riscv)
+    #define COPY_RELOCATION R_RISCV_COPY
+#elif defined(__powerpc64__)
+    #define COPY_RELOCATION R_PPC64_COPY
+#elif defined(__powerpc__)
+    #define COPY_RELOCATION R_PPC_COPY
+#endif
+
+/** Writable pages of a module and their copy. */
+typedef struct
+{
+    unsigned char* start;
+    size_t pages;
+    unsigned char* snapshot;
+} isolate_segment_t;
+
+/** Address range kept across test cases. */
+typedef struct
+{
+    uintptr_t start;
+    uintptr_t end;
+} isolate_exclude_t;
+
+/** All state of the module, excluded from the restoring as a whole. */
+static struct
+{
+    int hooked;
+    int soft_dirty;
+    int clear_refs_fd;
+    int pagemap_fd;
+    size_t page_size;
+    size_t last_restored;
+    size_t segments_amount;
+    isolate_segment_t segments[ATTO_ISOLATE_MAX_SEGMENTS];
+    size_t excludes_amount;
+    isolate_exclude_t excludes[ATTO_ISOLATE_MAX_EXCLUDES];
+    const char* wanted_module;
+    size_t visited_modules;
+    int found;
+    int error;
+} isolate = {.clear_refs_fd = -1, .pagemap_fd = -1};
+
+/** Clears the soft-dirty bits of all pages of the process. */
+static void
+clear_soft_dirty(void)
+{
+    // Writing only on failure, not to dirty the page of the state itself
+    if (isolate.soft_dirty && pwrite(isolate.clear_refs_fd, "4", 1U, 0) != 1)
+    {
+        isolate.soft_dirty = 0;
+    }
+}
+
+/** Whether the kernel sets the soft-dirty bit of a page just written to. */
+static int
+probe_soft_dirty(void)
+{
+    isolate.clear_refs_fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+    isolate.pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (isolate.clear_refs_fd < 0 || isolate.pagemap_fd < 0)
+    {
+        return 0;
+    }
+    // Kernels without soft-dirty support accept the clearing anyway
+    isolate.soft_dirty = 1;
+    clear_soft_dirty();
+    // Volatile, so the write happens before reading the bit
+    *(volatile size_t*) &isolate.visited_modules = 0U;
+    uint64_t entry = 0U;
+    const off_t offset
+        = (off_t) ((uintptr_t) &isolate.visited_modules / isolate.page_size * sizeof(entry));
+    return isolate.soft_dirty
+           && pread(isolate.pagemap_fd, &entry, sizeof(entry), offset) == (ssize_t) sizeof(entry)
+           && (entry & SOFT_DIRTY_BIT) != 0U;
+}
+
+/** Copies a range, except the bytes in the excluded ranges. */
+static void
+copy_unexcluded(unsigned char* const destination, const unsigned char* const source, size_t size)
+{
+    const uintptr_t end = (uintptr_t) destination + size;
+    uintptr_t from = (uintptr_t) destination;
+    while (from < end)
+    {
+        uintptr_t next_excluded = end;
+        uintptr_t resume = end;
+        for (size_t i = 0U; i < isolate.excludes_amount; i++)
+        {
+            const isolate_exclude_t* const exclude = &isolate.excludes[i];
+            if (exclude->end > from && exclude->start < next_excluded)
+            {
+                next_excluded = exclude->start > from ? exclude->start : from;
+                resume = exclude->end < end ? exclude->end : end;
+            }
+        }
+        memcpy((void*) from, source + (from - (uintptr_t) destination), next_excluded - from);
+        from = resume;
+    }
+}
+
+/**
+ * Calls the action on each page of the segment written to since the soft-dirty
+ * bits were last cleared or, without them, differing from the snapshot.
+ */
+static size_t
+for_each_written_page(const isolate_segment_t* const segment,
+                      void (*const action)(unsigned char* page, unsigned char* copy))
+{
+    const size_t page_size = isolate.page_size;
+    const size_t first_page = (uintptr_t) segment->start / page_size;
+    uint64_t entries[PAGEMAP_CHUNK];
+    size_t written = 0U;
+    for (size_t chunk = 0U; chunk < segment->pages; chunk += PAGEMAP_CHUNK)
+    {
+        const size_t left = segment->pages - chunk;
+        const size_t amount = left < PAGEMAP_CHUNK ? left : PAGEMAP_CHUNK;
+        // Comparing also when the pagemap cannot be read
+        int compare = 1;
+        if (isolate.soft_dirty)
+        {
+            const ssize_t expected = (ssize_t) (amount * sizeof(entries[0]));
+            compare = pread(isolate.pagemap_fd,
+                            entries,
+                            amount * sizeof(entries[0]),
+                            (off_t) ((first_page + chunk) * sizeof(entries[0])))
+                      != expected;
+        }
+        for (size_t i = chunk; i < chunk + amount; i++)
+        {
+            unsigned char* const page = segment->start + i * page_size;
+            unsigned char* const copy = segment->snapshot + i * page_size;
+            const int page_written = compare ? memcmp(page, copy, page_size) != 0
+                                             : (entries[i - chunk] & SOFT_DIRTY_BIT) != 0U;
+            if (page_written)
+            {
+                action(page, copy);
+                written++;
+            }
+        }
+    }
+    return written;
+}
+
+/** Updates the snapshot of a page. */
+static void
+snapshot_page(unsigned char* const page, unsigned char* const copy)
+{
+    memcpy(copy, page, isolate.page_size);
+}
+
+/** Copies the snapshot back into a page. */
+static void
+restore_page(unsigned char* const page, unsigned char* const copy)
+{
+    copy_unexcluded(page, copy, isolate.page_size);
+}
+
+/** Takes the changes made since the last test case into the snapshot. */
+static void
+isolate_before_test(const char* const test_name)
+{
+    (void) test_name;
+    for (size_t i = 0U; i < isolate.segments_amount; i++)
+    {
+        for_each_written_page(&isolate.segments[i], snapshot_page);
+    }
+    clear_soft_dirty();
+}
+
+/** Undoes the changes made by the test case. */
+static void
+isolate_after_test(const char* const test_name)
+{
+    (void) test_name;
+    size_t restored = 0U;
+    for (size_t i = 0U; i < isolate.segments_amount; i++)
+    {
+        restored += for_each_written_page(&isolate.segments[i], restore_page);
+    }
+    isolate.last_restored = restored;
+    clear_soft_dirty();
+}
+
+/** Adds one writable segment, snapshotting it whole. */
+static int
+add_segment(const uintptr_t start, const uintptr_t end)
+{
+    if (isolate.segments_amount >= ATTO_ISOLATE_MAX_SEGMENTS)
+    {
+        return 1;
+    }
+    const uintptr_t page_size = (uintptr_t) isolate.page_size;
+    const uintptr_t first = start / page_size * page_size;
+    const uintptr_t last = (end + page_size - 1U) / page_size * page_size;
+    void* const snapshot = mmap(
+        NULL, last - first, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (snapshot == MAP_FAILED)
+    {
+        return 1;
+    }
+    isolate_segment_t* const segment = &isolate.segments[isolate.segments_amount];
+    segment->start = (unsigned char*) first;
+    segment->pages = (last - first) / page_size;
+    segment->snapshot = snapshot;
+    memcpy(segment->snapshot, segment->start, last - first);
+    isolate.segments_amount++;
+    return 0;
+}
+
+/** Whether a symbol or the basename of a source file is one of Atto. */
+static int
+is_atto_name(const char* const name)
+{
+    const char* const slash = strrchr(name, '/');
+    const char* const base = slash != NULL ? slash + 1 : name;
+    return strncmp(base, "atto_", 5U) == 0 || strncmp(base, "atto.", 5U) == 0;
+}
+
+/** Section of the file, if its contents are within it. */
+static const ElfW(Shdr)*
+file_section(const unsigned char* const file, const size_t file_size, const size_t index)
+{
+    const ElfW(Ehdr)* const header = (const ElfW(Ehdr)*) file;
+    if (index >= header->e_shnum)
+    {
+        return NULL;
+    }
+    const ElfW(Shdr)* const section = (const ElfW(Shdr)*) (file + header->e_shoff) + index;
+    if (section->sh_type != SHT_NOBITS
+        && (section->sh_offset > file_size || section->sh_size > file_size - section->sh_offset))
+    {
+        return NULL;
+    }
+    return section;
+}
+
+/**
+ * Excludes the writable variables of Atto listed in a symbol table: the ones
+ * named `atto_...` and the static ones of the `atto*.c` files.
+ */
+static void
+exclude_atto_symbols(const unsigned char* const file,
+                     const size_t file_size,
+                     const ElfW(Shdr)* const symbols,
+                     const uintptr_t base)
+{
+    const ElfW(Shdr)* const names = file_section(file, file_size, symbols->sh_link);
+    if (names == NULL || names->sh_size == 0U || file[names->sh_offset + names->sh_size - 1U] != 0U
+        || symbols->sh_entsize != sizeof(ElfW(Sym)))
+    {
+        return;
+    }
+    const ElfW(Sym)* const table = (const ElfW(Sym)*) (file + symbols->sh_offset);
+    const char* const strings = (const char*) (file + names->sh_offset);
+    int in_atto_file = 0;
+    for (size_t i = 0U; i < symbols->sh_size / sizeof(ElfW(Sym)); i++)
+    {
+        const ElfW(Sym)* const symbol = &table[i];
+        const char* const name = symbol->st_name < names->sh_size ? strings + symbol->st_name : "";
+        const unsigned char type = SYMBOL_TYPE(symbol->st_info);
+        if (type == STT_FILE)
+        {
+            in_atto_file = is_atto_name(name);
+            continue;
+        }
+        // Local symbols of a file follow it, the global ones come after all
+        if (SYMBOL_BIND(symbol->st_info) != STB_LOCAL)
+        {
+            in_atto_file = 0;
+        }
+        const ElfW(Shdr)* const section
+            = symbol->st_shndx < SHN_LORESERVE ? file_section(file, file_size, symbol->st_shndx)
+                                               : NULL;
+        if (type == STT_OBJECT && symbol->st_size != 0U && section != NULL
+            && (section->sh_flags & SHF_WRITE) != 0U && (in_atto_file || is_atto_name(name))
+            && atto_isolate_exclude((const void*) (base + symbol->st_value), symbol->st_size))
+        {
+            isolate.error = 1;
+            return;
+        }
+    }
+}
+
+/**
+ * Excludes the variables of shared libraries copied into the module by copy
+ * relocations, like `environ`, which stay owned by their library.
+ */
+static void
+exclude_copy_relocations(const unsigned char* const file,
+                         const size_t file_size,
+                         const ElfW(Shdr)* const relocations,
+                         const uintptr_t base)
+{
+#ifdef COPY_RELOCATION
+    const ElfW(Shdr)* const symbols = file_section(file, file_size, relocations->sh_link);
+    // Rel and Rela entries share their first fields
+    if (symbols == NULL || symbols->sh_entsize != sizeof(ElfW(Sym))
+        || relocations->sh_entsize < sizeof(ElfW(Rel)))
+    {
+        return;
+    }
+    const ElfW(Sym)* const table = (const ElfW(Sym)*) (file + symbols->sh_offset);
+    const size_t symbols_amount = symbols->sh_size / sizeof(ElfW(Sym));
+    for (size_t i = 0U; i < relocations->sh_size / relocations->sh_entsize; i++)
+    {
+        const ElfW(Rel)* const relocation
+            = (const ElfW(Rel)*) (file + relocations->sh_offset + i * relocations->sh_entsize);
+        const size_t symbol = RELOCATION_SYMBOL(relocation->r_info);
+        if (RELOCATION_TYPE(relocation->r_info) == COPY_RELOCATION && symbol < symbols_amount
+            && atto_isolate_exclude((const void*) (base + relocation->r_offset),
+                                    table[symbol].st_size))
+        {
+            isolate.error = 1;
+            return;
+        }
+    }
+#else
+    (void) file;
+    (void) file_size;
+    (void) relocations;
+    (void) base;
+#endif
+}
+
+/**
+ * Excludes the variables of Atto and the copy-relocated ones of the module,
+ * reading its file. Without a symbol table, only the exported variables of
+ * Atto are found.
+ */
+static void
+exclude_module_variables(const char* const path, const uintptr_t base)
+{
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat status;
+    void* file = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && (size_t) status.st_size >= sizeof(ElfW(Ehdr)))
+    {
+        file = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (file == MAP_FAILED)
+    {
+        return;
+    }
+    const size_t file_size = (size_t) status.st_size;
+    const ElfW(Ehdr)* const header = file;
+    const ElfW(Shdr)* dynamic_symbols = NULL;
+    const ElfW(Shdr)* static_symbols = NULL;
+    if (memcmp(header->e_ident, ELFMAG, SELFMAG) == 0
+        && header->e_shentsize == sizeof(ElfW(Shdr)) && header->e_shoff <= file_size
+        && header->e_shnum <= (file_size - header->e_shoff) / sizeof(ElfW(Shdr)))
+    {
+        for (size_t i = 0U; i < header->e_shnum; i++)
+        {
+            const ElfW(Shdr)* const section = file_section(file, file_size, i);
+            if (section == NULL)
+            {
+                continue;
+            }
+            if (section->sh_type == SHT_SYMTAB)
+            {
+                static_symbols = section;
+            }
+            else if (section->sh_type == SHT_DYNSYM)
+            {
+                dynamic_symbols = section;
+            }
+            else if (section->sh_type == SHT_REL || section->sh_type == SHT_RELA)
+            {
+                exclude_copy_relocations(file, file_size, section, base);
+            }
+        }
+    }
+    if (static_symbols != NULL || dynamic_symbols != NULL)
+    {
+        exclude_atto_symbols(
+            file, file_size, static_symbols != NULL ? static_symbols : dynamic_symbols, base);
+    }
+    munmap(file, file_size);
+}
+
+/** Whether the page of an address is already in an isolated segment. */
+static int
+is_isolated(const uintptr_t address)
+{
+    const uintptr_t page = address / isolate.page_size * isolate.page_size;
+    for (size_t i = 0U; i < isolate.segments_amount; i++)
+    {
+        if ((uintptr_t) isolate.segments[i].start == page)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** Adds the writable segments of the wanted module, skipping the RELRO part. */
+static int
+visit_module(struct dl_phdr_info* const info, const size_t size, void* const data)
+{
+    (void) size;
+    (void) data;
+    const int is_executable = isolate.visited_modules++ == 0U;
+    const int wanted = isolate.wanted_module == NULL
+                           ? is_executable
+                           : strstr(info->dlpi_name, isolate.wanted_module) != NULL;
+    if (!wanted)
+    {
+        return 0;
+    }
+    // Made read-only after relocation, up to the last full page
+    uintptr_t relro_end = 0U;
+    for (size_t i = 0U; i < info->dlpi_phnum; i++)
+    {
+        const ElfW(Phdr)* const header = &info->dlpi_phdr[i];
+        if (header->p_type == PT_GNU_RELRO)
+        {
+            relro_end = (info->dlpi_addr + header->p_vaddr + header->p_memsz)
+                        / isolate.page_size * isolate.page_size;
+        }
+    }
+    for (size_t i = 0U; i < info->dlpi_phnum; i++)
+    {
+        const ElfW(Phdr)* const header = &info->dlpi_phdr[i];
+        if (header->p_type == PT_LOAD && (header->p_flags & PF_W) != 0U)
+        {
+            const uintptr_t start = info->dlpi_addr + header->p_vaddr;
+            const uintptr_t end = start + header->p_memsz;
+            const uintptr_t from = start > relro_end ? start : relro_end;
+            if (end > relro_end && is_isolated(from))
+            {
+                // Isolated by an earlier call, with all of its segments
+                isolate.found = 1;
+                return 1;
+            }
+            if (end > relro_end)
+            {
+                isolate.error |= add_segment(from, end);
+            }
+        }
+    }
+    exclude_module_variables(is_executable ? "/proc/self/exe" : info->dlpi_name, info->dlpi_addr);
+    isolate.found = 1;
+    return 1;
+}
+
+int
+atto_isolate_exclude(const void* const address, const size_t size)
+{
+    if (isolate.excludes_amount >= ATTO_ISOLATE_MAX_EXCLUDES)
+    {
+        return 1;
+    }
+    isolate.excludes[isolate.excludes_amount].start = (uintptr_t) address;
+    isolate.excludes[isolate.excludes_amount].end = (uintptr_t) address + size;
+    isolate.excludes_amount++;
+    return 0;
+}
+
+int
+atto_isolate_module(const char* const module)
+{
+    if (!isolate.hooked)
+    {
+        isolate.page_size = (size_t) sysconf(_SC_PAGESIZE);
+        if (atto_isolate_exclude(&isolate, sizeof(isolate))
+            || atto_isolate_exclude(&atto_counter_assert_passes, sizeof(atto_counter_assert_passes))
+            || atto_isolate_exclude(&atto_counter_assert_failures,
+                                    sizeof(atto_counter_assert_failures))
+            || atto_isolate_exclude(&atto_at_least_one_fail, sizeof(atto_at_least_one_fail))
+            || atto_hook_add(isolate_before_test, isolate_after_test))
+        {
+            return 1;
+        }
+        isolate.soft_dirty = probe_soft_dirty();
+        isolate.hooked = 1;
+    }
+    isolate.wanted_module = module;
+    isolate.visited_modules = 0U;
+    isolate.found = 0;
+    isolate.error = 0;
+    dl_iterate_phdr(visit_module, NULL);
+    clear_soft_dirty();
+    return !isolate.found || isolate.error;
+}
+
+int
+atto_isolate_soft_dirty(void)
+{
+    return isolate.soft_dirty;
+}
+
+size_t
+atto_isolate_last_restored(void)
+{
+    return isolate.last_restored;
+}
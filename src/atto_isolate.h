@@ -0,0 +1,135 @@
+/**
+ * @file
+ * Atto isolate - restores global and static variables after each test case
+ *
+ * Linux only. Test cases leaking state into each other through global or
+ * static variables become as isolated as when running each in its own
+ * process, at the cost of copying back the pages they wrote to. The
+ * writable segments, `.data` and `.bss`, of the chosen modules are
+ * snapshotted before each test case and restored after it.
+ *
+ * Written pages are found with the soft-dirty bits of the kernel, when built
+ * with them, otherwise by comparing each page to the snapshot. Either way
+ * untouched pages are neither copied nor made private to the process.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_ISOLATE_H
+#define ATTO_ISOLATE_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of writable segments of all isolated modules.
+ */
+#ifndef ATTO_ISOLATE_MAX_SEGMENTS
+    #define ATTO_ISOLATE_MAX_SEGMENTS (16U)
+#endif
+
+/**
+ * Maximum amount of address ranges excluded from the restoring, including
+ * the variables of Atto and the copy-relocated ones, excluded automatically.
+ */
+#ifndef ATTO_ISOLATE_MAX_EXCLUDES
+    #define ATTO_ISOLATE_MAX_EXCLUDES (256U)
+#endif
+
+/**
+ * Isolates the test cases from changes to the global and static variables
+ * of a module: the executable or a loaded shared library.
+ *
+ * The first call registers hooks with atto_hook_add(), so each test case
+ * launched with atto_run() afterwards leaves the variables of the module as
+ * it found them. Call it after enabling the per-test-case features of the
+ * other Atto modules, so their hooks run outside of the snapshot and their
+ * reports after each test case are not undone.
+ *
+ * Excluded automatically, as found in the symbol table of the module file:
+ * - the state of all Atto modules, like queued check failures, recorded
+ *   benchmarks and trace buffers: the variables named `atto_...` and the
+ *   static ones defined in the `atto*.c` files;
+ * - the variables of shared libraries copied into the module by copy
+ *   relocations, like `environ`, which the library keeps using.
+ *
+ * Stripped modules have only the exported symbols left, so there only the
+ * counters of the Atto assertions, the state of this module and the copy
+ * relocations are excluded. Exclude more with atto_isolate_exclude().
+ * Variables of the standard library are not affected unless the library
+ * itself is isolated, which is not recommended.
+ *
+ * Isolating an already isolated module again has no effect.
+ *
+ * @param module substring of the path of the shared library, as listed by
+ * `dl_iterate_phdr()`, or NULL for the executable.
+ * @return 0 on success, 1 if the module was not found, has too many writable
+ * segments or variables to exclude, the snapshot could not be allocated or no
+ * more hooks could be registered.
+ */
+int
+atto_isolate_module(const char* module);
+
+/**
+ * Keeps the changes to an address range across test cases, e.g. a counter
+ * of all test cases or a cache meant to be shared.
+ *
+ * @param address start of the range. Not NULL.
+ * @param size length of the range in bytes.
+ * @return 0 on success, 1 if #ATTO_ISOLATE_MAX_EXCLUDES ranges are already
+ * excluded.
+ */
+int
+atto_isolate_exclude(const void* address, size_t size);
+
+/**
+ * Whether written pages are found with the soft-dirty bits of the kernel
+ * or by comparing them to the snapshot.
+ *
+ * @return 1 if soft-dirty bits are used, 0 otherwise.
+ */
+int
+atto_isolate_soft_dirty(void);
+
+/**
+ * Amount of pages written by the last test case and copied back after it.
+ *
+ * @return amount of restored pages.
+ */
+size_t
+atto_isolate_last_restored(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_ISOLATE_H */
@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @internal
+ * Atto latency - tail-latency assertions backed by a log-bucketed histogram
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_latency.h"
+
+/** Position of the most significant set bit of a non-zero value. */
+static unsigned int
+msb_position(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63U - (unsigned int) __builtin_clzll(value);
+#else
+    unsigned int position = 0U;
+    while (value >>= 1U) { position++; }
+    return position;
+#endif
+}
+
+/** Index of the bucket where the latency is counted. */
+static size_t
+bucket_index(const uint64_t latency_ns)
+{
+    if (latency_ns < ATTO_LATENCY_SUB_BUCKETS)
+    {
+        return (size_t) latency_ns;  // Small values are stored exactly
+    }
+    const unsigned int shift = msb_position(latency_ns) - ATTO_LATENCY_SUB_BITS;
+    const size_t sub_bucket = (size_t) (latency_ns >> shift) - ATTO_LATENCY_SUB_BUCKETS;
+    return ATTO_LATENCY_SUB_BUCKETS + shift * ATTO_LATENCY_SUB_BUCKETS + sub_bucket;
+}
+
+/** Highest latency that is counted in the same bucket. */
+static uint64_t
+bucket_highest_value(const size_t index)
+{
+    if (index < ATTO_LATENCY_SUB_BUCKETS)
+    {
+        return (uint64_t) index;
+    }
+    const unsigned int shift = (unsigned int) (index / ATTO_LATENCY_SUB_BUCKETS) - 1U;
+    const uint64_t sub_bucket = (uint64_t) (index % ATTO_LATENCY_SUB_BUCKETS);
+    const uint64_t lowest = (ATTO_LATENCY_SUB_BUCKETS + sub_bucket) << shift;
+    return lowest + ((UINT64_C(1) << shift) - 1U);
+}
+
+void
+atto_latency_init(atto_latency_t* const hist)
+{
+    memset(hist->counts, 0, sizeof(hist->counts));
+    hist->total = 0U;
+    hist->min_ns = UINT64_MAX;
+    hist->max_ns = 0U;
+}
+
+void
+atto_latency_record(atto_latency_t* const hist, const uint64_t latency_ns)
+{
+    hist->counts[bucket_index(latency_ns)]++;
+    hist->total++;
+    hist->min_ns = latency_ns < hist->min_ns ? latency_ns : hist->min_ns;
+    hist->max_ns = latency_ns > hist->max_ns ? latency_ns : hist->max_ns;
+}
+
+uint64_t
+atto_latency_percentile(const atto_latency_t* const hist, double percentile)
+{
+    if (hist->total == 0U)
+    {
+        return 0U;
+    }
+    percentile = percentile < 0.0 ? 0.0 : (percentile > 100.0 ? 100.0 : percentile);
+    uint64_t target = (uint64_t) ceil(percentile / 100.0 * (double) hist->total);
+    target = target == 0U ? 1U : target;
+    uint64_t cumulative = 0U;
+    for (size_t i = 0U; i < ATTO_LATENCY_BUCKETS; i++)
+    {
+        cumulative += hist->counts[i];
+        if (cumulative >= target)
+        {
+            const uint64_t highest = bucket_highest_value(i);
+            return highest < hist->max_ns ? highest : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+void
+atto_latency_print(const atto_latency_t* const hist)
+{
+    static const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+
+    printf(" | Samples: %llu", (unsigned long long) hist->total);
+    if (hist->total == 0U)
+    {
+        return;
+    }
+    printf(" | Min: %llu ns", (unsigned long long) hist->min_ns);
+    for (size_t i = 0U; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+    {
+        printf(" | p%g: %llu ns",
+               percentiles[i],
+               (unsigned long long) atto_latency_percentile(hist, percentiles[i]));
+    }
+    printf(" | Max: %llu ns", (unsigned long long) hist->max_ns);
+}
@@ -0,0 +1,187 @@
+/**
+ * @file
+ * Atto latency - tail-latency assertions backed by a log-bucketed histogram
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_LATENCY_H
+#define ATTO_LATENCY_H
+
+#include "atto.h"
+#include "atto_time.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Amount of bits of each recorded latency that are stored exactly.
+ *
+ * Every power-of-two range of latencies is split into `2^bits` linear
+ * sub-buckets, as in the HdrHistogram, so the relative error of any reported
+ * percentile is at most `2^-bits` (about 3% for 5 bits) across the whole
+ * range from 1 ns to hundreds of years, in a fixed amount of memory.
+ */
+#ifndef ATTO_LATENCY_SUB_BITS
+    #define ATTO_LATENCY_SUB_BITS (5U)
+#endif
+
+/**
+ * Amount of sub-buckets per power-of-two range of latencies.
+ */
+#define ATTO_LATENCY_SUB_BUCKETS (1U << ATTO_LATENCY_SUB_BITS)
+
+/**
+ * Total amount of buckets in the histogram, covering all 64-bit latencies.
+ */
+#define ATTO_LATENCY_BUCKETS ((65U - ATTO_LATENCY_SUB_BITS) * ATTO_LATENCY_SUB_BUCKETS)
+
+/**
+ * Fixed-memory, log-bucketed histogram of latencies in nanoseconds.
+ *
+ * Requires no heap allocations: place it in static memory or on the stack.
+ * Initialise with atto_latency_init(), then record latencies with
+ * atto_latency_record().
+ */
+typedef struct
+{
+    uint64_t counts[ATTO_LATENCY_BUCKETS]; /**< Amount of latencies per bucket. */
+    uint64_t total;                        /**< Amount of recorded latencies. */
+    uint64_t min_ns;                       /**< Exact smallest latency. */
+    uint64_t max_ns;                       /**< Exact largest latency. */
+} atto_latency_t;
+
+/**
+ * Clears the histogram, ready to record new latencies.
+ *
+ * @param hist histogram to clear. Not NULL.
+ */
+void
+atto_latency_init(atto_latency_t* hist);
+
+/**
+ * Records one latency into the histogram.
+ *
+ * @param hist histogram to update. Not NULL.
+ * @param latency_ns measured latency in nanoseconds.
+ */
+void
+atto_latency_record(atto_latency_t* hist, uint64_t latency_ns);
+
+/**
+ * Latency at the given percentile of all recorded latencies.
+ *
+ * The result is the highest latency that falls in the same bucket as the
+ * exact percentile, so it is never smaller than the exact value. It is also
+ * clipped to the exact maximum.
+ *
+ * @param hist histogram to inspect. Not NULL.
+ * @param percentile in [0, 100], e.g. 99.9.
+ * @return latency in nanoseconds at the percentile or 0 if the histogram is
+ * empty.
+ */
+uint64_t
+atto_latency_percentile(const atto_latency_t* hist, double percentile);
+
+/**
+ * Prints the percentile breakdown of the histogram on the current line of the
+ * standard output, without terminating the line.
+ *
+ * Format: `| Samples: 1000 | Min: 10 ns | p50: 12 ns | ... | Max: 95 ns`
+ *
+ * @param hist histogram to print. Not NULL.
+ */
+void
+atto_latency_print(const atto_latency_t* hist);
+
+/**
+ * Verifies if a given percentile of the latencies recorded into a histogram
+ * satisfies the comparison against the limit.
+ *
+ * The comparison operator is passed as is, e.g. `<=` or `<`.
+ * Otherwise stops the test case and reports on standard output, including
+ * the full percentile breakdown of the histogram on the `FAIL` line.
+ * Fails also when no latencies were recorded.
+ *
+ * Example:
+ * ```
+ * atto_latency_hist_p(&hist, 99.0, <=, ATTO_US(200));
+ * ```
+ */
+#define atto_latency_hist_p(hist, percentile, op, limit_ns)                  \
+    atto_assert_details((hist)->total > 0U                                   \
+                            && atto_latency_percentile((hist), (percentile)) \
+                                   op((uint64_t) (limit_ns)),                \
+                        atto_latency_print(hist))
+
+/**
+ * Verifies if a given percentile of the latency of a body of code executed
+ * multiple times satisfies the comparison against the limit.
+ *
+ * The body is the last argument and may contain commas. Each iteration is
+ * timed separately with atto_time_ns() and recorded into a histogram, then
+ * the given percentile is compared against the limit with the given operator
+ * (e.g. `<=` or `<`).
+ *
+ * Otherwise stops the test case and reports on standard output, including
+ * the full percentile breakdown on the `FAIL` line.
+ *
+ * The histogram is a static variable of each assertion, so the macro does not
+ * use the stack nor the heap. The overhead of reading the clock (tens of ns
+ * on most platforms) is included in each measurement.
+ *
+ * Example:
+ * ```
+ * atto_latency_p(99.9, <=, ATTO_US(200), 10000, handle_request(&request));
+ * // FAIL | File: test.c:42 | Test case: test_handler | Samples: 10000
+ * //      | Min: 2100 ns | p50: 2175 ns | ... | p99.9: 251903 ns | Max: ...
+ * ```
+ */
+#define atto_latency_p(percentile, op, limit_ns, iterations, ...)                         \
+    do                                                                                    \
+    {                                                                                     \
+        static atto_latency_t atto_latency_hist;                                          \
+        atto_latency_init(&atto_latency_hist);                                            \
+        for (size_t atto_latency_idx = 0U; atto_latency_idx < (size_t) (iterations);      \
+             atto_latency_idx++)                                                          \
+        {                                                                                 \
+            const uint64_t atto_latency_start = atto_time_ns();                           \
+            __VA_ARGS__;                                                                  \
+            atto_latency_record(&atto_latency_hist, atto_time_ns() - atto_latency_start); \
+        }                                                                                 \
+        atto_latency_hist_p(&atto_latency_hist, (percentile), op, (limit_ns));            \
+    }                                                                                     \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_LATENCY_H */
@@ -0,0 +1,139 @@
+/**
+ * @file
+ * @internal
+ * Atto mem - resident memory (RSS) tracking per test case
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For getrusage(), sysconf() */
+#endif
+
+#include "atto_mem.h"
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <sys/resource.h>
+    #include <unistd.h>
+#elif defined(__APPLE__)
+    #include <mach/mach.h>
+    #include <sys/resource.h>
+#endif
+
+size_t
+atto_mem_rss(void)
+{
+#if defined(__linux__)
+    // Format: "size resident shared text lib data dt", in pages
+    char buffer[128];
+    const int fd = open("/proc/self/statm", O_RDONLY);
+    if (fd < 0)
+    {
+        return 0U;
+    }
+    const ssize_t len = read(fd, buffer, sizeof(buffer) - 1U);
+    close(fd);
+    if (len <= 0)
+    {
+        return 0U;
+    }
+    buffer[len] = '\0';
+    const char* cursor = buffer;
+    while (*cursor != ' ' && *cursor != '\0') { cursor++; }  // Skip size
+    size_t pages = 0U;
+    for (cursor++; *cursor >= '0' && *cursor <= '9'; cursor++)
+    {
+        pages = pages * 10U + (size_t) (*cursor - '0');
+    }
+    return pages * (size_t) sysconf(_SC_PAGESIZE);
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count)
+        != KERN_SUCCESS)
+    {
+        return 0U;
+    }
+    return (size_t) info.resident_size;
+#else
+    return 0U;
+#endif
+}
+
+size_t
+atto_mem_peak_rss(void)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0U;
+    }
+    #if defined(__APPLE__)
+    return (size_t) usage.ru_maxrss;  // Bytes
+    #else
+    return (size_t) usage.ru_maxrss * 1024U;  // KiB
+    #endif
+#else
+    return 0U;
+#endif
+}
+
+static size_t rss_before_test;
+static size_t peak_rss_before_test;
+
+static void
+mem_before(const char* const test_name)
+{
+    (void) test_name;
+    rss_before_test = atto_mem_rss();
+    peak_rss_before_test = atto_mem_peak_rss();
+}
+
+static void
+mem_after(const char* const test_name)
+{
+    const size_t rss = atto_mem_rss();
+    const size_t peak_rss = atto_mem_peak_rss();
+    const long long growth = (long long) rss - (long long) rss_before_test;
+
+    printf("MEMORY | Test case: %s | RSS: %zu kiB | Growth: %+lld kiB"
+           " | Peak RSS: %zu kiB | Peak growth: +%zu kiB\n",
+           test_name,
+           rss / 1024U,
+           growth / 1024,
+           peak_rss / 1024U,
+           (peak_rss - peak_rss_before_test) / 1024U);
+}
+
+int
+atto_mem_track(void)
+{
+    return atto_hook_add(mem_before, mem_after);
+}
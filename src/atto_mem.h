@@ -0,0 +1,119 @@
+/**
+ * @file
+ * Atto mem - resident memory (RSS) tracking per test case
+ *
+ * Supports Linux and macOS, other platforms report 0 bytes.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_MEM_H
+#define ATTO_MEM_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Current Resident Set Size (RSS) of the process, in bytes.
+ *
+ * On Linux read from `/proc/self/statm`, so it is cheap enough to be sampled
+ * around each test case.
+ *
+ * @return the RSS in bytes or 0 if not available on this platform.
+ */
+size_t
+atto_mem_rss(void);
+
+/**
+ * Peak Resident Set Size of the process since its start, in bytes.
+ *
+ * Obtained with `getrusage()`. Note that it can only increase.
+ *
+ * @return the peak RSS in bytes or 0 if not available on this platform.
+ */
+size_t
+atto_mem_peak_rss(void);
+
+/**
+ * Enables the per-test-case memory report.
+ *
+ * Registers hooks with atto_hook_add(), so each test case launched with
+ * atto_run() afterwards prints one line with its RSS growth and peak RSS
+ * growth on standard output:
+ *
+ * ```
+ * MEMORY | Test case: test_cache | RSS: 10240 kiB | Growth: +8192 kiB | Peak RSS: 10240 kiB | Peak growth: +8192 kiB
+ * ```
+ *
+ * An unbounded cache shows up as a steady growth at each test case, instead
+ * of only as a large process at the end of the test suite.
+ *
+ * @return 0 on success, 1 if no more hooks could be registered.
+ */
+int
+atto_mem_track(void);
+
+/**
+ * Verifies if executing the body grows the RSS of the process by at most
+ * the given amount of bytes.
+ *
+ * The body is the last argument and may contain commas. The RSS is sampled
+ * right before and after it. The RSS grows by whole memory pages and the
+ * allocator may keep freed memory, so leave some slack in the limit.
+ *
+ * Otherwise stops the test case and reports on standard output, including
+ * the RSS growth on the `FAIL` line.
+ * Always passes on platforms where the RSS is not available.
+ *
+ * Example:
+ * ```
+ * atto_max_rss_growth(1024 * 1024, cache_insert_many(&cache, 100000));
+ * ```
+ */
+#define atto_max_rss_growth(bytes, ...)                                           \
+    do                                                                            \
+    {                                                                             \
+        const size_t atto_rss_before = atto_mem_rss();                            \
+        __VA_ARGS__;                                                              \
+        const size_t atto_rss_after = atto_mem_rss();                             \
+        atto_assert_details(atto_rss_after <= atto_rss_before + (size_t) (bytes), \
+                            printf(" | RSS growth: %zu B | Limit: %zu B",         \
+                                   atto_rss_after - atto_rss_before,              \
+                                   (size_t) (bytes)));                            \
+    }                                                                             \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_MEM_H */
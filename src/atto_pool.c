@@ -0,0 +1,136 @@
+/**
+ * @file
+ * @internal
+ * Atto pool - splits a job across forked worker processes
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For fork() */
+#endif
+
+#include "atto_pool.h"
+#include <sys/wait.h> /* For waitpid() */
+#include <unistd.h>   /* For fork(), pipe(), close() */
+
+/** Outcome of a worker process, sent back to the parent through a pipe. */
+typedef struct
+{
+    size_t checked;
+    size_t passes;
+    size_t failures;
+} worker_result_t;
+
+/** Runs a share of the job in the forked worker, then exits it. */
+static void
+run_worker(const atto_pool_job_fn job,
+           void* const ctx,
+           const size_t worker,
+           const size_t workers,
+           const int fd)
+{
+    worker_result_t result;
+    const size_t passes = atto_counter_assert_passes;
+    const size_t failures = atto_counter_assert_failures;
+    result.checked = job(ctx, worker, workers);
+    result.passes = atto_counter_assert_passes - passes;
+    result.failures = atto_counter_assert_failures - failures;
+    fflush(stdout);
+    _exit(write(fd, &result, sizeof(result)) != (ssize_t) sizeof(result));
+}
+
+size_t
+atto_pool_run(const atto_pool_job_fn job,
+              const atto_pool_crash_fn crashed,
+              void* const ctx,
+              size_t workers)
+{
+    if (workers <= 1U)
+    {
+        return job(ctx, 0U, 1U);
+    }
+    workers = workers > ATTO_POOL_MAX_WORKERS ? ATTO_POOL_MAX_WORKERS : workers;
+
+    pid_t pids[ATTO_POOL_MAX_WORKERS];
+    int pipes[ATTO_POOL_MAX_WORKERS];
+    size_t checked = 0U;
+    fflush(stdout);  // Otherwise duplicated by each worker
+    for (size_t w = 0U; w < workers; w++)
+    {
+        int fds[2];
+        pids[w] = -1;
+        if (pipe(fds) == 0)
+        {
+            pids[w] = fork();
+            if (pids[w] == 0)
+            {
+                close(fds[0]);
+                run_worker(job, ctx, w, workers, fds[1]);
+            }
+            close(fds[1]);
+            if (pids[w] < 0)
+            {
+                close(fds[0]);
+            }
+        }
+        pipes[w] = fds[0];
+        if (pids[w] < 0)
+        {
+            checked += job(ctx, w, workers);  // No worker: do it here
+        }
+    }
+    for (size_t w = 0U; w < workers; w++)
+    {
+        if (pids[w] < 0)
+        {
+            continue;
+        }
+        worker_result_t result;
+        const int received = read(pipes[w], &result, sizeof(result)) == (ssize_t) sizeof(result);
+        close(pipes[w]);
+        waitpid(pids[w], NULL, 0);
+        if (received)
+        {
+            checked += result.checked;
+            atto_counter_assert_passes += result.passes;
+            atto_counter_assert_failures += result.failures;
+            if (result.failures > 0U)
+            {
+                atto_at_least_one_fail = 1;
+            }
+        }
+        else
+        {
+            crashed(ctx, w);
+            atto_counter_assert_failures++;
+            atto_at_least_one_fail = 1;
+        }
+    }
+    return checked;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * Atto pool - splits a job across forked worker processes
+ *
+ * Requires POSIX `fork()` and pipes. Shared by the modules running many
+ * independent checks in parallel, such as atto_vec.h and atto_fuzz.h: each
+ * worker process runs its share of the job and sends back its counters of
+ * passed and failed assertions, which are added to the ones of the calling
+ * process. A crashing worker counts as a failed assertion instead of
+ * stopping the test suite.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_POOL_H
+#define ATTO_POOL_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of worker processes of atto_pool_run().
+ */
+#ifndef ATTO_POOL_MAX_WORKERS
+    #define ATTO_POOL_MAX_WORKERS (64U)
+#endif
+
+/**
+ * Share of the job run by one worker.
+ *
+ * @param ctx user context given to atto_pool_run().
+ * @param worker index of the worker in [0, workers).
+ * @param workers total amount of workers.
+ * @return amount of checked items, e.g. records or inputs, summed up by
+ * atto_pool_run().
+ */
+typedef size_t (*atto_pool_job_fn)(void* ctx, size_t worker, size_t workers);
+
+/**
+ * Reports a worker which crashed or exited without sending its counters,
+ * e.g. printing which part of the job it was running.
+ *
+ * @param ctx user context given to atto_pool_run().
+ * @param worker index of the worker in [0, workers).
+ */
+typedef void (*atto_pool_crash_fn)(void* ctx, size_t worker);
+
+/**
+ * Runs each share of a job in a forked worker process and waits for all
+ * of them.
+ *
+ * The standard output is flushed before forking, so it is not duplicated by
+ * each worker. A share whose worker cannot be forked runs in the calling
+ * process instead, after forking the next ones. With 0 or 1 workers the
+ * whole job runs in the calling process.
+ *
+ * Each crashed worker is reported with \p crashed and counted as 1 failed
+ * assertion, as its own counters are lost.
+ *
+ * Only the counters come back from the workers: any other state they record,
+ * e.g. the events of atto_trace.h, is lost with them.
+ *
+ * @param job share of the job. Not NULL.
+ * @param crashed crash reporter. Not NULL.
+ * @param ctx user context passed to \p job and \p crashed. May be NULL.
+ * @param workers amount of worker processes, up to #ATTO_POOL_MAX_WORKERS.
+ * @return sum of the amounts returned by all shares of the job.
+ */
+size_t
+atto_pool_run(atto_pool_job_fn job, atto_pool_crash_fn crashed, void* ctx, size_t workers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_POOL_H */
@@ -0,0 +1,448 @@
+/**
+ * @file
+ * @internal
+ * Atto schedule - longest-first ordering and sharding of test cases based on
+ * the durations measured in previous runs
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_schedule.h"
+#include <stdlib.h> /* For qsort(), getenv(), strtoul() */
+
+/** First bytes of the timing file, including the format version. */
+static const char timing_magic[8] = {'A', 'T', 'T', 'O', 'T', 'D', 'B', '1'};
+
+/** Duration of a test case, as stored in the timing file. */
+typedef struct
+{
+    uint64_t hash;
+    uint64_t duration_ns;
+} record_t;
+
+/** Registered test case. */
+typedef struct
+{
+    atto_test_fn test;
+    const char* name;
+    uint64_t hash;
+    uint64_t duration_ns;
+    size_t shard;
+} entry_t;
+
+static entry_t tests[ATTO_SCHEDULE_MAX_TESTS];
+static size_t tests_amount = 0U;
+static record_t records[ATTO_SCHEDULE_MAX_TESTS];
+static size_t records_amount = 0U;
+static record_t file_records[ATTO_SCHEDULE_MAX_TESTS];
+static size_t file_records_amount = 0U;
+static uint64_t shard_loads[ATTO_SCHEDULE_MAX_TESTS];
+
+/** FNV-1a hash of the test case name. */
+static uint64_t
+name_hash(const char* name)
+{
+    uint64_t hash = UINT64_C(0xCBF29CE484222325);
+    for (; *name != '\0'; name++)
+    {
+        hash ^= (uint64_t) (unsigned char) *name;
+        hash *= UINT64_C(0x100000001B3);
+    }
+    return hash;
+}
+
+/** Record with the given hash or NULL if not found. */
+static record_t*
+find_record(const uint64_t hash)
+{
+    for (size_t i = 0U; i < records_amount; i++)
+    {
+        if (records[i].hash == hash)
+        {
+            return &records[i];
+        }
+    }
+    return NULL;
+}
+
+/** Whether a test case with the given hash is registered. */
+static int
+is_registered(const uint64_t hash)
+{
+    for (size_t i = 0U; i < tests_amount; i++)
+    {
+        if (tests[i].hash == hash)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** Drops the records of test cases not registered, e.g. deleted or renamed. */
+static void
+prune_records(void)
+{
+    size_t kept = 0U;
+    for (size_t i = 0U; i < records_amount; i++)
+    {
+        if (is_registered(records[i].hash))
+        {
+            records[kept++] = records[i];
+        }
+    }
+    records_amount = kept;
+}
+
+/**
+ * Stores a measured duration, replacing any older one. With the table full,
+ * the records of unregistered test cases make room for it.
+ */
+static void
+store_record(const uint64_t hash, const uint64_t duration_ns)
+{
+    record_t* record = find_record(hash);
+    if (record == NULL && records_amount >= ATTO_SCHEDULE_MAX_TESTS)
+    {
+        prune_records();
+    }
+    if (record == NULL && records_amount < ATTO_SCHEDULE_MAX_TESTS)
+    {
+        record = &records[records_amount++];
+        record->hash = hash;
+    }
+    if (record != NULL)
+    {
+        record->duration_ns = duration_ns;
+    }
+}
+
+int
+atto_schedule_add(const atto_test_fn test, const char* const name)
+{
+    if (tests_amount >= ATTO_SCHEDULE_MAX_TESTS)
+    {
+        return 1;
+    }
+    tests[tests_amount].test = test;
+    tests[tests_amount].name = name;
+    tests[tests_amount].hash = name_hash(name);
+    tests_amount++;
+    return 0;
+}
+
+/** Reads a whole timing file into file_records, 1 if missing or corrupted. */
+static int
+read_file(const char* const path)
+{
+    FILE* const file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return 1;
+    }
+    char magic[sizeof(timing_magic)];
+    uint64_t amount = 0U;
+    int error = fread(magic, sizeof(magic), 1U, file) != 1U
+                || memcmp(magic, timing_magic, sizeof(magic)) != 0
+                || fread(&amount, sizeof(amount), 1U, file) != 1U
+                || amount > ATTO_SCHEDULE_MAX_TESTS;
+    file_records_amount = error ? 0U : (size_t) amount;
+    if (!error && file_records_amount > 0U)
+    {
+        error = fread(file_records, sizeof(file_records[0]), file_records_amount, file)
+                != file_records_amount;
+    }
+    fclose(file);
+    return error;
+}
+
+/**
+ * Replaces a timing file atomically: written to a temporary file first, then
+ * renamed over it, so concurrent readers see either the old or the new one.
+ */
+static int
+write_file(const char* const path, const record_t* const written, const size_t amount)
+{
+    char temp_path[FILENAME_MAX];
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int) sizeof(temp_path))
+    {
+        return 1;
+    }
+    FILE* const file = fopen(temp_path, "wb");
+    if (file == NULL)
+    {
+        return 1;
+    }
+    const uint64_t amount64 = (uint64_t) amount;
+    int error = fwrite(timing_magic, sizeof(timing_magic), 1U, file) != 1U
+                || fwrite(&amount64, sizeof(amount64), 1U, file) != 1U;
+    if (!error && amount > 0U)
+    {
+        error = fwrite(written, sizeof(written[0]), amount, file) != amount;
+    }
+    error |= fclose(file) != 0;
+    if (!error && rename(temp_path, path) != 0)
+    {
+        // Windows does not rename over an existing file
+        remove(path);
+        error = rename(temp_path, path) != 0;
+    }
+    if (error)
+    {
+        remove(temp_path);
+    }
+    return error;
+}
+
+/** Path of the timing file of a shard, 1 if it does not fit. */
+static int
+shard_path(char* const buffer, const char* const path, const size_t shard)
+{
+    return snprintf(buffer, FILENAME_MAX, "%s.%zu", path, shard) >= FILENAME_MAX;
+}
+
+int
+atto_schedule_load(const char* const path)
+{
+    const int error = read_file(path);
+    records_amount = 0U;  // Do not trust a corrupted file at all
+    for (size_t i = 0U; !error && i < file_records_amount; i++)
+    {
+        store_record(file_records[i].hash, file_records[i].duration_ns);
+    }
+    return error;
+}
+
+int
+atto_schedule_save(const char* const path)
+{
+    prune_records();
+    return write_file(path, records, records_amount);
+}
+
+int
+atto_schedule_save_shard(const char* const path, const size_t shard)
+{
+    char path_of_shard[FILENAME_MAX];
+    size_t amount = 0U;
+
+    for (size_t i = 0U; i < tests_amount; i++)
+    {
+        const record_t* const record = find_record(tests[i].hash);
+        if (tests[i].shard == shard && record != NULL)
+        {
+            file_records[amount++] = *record;
+        }
+    }
+    if (shard_path(path_of_shard, path, shard))
+    {
+        return 1;
+    }
+    return write_file(path_of_shard, file_records, amount);
+}
+
+int
+atto_schedule_merge(const char* const path, const size_t shards)
+{
+    char path_of_shard[FILENAME_MAX];
+
+    atto_schedule_load(path);
+    for (size_t shard = 0U; shard < shards; shard++)
+    {
+        if (shard_path(path_of_shard, path, shard) || read_file(path_of_shard) != 0)
+        {
+            continue;  // The shard did not run or failed to save: keep the old durations
+        }
+        for (size_t i = 0U; i < file_records_amount; i++)
+        {
+            store_record(file_records[i].hash, file_records[i].duration_ns);
+        }
+    }
+    prune_records();
+    if (write_file(path, records, records_amount) != 0)
+    {
+        return 1;
+    }
+    for (size_t shard = 0U; shard < shards; shard++)
+    {
+        if (!shard_path(path_of_shard, path, shard))
+        {
+            remove(path_of_shard);
+        }
+    }
+    return 0;
+}
+
+/** Sorts known durations first, longest first, then by registration. */
+static int
+compare_entries(const void* const a, const void* const b)
+{
+    const entry_t* const x = &tests[*(const size_t*) a];
+    const entry_t* const y = &tests[*(const size_t*) b];
+    const int x_known = x->duration_ns != 0U;
+    const int y_known = y->duration_ns != 0U;
+    if (x_known != y_known)
+    {
+        return y_known - x_known;
+    }
+    if (x->duration_ns != y->duration_ns)
+    {
+        return x->duration_ns < y->duration_ns ? 1 : -1;
+    }
+    const size_t x_index = *(const size_t*) a;
+    const size_t y_index = *(const size_t*) b;
+    return (x_index > y_index) - (x_index < y_index);
+}
+
+void
+atto_schedule_run(const size_t shard, size_t shards)
+{
+    static size_t order[ATTO_SCHEDULE_MAX_TESTS];
+    uint64_t known_sum = 0U;
+    size_t known = 0U;
+
+    shards = shards == 0U ? 1U : shards;
+    shards = shards > ATTO_SCHEDULE_MAX_TESTS ? ATTO_SCHEDULE_MAX_TESTS : shards;
+    for (size_t i = 0U; i < tests_amount; i++)
+    {
+        const record_t* const record = find_record(tests[i].hash);
+        tests[i].duration_ns = record == NULL ? 0U : record->duration_ns;
+        known += tests[i].duration_ns != 0U;
+        known_sum += tests[i].duration_ns;
+        order[i] = i;
+    }
+    qsort(order, tests_amount, sizeof(order[0]), compare_entries);
+
+    // Longest Processing Time first: each to the least loaded shard so far
+    const uint64_t average_ns = known == 0U ? 1U : known_sum / known;
+    memset(shard_loads, 0, shards * sizeof(shard_loads[0]));
+    for (size_t i = 0U; i < tests_amount; i++)
+    {
+        entry_t* const entry = &tests[order[i]];
+        size_t lightest = 0U;
+        for (size_t s = 1U; s < shards; s++)
+        {
+            lightest = shard_loads[s] < shard_loads[lightest] ? s : lightest;
+        }
+        entry->shard = lightest;
+        shard_loads[lightest] += entry->duration_ns != 0U ? entry->duration_ns : average_ns;
+    }
+
+    size_t shard_tests = 0U;
+    size_t shard_known = 0U;
+    uint64_t expected_ns = 0U;
+    for (size_t i = 0U; i < tests_amount; i++)
+    {
+        if (tests[i].shard == shard)
+        {
+            shard_tests++;
+            shard_known += tests[i].duration_ns != 0U;
+            expected_ns += tests[i].duration_ns;
+        }
+    }
+    printf("SCHEDULE | Shard: %zu/%zu | Tests: %zu | Known: %zu | Expected: %llu ms\n",
+           shard,
+           shards,
+           shard_tests,
+           shard_known,
+           (unsigned long long) (expected_ns / 1000000U));
+
+    for (size_t i = 0U; i < tests_amount; i++)
+    {
+        const entry_t* const entry = &tests[order[i]];
+        if (entry->shard == shard)
+        {
+            const uint64_t start = atto_time_ns();
+            atto_run_test(entry->test, entry->name);
+            const uint64_t duration_ns = atto_time_ns() - start;
+            store_record(entry->hash, duration_ns == 0U ? 1U : duration_ns);
+        }
+    }
+}
+
+void
+atto_schedule_main(const char* const path)
+{
+    size_t shard = 0U;
+    size_t shards = 1U;
+    const char* const env = getenv("ATTO_SHARD");
+    if (env != NULL && strncmp(env, "merge/", 6U) == 0)
+    {
+        const unsigned long total = strtoul(env + 6, NULL, 10);
+        if (atto_schedule_merge(path, (size_t) total) != 0)
+        {
+            printf("SCHEDULE | Could not merge the timing files of %lu shards\n", total);
+        }
+        return;
+    }
+    if (env != NULL)
+    {
+        char* separator = NULL;
+        const unsigned long index = strtoul(env, &separator, 10);
+        const unsigned long total = *separator == '/' ? strtoul(separator + 1, NULL, 10) : 0U;
+        if (total > 0U && index < total)
+        {
+            shard = (size_t) index;
+            shards = (size_t) total;
+        }
+        else
+        {
+            printf("SCHEDULE | Invalid ATTO_SHARD: %s | Running all test cases\n", env);
+        }
+    }
+    atto_schedule_load(path);
+    atto_schedule_run(shard, shards);
+    if (shards > 1U)
+    {
+        atto_schedule_save_shard(path, shard);
+    }
+    else
+    {
+        atto_schedule_save(path);
+    }
+}
+
+uint64_t
+atto_schedule_duration_ns(const char* const name)
+{
+    const record_t* const record = find_record(name_hash(name));
+    return record == NULL ? 0U : record->duration_ns;
+}
+
+void
+atto_schedule_set_duration_ns(const char* const name, const uint64_t duration_ns)
+{
+    store_record(name_hash(name), duration_ns);
+}
+
+void
+atto_schedule_clear(void)
+{
+    tests_amount = 0U;
+    records_amount = 0U;
+}
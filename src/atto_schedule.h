@@ -0,0 +1,235 @@
+/**
+ * @file
+ * Atto schedule - longest-first ordering and sharding of test cases based on
+ * the durations measured in previous runs
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_SCHEDULE_H
+#define ATTO_SCHEDULE_H
+
+#include "atto.h"
+#include "atto_time.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of test cases that can be registered, which is also the
+ * maximum amount of durations kept in the timing file.
+ */
+#ifndef ATTO_SCHEDULE_MAX_TESTS
+    #define ATTO_SCHEDULE_MAX_TESTS (1024U)
+#endif
+
+/**
+ * Registers a test case to be launched later by atto_schedule_run().
+ *
+ * The test cases are identified in the timing file by the hash of their name.
+ *
+ * @param test test case function. Not NULL.
+ * @param name name of the test case, unique. Not NULL.
+ * @return 0 on success, 1 if #ATTO_SCHEDULE_MAX_TESTS test cases are already
+ * registered.
+ */
+int
+atto_schedule_add(atto_test_fn test, const char* name);
+
+/**
+ * Registers a test case to be launched later by atto_schedule_run(), using
+ * the function name as test case name.
+ *
+ * Example:
+ * ```
+ * atto_schedule(test_parser);
+ * atto_schedule(test_full_database_migration);  // Slow
+ * ```
+ */
+#define atto_schedule(test) atto_schedule_add((test), #test)
+
+/**
+ * Loads the durations measured by previous runs from a binary timing file.
+ *
+ * A missing or corrupted file is not an error for the test suite: all test
+ * cases are just considered without a known duration.
+ *
+ * The file stores native-endian 64-bit integers: it is a cache of the
+ * machine running the tests, not a portable format.
+ *
+ * @param path timing file, as written by atto_schedule_save(). Not NULL.
+ * @return 0 if the file was loaded, 1 if it could not be read or is invalid.
+ */
+int
+atto_schedule_load(const char* path);
+
+/**
+ * Saves the durations into a binary timing file.
+ *
+ * Stores the durations measured by atto_schedule_run() and keeps the loaded
+ * durations of the other registered test cases. The durations of test cases
+ * not registered, e.g. deleted or renamed, are dropped, so the file does not
+ * fill up with them.
+ *
+ * The file is written under the same path with a `.tmp` suffix first, then
+ * renamed over the old one, so a concurrent atto_schedule_load() reads
+ * either the old or the new file, never a partial one.
+ *
+ * @param path timing file to overwrite. Not NULL.
+ * @return 0 on success, 1 if the file could not be written.
+ */
+int
+atto_schedule_save(const char* path);
+
+/**
+ * Saves only the durations measured by one shard into its own timing file,
+ * the path of the shared one with the `.<shard>` suffix, e.g.
+ * `atto_timing.bin.2`.
+ *
+ * Concurrent shards must not save into the shared timing file: the last
+ * one would discard the durations of the others, and the shards starting
+ * later would load different durations and so compute different
+ * assignments. Each saves into its own file instead, merged into the
+ * shared one with atto_schedule_merge() once all shards are done.
+ *
+ * @param path shared timing file, as given to atto_schedule_load(). Not NULL.
+ * @param shard index of the shard given to atto_schedule_run().
+ * @return 0 on success, 1 if the file could not be written.
+ */
+int
+atto_schedule_save_shard(const char* path, size_t shard);
+
+/**
+ * Merges the timing files of the shards into the shared one, then deletes
+ * them.
+ *
+ * The durations of each shard replace the ones in the shared file, while
+ * test cases of shards without a timing file keep their old durations.
+ * Replaces the registered durations with the merged ones. As with
+ * atto_schedule_save(), only the durations of registered test cases are
+ * kept, so register them before merging.
+ *
+ * @param path shared timing file. Not NULL.
+ * @param shards total amount of shards.
+ * @return 0 on success, 1 if the shared file could not be written, in which
+ * case the files of the shards are kept.
+ */
+int
+atto_schedule_merge(const char* path, size_t shards);
+
+/**
+ * Launches the registered test cases of one shard with atto_run(), measuring
+ * the duration of each.
+ *
+ * The test cases with a known duration are sorted longest-first and each is
+ * assigned to the shard with the least total duration so far, i.e. Longest
+ * Processing Time first scheduling. Then the ones without a known duration
+ * are assigned in registration order, each counted as the average known
+ * duration. Within a shard the longest test cases run first, the ones without
+ * a known duration last in registration order. With no known durations and a
+ * single shard, the order is simply the registration order.
+ *
+ * Prints a `SCHEDULE` line with the shard, the amount of its test cases, how
+ * many have a known duration and its expected total duration.
+ *
+ * Example:
+ * ```
+ * atto_schedule_load("atto_timing.bin");
+ * atto_schedule_run(0U, 1U);
+ * atto_schedule_save("atto_timing.bin");
+ * // SCHEDULE | Shard: 0/1 | Tests: 120 | Known: 118 | Expected: 31250 ms
+ * ```
+ *
+ * @param shard index of the shard to run in [0, shards).
+ * @param shards total amount of shards (workers) the test suite is split
+ * into, at least 1.
+ */
+void
+atto_schedule_run(size_t shard, size_t shards);
+
+/**
+ * Launches the shard selected by the `ATTO_SHARD` environment variable,
+ * formatted as `index/total` (e.g. `ATTO_SHARD=2/4`), or all test cases when
+ * not set.
+ *
+ * Loads the timing file before the run. Without sharding, saves it after
+ * the run; a shard saves only its own durations with
+ * atto_schedule_save_shard() instead, so all shards of a run compute their
+ * assignment from the same shared file. Once all shards are done, running
+ * with `ATTO_SHARD=merge/total` (e.g. `ATTO_SHARD=merge/4`) launches no
+ * test case and merges their durations with atto_schedule_merge().
+ *
+ * Example:
+ * ```
+ * int main(void)
+ * {
+ *     atto_schedule(test_parser);
+ *     atto_schedule(test_full_database_migration);
+ *     atto_schedule_main("atto_timing.bin");
+ *     return atto_at_least_one_fail;
+ * }
+ * ```
+ *
+ * @param path timing file. Not NULL.
+ */
+void
+atto_schedule_main(const char* path);
+
+/**
+ * Duration of the test case measured by the last run or loaded from the
+ * timing file.
+ *
+ * @param name name of the test case. Not NULL.
+ * @return the duration in nanoseconds or 0 if unknown.
+ */
+uint64_t
+atto_schedule_duration_ns(const char* name);
+
+/**
+ * Sets the duration of a test case as if measured, e.g. to estimate a new
+ * test case known to be slow before its first run.
+ *
+ * @param name name of the test case. Not NULL.
+ * @param duration_ns the duration in nanoseconds, 0 to make it unknown.
+ */
+void
+atto_schedule_set_duration_ns(const char* name, uint64_t duration_ns);
+
+/**
+ * Forgets all registered test cases and all durations.
+ */
+void
+atto_schedule_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_SCHEDULE_H */
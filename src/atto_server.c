@@ -0,0 +1,493 @@
+/**
+ * @file
+ * @internal
+ * Atto server - long-lived host reloading and rerunning test suites
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For strtok_r(), mkstemp(), struct stat.st_mtim */
+#endif
+
+#include "atto_server.h"
+#include "atto_time.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/** Name of the entry point of each suite. */
+#define SUITE_ENTRY_POINT "atto_suite_register"
+
+/** Loaded suite, with the identity of its file to detect rebuilds. */
+typedef struct
+{
+    int loaded;
+    char path[ATTO_SERVER_MAX_COMMAND];
+    void* handle;
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec modified;
+    atto_suite_t suite;
+} server_suite_t;
+
+static server_suite_t suites[ATTO_SERVER_MAX_SUITES];
+
+/** Counters of a run, started by start_run(). */
+static struct
+{
+    size_t tests;
+    size_t passes;
+    size_t failures;
+    uint64_t start_ns;
+} current_run;
+
+int
+atto_suite_add_test(atto_suite_t* const suite, const atto_test_fn test, const char* const name)
+{
+    if (suite->amount >= ATTO_SERVER_MAX_TESTS)
+    {
+        return 1;
+    }
+    suite->tests[suite->amount].name = name;
+    suite->tests[suite->amount].test = test;
+    suite->amount++;
+    return 0;
+}
+
+/** Loaded suite with the given path, NULL if none. */
+static server_suite_t*
+find_suite(const char* const path)
+{
+    for (size_t i = 0U; i < ATTO_SERVER_MAX_SUITES; i++)
+    {
+        if (suites[i].loaded && strcmp(suites[i].path, path) == 0)
+        {
+            return &suites[i];
+        }
+    }
+    return NULL;
+}
+
+/** Whether the file of the suite was replaced or modified since loading it. */
+static int
+is_rebuilt(const server_suite_t* const suite)
+{
+    struct stat status;
+    if (stat(suite->path, &status) != 0)
+    {
+        return 0;  // Deleted, e.g. in the middle of a rebuild: keep the old one
+    }
+    return status.st_dev != suite->device || status.st_ino != suite->inode
+           || status.st_size != suite->size
+           || status.st_mtim.tv_sec != suite->modified.tv_sec
+           || status.st_mtim.tv_nsec != suite->modified.tv_nsec;
+}
+
+/** Unloads the shared object of the suite. */
+static void
+unload_suite(server_suite_t* const suite)
+{
+    dlclose(suite->handle);
+    suite->loaded = 0;
+}
+
+/** Copies a whole file, returning 0 on success. */
+static int
+copy_file(const int source, const int destination)
+{
+    char buffer[4096];
+    ssize_t received = 0;
+    while ((received = read(source, buffer, sizeof(buffer))) > 0)
+    {
+        for (ssize_t written = 0; written < received;)
+        {
+            const ssize_t result
+                = write(destination, buffer + written, (size_t) (received - written));
+            if (result < 0)
+            {
+                return 1;
+            }
+            written += result;
+        }
+    }
+    return received != 0;
+}
+
+/**
+ * Opens a private copy of the shared object, so its new image is mapped while
+ * the old one is still loaded: `dlopen()` of the same path would return the
+ * old one. The copy is deleted right away, the mapping staying valid.
+ */
+static void*
+open_image(const char* const path, struct stat* const status)
+{
+    char copy_path[ATTO_SERVER_MAX_COMMAND + 8U];
+    snprintf(copy_path, sizeof(copy_path), "%s.XXXXXX", path);
+    const int source = open(path, O_RDONLY | O_CLOEXEC);
+    const int copy = source < 0 ? -1 : mkstemp(copy_path);
+    // Identity of the copied file, as read, for is_rebuilt()
+    int error = copy < 0 || fstat(source, status) != 0 || copy_file(source, copy);
+    if (source >= 0)
+    {
+        close(source);
+    }
+    if (copy >= 0)
+    {
+        error |= close(copy) != 0;
+    }
+    void* const handle = error ? NULL : dlopen(copy_path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL)
+    {
+        printf("SERVER | Error: %s\n", error ? "cannot copy the suite" : dlerror());
+    }
+    if (copy >= 0)
+    {
+        unlink(copy_path);
+    }
+    return handle;
+}
+
+/** Loads or reloads a suite, returning NULL on error with the old one kept loaded. */
+static server_suite_t*
+load_suite(const char* const path)
+{
+    server_suite_t* suite = find_suite(path);
+    for (size_t i = 0U; i < ATTO_SERVER_MAX_SUITES && suite == NULL; i++)
+    {
+        suite = suites[i].loaded ? NULL : &suites[i];
+    }
+    if (suite == NULL || strlen(path) >= sizeof(suite->path))
+    {
+        printf("SERVER | Error: cannot load %s\n", path);
+        return NULL;
+    }
+    struct stat status;
+    void* const handle = open_image(path, &status);
+    if (handle == NULL)
+    {
+        return NULL;
+    }
+    // Converting from void* through a union, as ISO C forbids the cast
+    union
+    {
+        void* object;
+        void (*function)(atto_suite_t*);
+    } entry_point = {.object = dlsym(handle, SUITE_ENTRY_POINT)};
+    if (entry_point.object == NULL)
+    {
+        printf("SERVER | Error: %s does not define %s()\n", path, SUITE_ENTRY_POINT);
+        dlclose(handle);
+        return NULL;
+    }
+    // The new image is usable: replacing the old one
+    if (suite->loaded)
+    {
+        unload_suite(suite);
+    }
+    if (suite->path != path)
+    {
+        strcpy(suite->path, path);  // Not when reloading from run_rebuilt()
+    }
+    suite->handle = handle;
+    suite->device = status.st_dev;
+    suite->inode = status.st_ino;
+    suite->size = status.st_size;
+    suite->modified = status.st_mtim;
+    suite->suite.amount = 0U;
+    entry_point.function(&suite->suite);
+    suite->loaded = 1;
+    return suite;
+}
+
+int
+atto_server_load(const char* const path)
+{
+    return load_suite(path) == NULL;
+}
+
+/** Starts counting the test cases and assertions of a run. */
+static void
+start_run(void)
+{
+    current_run.tests = 0U;
+    current_run.passes = atto_counter_assert_passes;
+    current_run.failures = atto_counter_assert_failures;
+    current_run.start_ns = atto_time_ns();
+}
+
+/** Runs the test cases of the suite, all of them if the name is NULL. */
+static void
+run_suite(const server_suite_t* const suite, const char* const test_name)
+{
+    for (size_t i = 0U; i < suite->suite.amount; i++)
+    {
+        const atto_suite_test_t* const test = &suite->suite.tests[i];
+        if (test_name == NULL || strcmp(test->name, test_name) == 0)
+        {
+            atto_run_test(test->test, test->name);
+            current_run.tests++;
+        }
+    }
+}
+
+/** Prints the summary line of the run. */
+static void
+end_run(void)
+{
+    printf("SERVER | Tests: %zu | Passes: %zu | Failures: %zu | Duration: %llu us\n",
+           current_run.tests,
+           atto_counter_assert_passes - current_run.passes,
+           atto_counter_assert_failures - current_run.failures,
+           (unsigned long long) ((atto_time_ns() - current_run.start_ns) / 1000U));
+}
+
+/** Reloads the rebuilt suites and runs them. */
+static int
+run_rebuilt(void)
+{
+    int error = 0;
+    start_run();
+    for (size_t i = 0U; i < ATTO_SERVER_MAX_SUITES; i++)
+    {
+        if (suites[i].loaded && is_rebuilt(&suites[i]))
+        {
+            printf("SERVER | Reloading: %s\n", suites[i].path);
+            if (atto_server_load(suites[i].path) == 0)
+            {
+                run_suite(&suites[i], NULL);
+            }
+            else
+            {
+                error = 1;
+            }
+        }
+    }
+    end_run();
+    return error;
+}
+
+/** Runs one suite, loading it if needed, or one of its test cases. */
+static int
+run_one(const char* const path, const char* const test_name)
+{
+    const server_suite_t* suite = find_suite(path);
+    if (suite == NULL || is_rebuilt(suite))
+    {
+        suite = load_suite(path);
+        if (suite == NULL)
+        {
+            return 1;
+        }
+    }
+    start_run();
+    run_suite(suite, test_name);
+    end_run();
+    if (test_name != NULL && current_run.tests == 0U)
+    {
+        printf("SERVER | Error: no test case %s in %s\n", test_name, path);
+        return 1;
+    }
+    return 0;
+}
+
+/** Prints one line per test case of each loaded suite. */
+static void
+list_suites(void)
+{
+    for (size_t i = 0U; i < ATTO_SERVER_MAX_SUITES; i++)
+    {
+        for (size_t t = 0U; suites[i].loaded && t < suites[i].suite.amount; t++)
+        {
+            printf("SERVER | Suite: %s | Test case: %s\n",
+                   suites[i].path,
+                   suites[i].suite.tests[t].name);
+        }
+    }
+}
+
+int
+atto_server_command(const char* const command)
+{
+    char line[ATTO_SERVER_MAX_COMMAND];
+    strncpy(line, command, sizeof(line) - 1U);
+    line[sizeof(line) - 1U] = '\0';
+    char* words[3] = {NULL, NULL, NULL};
+    char* position = NULL;
+    words[0] = strtok_r(line, " \t\r\n", &position);
+    for (size_t i = 1U; i < 3U && words[i - 1U] != NULL; i++)
+    {
+        words[i] = strtok_r(NULL, " \t\r\n", &position);
+    }
+    const char* const verb = words[0] == NULL ? "" : words[0];
+    int result = 1;
+    if (strcmp(verb, "run") == 0)
+    {
+        result = words[1] == NULL ? run_rebuilt() : run_one(words[1], words[2]);
+    }
+    else if (strcmp(verb, "load") == 0 && words[1] != NULL)
+    {
+        result = atto_server_load(words[1]);
+    }
+    else if (strcmp(verb, "unload") == 0 && words[1] != NULL && find_suite(words[1]) != NULL)
+    {
+        unload_suite(find_suite(words[1]));
+        result = 0;
+    }
+    else if (strcmp(verb, "list") == 0)
+    {
+        list_suites();
+        result = 0;
+    }
+    else if (strcmp(verb, "quit") == 0)
+    {
+        result = 2;
+    }
+    else
+    {
+        printf("SERVER | Error: invalid command: %s\n", verb);
+    }
+    return result;
+}
+
+/**
+ * Reads one command from the connection, up to a newline or the end, within
+ * #ATTO_SERVER_READ_TIMEOUT_MS. Returns 0 on success, 1 if it timed out or
+ * was too long.
+ */
+static int
+read_command(const int connection, char* const command, const size_t size)
+{
+    const struct timeval timeout = {
+        .tv_sec = (time_t) (ATTO_SERVER_READ_TIMEOUT_MS / 1000U),
+        .tv_usec = (suseconds_t) (ATTO_SERVER_READ_TIMEOUT_MS % 1000U * 1000U),
+    };
+    // The timeout applies to each read, so the deadline bounds the whole command
+    const uint64_t deadline_ns
+        = atto_time_ns() + (uint64_t) ATTO_SERVER_READ_TIMEOUT_MS * 1000000U;
+    int complete = 0;
+    size_t length = 0U;
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    while (!complete && length < size - 1U && atto_time_ns() < deadline_ns)
+    {
+        const ssize_t received = read(connection, command + length, size - 1U - length);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            complete = received == 0;
+            break;
+        }
+        length += (size_t) received;
+        complete = memchr(command, '\n', length) != NULL;
+    }
+    command[length] = '\0';
+    return !complete;
+}
+
+/** Executes a command with the standard output sent over the connection. */
+static int
+serve_connection(const int connection)
+{
+    static char command[ATTO_SERVER_MAX_COMMAND];
+    const int incomplete = read_command(connection, command, sizeof(command));
+    fflush(stdout);
+    const int original_stdout = dup(STDOUT_FILENO);
+    dup2(connection, STDOUT_FILENO);
+    int result = 1;
+    if (incomplete)
+    {
+        printf("SERVER | Error: command too long or not terminated in time\n");
+    }
+    else
+    {
+        result = atto_server_command(command);
+    }
+    fflush(stdout);
+    dup2(original_stdout, STDOUT_FILENO);
+    close(original_stdout);
+    return result;
+}
+
+int
+atto_server(const char* const socket_path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        return 1;
+    }
+    strcpy(address.sun_path, socket_path);
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (listener < 0 || bind(listener, (const struct sockaddr*) &address, sizeof(address)) != 0
+        || listen(listener, 8) != 0)
+    {
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+        return 1;
+    }
+    // A client disconnecting early must not kill the server
+    struct sigaction ignore;
+    struct sigaction previous;
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &ignore, &previous);
+    int result = 0;
+    while (result != 2)
+    {
+        const int connection = accept(listener, NULL, NULL);
+        if (connection >= 0)
+        {
+            result = serve_connection(connection);
+            close(connection);
+        }
+        else if (errno != EINTR)
+        {
+            break;
+        }
+    }
+    sigaction(SIGPIPE, &previous, NULL);
+    close(listener);
+    unlink(socket_path);
+    return result != 2;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file
+ * Atto server - long-lived host reloading and rerunning test suites
+ *
+ * Linux only. A host executable sets up its fixtures once, then serves
+ * commands over a local Unix socket, running test suites built as shared
+ * objects loaded with `dlopen()`. When a suite is rebuilt, the next `run`
+ * reloads it and reruns its test cases only, so an edit-and-test iteration
+ * costs the build of one small shared object instead of relinking the
+ * whole test binary and paying its startup again.
+ *
+ * The host is linked with `-rdynamic` (CMake `ENABLE_EXPORTS`), so the
+ * suites use its Atto counters and fixtures without linking the core
+ * themselves. Each suite defines atto_suite_register().
+ *
+ * A test case crashing also stops the server, which must then be restarted.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_SERVER_H
+#define ATTO_SERVER_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of test cases of each suite.
+ */
+#ifndef ATTO_SERVER_MAX_TESTS
+    #define ATTO_SERVER_MAX_TESTS (256U)
+#endif
+
+/**
+ * Maximum amount of suites loaded at the same time.
+ */
+#ifndef ATTO_SERVER_MAX_SUITES
+    #define ATTO_SERVER_MAX_SUITES (16U)
+#endif
+
+/**
+ * Maximum length of a command, including the path of a suite.
+ */
+#ifndef ATTO_SERVER_MAX_COMMAND
+    #define ATTO_SERVER_MAX_COMMAND (4096U)
+#endif
+
+/**
+ * Milliseconds a client has to send a whole command line, so a client never
+ * sending the newline nor closing its side does not block the server.
+ */
+#ifndef ATTO_SERVER_READ_TIMEOUT_MS
+    #define ATTO_SERVER_READ_TIMEOUT_MS (1000U)
+#endif
+
+/**
+ * Test case of a suite, with its name.
+ */
+typedef struct
+{
+    const char* name;  /**< Name of the test case function. */
+    atto_test_fn test; /**< The test case. */
+} atto_suite_test_t;
+
+/**
+ * Test cases registered by a suite.
+ */
+typedef struct
+{
+    size_t amount;                                  /**< Amount of test cases. */
+    atto_suite_test_t tests[ATTO_SERVER_MAX_TESTS]; /**< Test cases in registration order. */
+} atto_suite_t;
+
+/**
+ * Entry point of a suite, looked up by the server with `dlsym()` after
+ * loading it: registers the test cases with atto_suite_add().
+ *
+ * Defined by each suite, not by Atto.
+ *
+ * @param suite where to register the test cases. Not NULL.
+ */
+void
+atto_suite_register(atto_suite_t* suite);
+
+/**
+ * Registers a test case into a suite.
+ *
+ * Prefer atto_suite_add(), which provides the name automatically.
+ *
+ * @param suite suite to add to. Not NULL.
+ * @param test test case. Not NULL.
+ * @param name name of the test case. Not NULL.
+ * @return 0 on success, 1 if the suite already has #ATTO_SERVER_MAX_TESTS
+ * test cases.
+ */
+int
+atto_suite_add_test(atto_suite_t* suite, atto_test_fn test, const char* name);
+
+/**
+ * Registers a test case into a suite, named as its function.
+ *
+ * Example:
+ * ```
+ * void
+ * atto_suite_register(atto_suite_t* const suite)
+ * {
+ *     atto_suite_add(suite, test_parse_empty);
+ *     atto_suite_add(suite, test_parse_nested);
+ * }
+ * ```
+ */
+#define atto_suite_add(suite, test) atto_suite_add_test((suite), (test), #test)
+
+/**
+ * Loads a suite from a shared object and registers its test cases, without
+ * running them.
+ *
+ * Loading an already loaded suite again reloads it, even if not rebuilt.
+ * The new image is loaded from a private copy of the file before unloading
+ * the old one, so if it cannot be loaded the old one stays loaded.
+ *
+ * @param path path of the shared object. Not NULL.
+ * @return 0 on success, 1 if it could not be loaded, does not define
+ * atto_suite_register() or #ATTO_SERVER_MAX_SUITES are already loaded.
+ */
+int
+atto_server_load(const char* path);
+
+/**
+ * Executes one command, printing its output on standard output.
+ *
+ * Commands, one per line, with arguments separated by spaces:
+ * - `load <path>`: loads or reloads a suite.
+ * - `unload <path>`: unloads a suite.
+ * - `run`: reloads the suites rebuilt since they were loaded, by
+ *   modification time, size and inode, then runs their test cases.
+ * - `run <path> [test]`: runs the test cases of a suite, or only the given
+ *   one, reloading the suite first if it was rebuilt.
+ * - `list`: prints the loaded suites and their test cases.
+ * - `quit`: stops atto_server().
+ *
+ * The output of running ends with a line
+ * `SERVER | Tests: 3 | Passes: 12 | Failures: 1 | Duration: 1834 us`
+ * and errors are reported by a line starting with `SERVER | Error:`.
+ *
+ * @param command the command, terminated by a newline or null character.
+ * Not NULL.
+ * @return 0 on success, 1 on error, 2 for `quit`.
+ */
+int
+atto_server_command(const char* command);
+
+/**
+ * Serves commands on a Unix socket until the `quit` command.
+ *
+ * Each connection carries one command: the output of the command, including
+ * the output of the test cases, is sent back over it, then the connection
+ * is closed. A command longer than #ATTO_SERVER_MAX_COMMAND or not ending
+ * with a newline or the end of the connection within
+ * #ATTO_SERVER_READ_TIMEOUT_MS is rejected. For example from a shell:
+ *
+ * ```
+ * echo run | socat - UNIX-CONNECT:/tmp/atto.sock
+ * ```
+ *
+ * Commands are executed one at a time, in the calling thread, so the
+ * hooks and fixtures of the host work as with atto_run().
+ *
+ * @param socket_path path of the socket to create, replacing an existing
+ * one. Not NULL.
+ * @return 0 after `quit`, 1 if the socket could not be created or stopped
+ * accepting connections.
+ */
+int
+atto_server(const char* socket_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_SERVER_H */
@@ -0,0 +1,202 @@
+/**
+ * @file
+ * @internal
+ * Atto stack - peak stack usage of test cases and bodies of code
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE /* For ucontext, MAP_ANONYMOUS, MAP_STACK */
+#endif
+
+#include "atto_stack.h"
+#include <stdint.h> /* For uintptr_t */
+#if defined(__linux__)
+    #include <sys/mman.h> /* For mmap(), mprotect() */
+    #include <ucontext.h> /* For makecontext(), swapcontext() */
+    #include <unistd.h>   /* For sysconf() */
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+    #define NOINLINE __declspec(noinline)
+#else
+    #define NOINLINE
+#endif
+
+/** Painted region, as an integer as it outlives the frame that painted it. */
+static uintptr_t painted_low = 0U;
+static size_t last_peak = 0U;
+static int inside_stack_run = 0;
+
+/** Amount of bytes above the deepest one that is not the pattern anymore. */
+static size_t
+scan_used(const uintptr_t low, const size_t size)
+{
+    const volatile unsigned char* const bytes = (const volatile unsigned char*) low;
+    size_t untouched = 0U;
+    while (untouched < size && bytes[untouched] == ATTO_STACK_PATTERN) { untouched++; }
+    return size - untouched;
+}
+
+NOINLINE void
+atto_stack_paint(void)
+{
+    volatile unsigned char region[ATTO_STACK_PAINT_SIZE];
+    for (size_t i = 0U; i < sizeof(region); i++) { region[i] = ATTO_STACK_PATTERN; }
+    painted_low = (uintptr_t) region;
+}
+
+NOINLINE size_t
+atto_stack_used(void)
+{
+    if (painted_low == 0U)
+    {
+        return 0U;
+    }
+    return scan_used(painted_low, ATTO_STACK_PAINT_SIZE);
+}
+
+/** Prints the peak usage of the test case that just ended. */
+static void
+print_peak(const char* const test_name, const size_t painted)
+{
+    printf("STACK | Test case: %s | Peak: %zu B | Painted: %zu B\n",
+           test_name == NULL ? "-" : test_name,
+           last_peak,
+           painted);
+}
+
+/** Paints the stack the test case is about to use. */
+static void
+stack_before_test(const char* const test_name)
+{
+    (void) test_name;
+    if (!inside_stack_run)
+    {
+        atto_stack_paint();
+    }
+}
+
+/** Measures and reports the stack the test case used. */
+static void
+stack_after_test(const char* const test_name)
+{
+    if (!inside_stack_run)
+    {
+        last_peak = atto_stack_used();
+        print_peak(test_name, ATTO_STACK_PAINT_SIZE);
+    }
+}
+
+int
+atto_stack_track(void)
+{
+    return atto_hook_add(stack_before_test, stack_after_test);
+}
+
+size_t
+atto_stack_last_peak(void)
+{
+    return last_peak;
+}
+
+#if defined(__linux__)
+
+static unsigned char* dedicated_stack = NULL;
+static ucontext_t caller_context;
+static ucontext_t test_context;
+static atto_test_fn dedicated_test = NULL;
+
+/** Entry point of the dedicated stack, returning to caller_context. */
+static void
+dedicated_entry(void)
+{
+    dedicated_test();
+}
+
+/** Takes the place of the test case, running it on the dedicated stack. */
+static void
+dedicated_trampoline(void)
+{
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    if (dedicated_stack == NULL)
+    {
+        void* const mapping = mmap(NULL,
+                                   ATTO_STACK_SIZE + page,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+                                   -1,
+                                   0);
+        if (mapping == MAP_FAILED)
+        {
+            last_peak = 0U;
+            dedicated_test();  // Unmeasured rather than not executed
+            return;
+        }
+        mprotect(mapping, page, PROT_NONE);  // Stack overflows fault immediately
+        dedicated_stack = (unsigned char*) mapping + page;
+    }
+    memset(dedicated_stack, ATTO_STACK_PATTERN, ATTO_STACK_SIZE);
+    getcontext(&test_context);
+    test_context.uc_stack.ss_sp = dedicated_stack;
+    test_context.uc_stack.ss_size = ATTO_STACK_SIZE;
+    test_context.uc_link = &caller_context;
+    makecontext(&test_context, dedicated_entry, 0);
+    swapcontext(&caller_context, &test_context);
+    last_peak = scan_used((uintptr_t) dedicated_stack, ATTO_STACK_SIZE);
+}
+
+size_t
+atto_stack_run_test(const atto_test_fn test, const char* const name)
+{
+    dedicated_test = test;
+    inside_stack_run = 1;
+    atto_run_test(dedicated_trampoline, name);
+    inside_stack_run = 0;
+    print_peak(name, ATTO_STACK_SIZE);
+    return last_peak;
+}
+
+#else
+
+size_t
+atto_stack_run_test(const atto_test_fn test, const char* const name)
+{
+    inside_stack_run = 1;  // Painted here, so closer to the test case
+    atto_stack_paint();
+    atto_run_test(test, name);
+    last_peak = atto_stack_used();
+    inside_stack_run = 0;
+    print_peak(name, ATTO_STACK_PAINT_SIZE);
+    return last_peak;
+}
+
+#endif
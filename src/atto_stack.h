@@ -0,0 +1,184 @@
+/**
+ * @file
+ * Atto stack - peak stack usage of test cases and bodies of code
+ *
+ * Paints a region of unused stack with a known byte pattern, runs the code,
+ * then scans for the deepest byte that is not the pattern anymore, as the
+ * stack watermarking of most RTOSes does. Assumes a stack growing towards
+ * lower addresses, as on all mainstream architectures.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_STACK_H
+#define ATTO_STACK_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Amount of bytes of stack painted below the current stack frame by
+ * atto_stack_paint(), which is the largest measurable usage.
+ *
+ * Must fit in the free stack of the thread, so lower it for small embedded
+ * stacks.
+ */
+#ifndef ATTO_STACK_PAINT_SIZE
+    #define ATTO_STACK_PAINT_SIZE (32U * 1024U)
+#endif
+
+/**
+ * Byte painted on the unused stack, the same as the FreeRTOS one.
+ */
+#ifndef ATTO_STACK_PATTERN
+    #define ATTO_STACK_PATTERN (0xA5U)
+#endif
+
+/**
+ * Size in bytes of the dedicated stack of the test cases launched with
+ * atto_stack_run() on Linux.
+ */
+#ifndef ATTO_STACK_SIZE
+    #define ATTO_STACK_SIZE (256U * 1024U)
+#endif
+
+/**
+ * Paints #ATTO_STACK_PAINT_SIZE bytes of the unused stack right below the
+ * stack frame of the caller with #ATTO_STACK_PATTERN.
+ */
+void
+atto_stack_paint(void);
+
+/**
+ * Peak amount of stack used by the functions called since the last
+ * atto_stack_paint() from the same stack frame.
+ *
+ * Found by scanning the painted region from its deepest end for the first
+ * byte that is not #ATTO_STACK_PATTERN anymore. The result is accurate
+ * within a few dozen bytes of stack frame overhead; it would be too low only
+ * if the deepest used bytes happened to be written with the pattern itself.
+ *
+ * @return peak usage in bytes, at most #ATTO_STACK_PAINT_SIZE, in which
+ * case the actual usage may be larger.
+ */
+size_t
+atto_stack_used(void);
+
+/**
+ * Enables the per-test-case stack report.
+ *
+ * Registers hooks with atto_hook_add(), so each test case launched with
+ * atto_run() afterwards runs on freshly painted stack and prints one line
+ * with its peak stack usage on standard output:
+ *
+ * ```
+ * STACK | Test case: test_parse_nested | Peak: 3472 B | Painted: 32768 B
+ * ```
+ *
+ * @return 0 on success, 1 if no more hooks could be registered.
+ */
+int
+atto_stack_track(void);
+
+/**
+ * Peak stack usage of the last test case measured by the hooks of
+ * atto_stack_track() or by atto_stack_run().
+ *
+ * @return peak usage in bytes.
+ */
+size_t
+atto_stack_last_peak(void);
+
+/**
+ * Executes a test case as atto_run_test(), measuring its peak stack usage
+ * and printing the same `STACK` line as atto_stack_track().
+ *
+ * On Linux the test case runs on a dedicated stack of #ATTO_STACK_SIZE bytes,
+ * entirely painted before it and with an inaccessible guard page below it,
+ * so the measurement is exact and an overflow faults immediately instead of
+ * corrupting memory. Elsewhere the stack is painted as in
+ * atto_stack_track().
+ *
+ * Prefer atto_stack_run(), which provides the name automatically.
+ * Not reentrant.
+ *
+ * @param test test case function to execute. Not NULL.
+ * @param name name of the test case.
+ * @return peak stack usage of the test case in bytes.
+ */
+size_t
+atto_stack_run_test(atto_test_fn test, const char* name);
+
+/**
+ * Executes a test case with atto_run(), measuring its peak stack usage.
+ *
+ * Example:
+ * ```
+ * atto_stack_run(test_parse_nested);
+ * // STACK | Test case: test_parse_nested | Peak: 3416 B | Painted: 262144 B
+ * ```
+ */
+#define atto_stack_run(test) atto_stack_run_test((test), #test)
+
+/**
+ * Verifies if the functions called by the body use at most the given amount
+ * of bytes of stack, on top of the stack frame of the caller.
+ *
+ * The body is the last argument and may contain commas. The limit must be
+ * lower than #ATTO_STACK_PAINT_SIZE.
+ *
+ * Otherwise stops the test case and reports on standard output, including
+ * the peak stack usage on the `FAIL` line.
+ *
+ * Example:
+ * ```
+ * atto_max_stack(2048, parse_json(&parser, deeply_nested_document));
+ * ```
+ */
+#define atto_max_stack(bytes, ...)                                   \
+    do                                                               \
+    {                                                                \
+        atto_stack_paint();                                          \
+        __VA_ARGS__;                                                 \
+        const size_t atto_stack_peak = atto_stack_used();            \
+        atto_assert_details(atto_stack_peak <= (size_t) (bytes),     \
+                            printf(" | Stack: %zu B | Limit: %zu B", \
+                                   atto_stack_peak,                  \
+                                   (size_t) (bytes)));               \
+    }                                                                \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_STACK_H */
@@ -0,0 +1,258 @@
+/**
+ * @file
+ * @internal
+ * Atto stats - single-pass statistical assertions over streams of samples
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_stats.h"
+
+/**
+ * Amount of independent partial accumulators per loop.
+ *
+ * They break the dependency chain between iterations, which is what allows
+ * the compiler to vectorise the reductions without `-ffast-math`.
+ */
+#define ATTO_STATS_LANES (4U)
+
+void
+atto_stats_init(atto_stats_t* const stats)
+{
+    stats->count = 0U;
+    stats->mean = 0.0;
+    stats->m2 = 0.0;
+    stats->min = INFINITY;
+    stats->max = -INFINITY;
+}
+
+/** Adds one block of samples, which is small enough to be still in cache. */
+static void
+stats_add_block(atto_stats_t* const stats, const double* const x, const size_t len)
+{
+    const size_t len_lanes = len - (len % ATTO_STATS_LANES);
+    double sum[ATTO_STATS_LANES] = {0.0, 0.0, 0.0, 0.0};
+    double sq[ATTO_STATS_LANES] = {0.0, 0.0, 0.0, 0.0};
+    double min[ATTO_STATS_LANES] = {x[0], x[0], x[0], x[0]};
+    double max[ATTO_STATS_LANES] = {x[0], x[0], x[0], x[0]};
+    size_t i;
+
+    // First pass on the cached block: mean
+    for (i = 0U; i < len_lanes; i += ATTO_STATS_LANES)
+    {
+        for (size_t lane = 0U; lane < ATTO_STATS_LANES; lane++)
+        {
+            sum[lane] += x[i + lane];
+        }
+    }
+    double block_sum = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    for (; i < len; i++) { block_sum += x[i]; }
+    const double block_mean = block_sum / (double) len;
+
+    // Second pass on the cached block: squared deviations, min, max
+    for (i = 0U; i < len_lanes; i += ATTO_STATS_LANES)
+    {
+        for (size_t lane = 0U; lane < ATTO_STATS_LANES; lane++)
+        {
+            const double value = x[i + lane];
+            const double deviation = value - block_mean;
+            sq[lane] += deviation * deviation;
+            min[lane] = value < min[lane] ? value : min[lane];
+            max[lane] = value > max[lane] ? value : max[lane];
+        }
+    }
+    double block_m2 = (sq[0] + sq[1]) + (sq[2] + sq[3]);
+    for (; i < len; i++)
+    {
+        const double deviation = x[i] - block_mean;
+        block_m2 += deviation * deviation;
+        min[0] = x[i] < min[0] ? x[i] : min[0];
+        max[0] = x[i] > max[0] ? x[i] : max[0];
+    }
+    for (size_t lane = 1U; lane < ATTO_STATS_LANES; lane++)
+    {
+        min[0] = min[lane] < min[0] ? min[lane] : min[0];
+        max[0] = max[lane] > max[0] ? max[lane] : max[0];
+    }
+
+    // Merge the block into the running statistics (Chan et al.)
+    if (stats->count == 0U)
+    {
+        stats->mean = block_mean;
+        stats->m2 = block_m2;
+    }
+    else
+    {
+        const double count_a = (double) stats->count;
+        const double count_b = (double) len;
+        const double total = count_a + count_b;
+        const double delta = block_mean - stats->mean;
+        stats->mean += delta * (count_b / total);
+        stats->m2 += block_m2 + delta * delta * (count_a * count_b / total);
+    }
+    stats->min = min[0] < stats->min ? min[0] : stats->min;
+    stats->max = max[0] > stats->max ? max[0] : stats->max;
+    stats->count += len;
+}
+
+void
+atto_stats_add_f(atto_stats_t* const stats, const float* const samples, const size_t len)
+{
+    double block[ATTO_STATS_BLOCK_LEN];
+
+    for (size_t start = 0U; start < len; start += ATTO_STATS_BLOCK_LEN)
+    {
+        const size_t remaining = len - start;
+        const size_t block_len = remaining < ATTO_STATS_BLOCK_LEN ? remaining : ATTO_STATS_BLOCK_LEN;
+        for (size_t i = 0U; i < block_len; i++) { block[i] = (double) samples[start + i]; }
+        stats_add_block(stats, block, block_len);
+    }
+}
+
+void
+atto_stats_add_d(atto_stats_t* const stats, const double* const samples, const size_t len)
+{
+    for (size_t start = 0U; start < len; start += ATTO_STATS_BLOCK_LEN)
+    {
+        const size_t remaining = len - start;
+        const size_t block_len = remaining < ATTO_STATS_BLOCK_LEN ? remaining : ATTO_STATS_BLOCK_LEN;
+        stats_add_block(stats, &samples[start], block_len);
+    }
+}
+
+double
+atto_stats_mean(const atto_stats_t* const stats)
+{
+    return stats->count == 0U ? (double) NAN : stats->mean;
+}
+
+double
+atto_stats_variance(const atto_stats_t* const stats)
+{
+    return stats->count == 0U ? (double) NAN : stats->m2 / (double) stats->count;
+}
+
+double
+atto_stats_stddev(const atto_stats_t* const stats)
+{
+    return sqrt(atto_stats_variance(stats));
+}
+
+void
+atto_rmse_init(atto_rmse_t* const rmse)
+{
+    rmse->count = 0U;
+    rmse->sum_sq = 0.0;
+    rmse->compensation = 0.0;
+    rmse->max_abs_error = 0.0;
+}
+
+/** Adds one block of errors, which is small enough to be still in cache. */
+static void
+rmse_add_block(atto_rmse_t* const rmse, const double* const error, const size_t len)
+{
+    const size_t len_lanes = len - (len % ATTO_STATS_LANES);
+    double sq[ATTO_STATS_LANES] = {0.0, 0.0, 0.0, 0.0};
+    double max[ATTO_STATS_LANES] = {0.0, 0.0, 0.0, 0.0};
+    size_t i;
+
+    for (i = 0U; i < len_lanes; i += ATTO_STATS_LANES)
+    {
+        for (size_t lane = 0U; lane < ATTO_STATS_LANES; lane++)
+        {
+            const double abs_error = fabs(error[i + lane]);
+            sq[lane] += abs_error * abs_error;
+            max[lane] = abs_error > max[lane] ? abs_error : max[lane];
+        }
+    }
+    double block_sq = (sq[0] + sq[1]) + (sq[2] + sq[3]);
+    for (; i < len; i++)
+    {
+        const double abs_error = fabs(error[i]);
+        block_sq += abs_error * abs_error;
+        max[0] = abs_error > max[0] ? abs_error : max[0];
+    }
+    for (size_t lane = 1U; lane < ATTO_STATS_LANES; lane++)
+    {
+        max[0] = max[lane] > max[0] ? max[lane] : max[0];
+    }
+
+    // Kahan compensated summation of the block into the running total
+    const double compensated = block_sq - rmse->compensation;
+    const double total = rmse->sum_sq + compensated;
+    rmse->compensation = (total - rmse->sum_sq) - compensated;
+    rmse->sum_sq = total;
+    rmse->max_abs_error = max[0] > rmse->max_abs_error ? max[0] : rmse->max_abs_error;
+    rmse->count += len;
+}
+
+void
+atto_rmse_add_f(atto_rmse_t* const rmse,
+                const float* const obtained,
+                const float* const reference,
+                const size_t len)
+{
+    double error[ATTO_STATS_BLOCK_LEN];
+
+    for (size_t start = 0U; start < len; start += ATTO_STATS_BLOCK_LEN)
+    {
+        const size_t remaining = len - start;
+        const size_t block_len = remaining < ATTO_STATS_BLOCK_LEN ? remaining : ATTO_STATS_BLOCK_LEN;
+        for (size_t i = 0U; i < block_len; i++)
+        {
+            error[i] = (double) obtained[start + i] - (double) reference[start + i];
+        }
+        rmse_add_block(rmse, error, block_len);
+    }
+}
+
+void
+atto_rmse_add_d(atto_rmse_t* const rmse,
+                const double* const obtained,
+                const double* const reference,
+                const size_t len)
+{
+    double error[ATTO_STATS_BLOCK_LEN];
+
+    for (size_t start = 0U; start < len; start += ATTO_STATS_BLOCK_LEN)
+    {
+        const size_t remaining = len - start;
+        const size_t block_len = remaining < ATTO_STATS_BLOCK_LEN ? remaining : ATTO_STATS_BLOCK_LEN;
+        for (size_t i = 0U; i < block_len; i++)
+        {
+            error[i] = obtained[start + i] - reference[start + i];
+        }
+        rmse_add_block(rmse, error, block_len);
+    }
+}
+
+double
+atto_rmse_value(const atto_rmse_t* const rmse)
+{
+    return rmse->count == 0U ? (double) NAN : sqrt(rmse->sum_sq / (double) rmse->count);
+}
@@ -0,0 +1,268 @@
+/**
+ * @file
+ * Atto stats - single-pass statistical assertions over streams of samples
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_STATS_H
+#define ATTO_STATS_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Amount of samples processed at once by the accumulators, when updating
+ * them with a chunk of data.
+ *
+ * Each block is processed with simple, branch-free loops over a buffer which
+ * is still in the cache, so the compiler can vectorise them. The partial
+ * results of each block are then merged into the running statistics, so the
+ * data is still read only once from memory.
+ */
+#ifndef ATTO_STATS_BLOCK_LEN
+    #define ATTO_STATS_BLOCK_LEN (1024U)
+#endif
+
+/**
+ * Running statistics of a stream of samples: mean, variance, min and max.
+ *
+ * Initialise with atto_stats_init(), then feed it with any amount of chunks
+ * of samples with atto_stats_add_f() or atto_stats_add_d(). The samples are
+ * read exactly once, so the stream may be arbitrarily long and does not need
+ * to be stored anywhere.
+ *
+ * The mean and the sum of squared deviations are merged block by block with
+ * the parallel variant of Welford's algorithm (Chan et al.), which is
+ * numerically stable also for billions of samples.
+ */
+typedef struct
+{
+    size_t count; /**< Amount of samples accumulated so far. */
+    double mean;  /**< Running mean of the samples. */
+    double m2;    /**< Running sum of squared deviations from the mean. */
+    double min;   /**< Smallest sample so far. */
+    double max;   /**< Largest sample so far. */
+} atto_stats_t;
+
+/**
+ * Running Root Mean Square Error between a stream of obtained samples and a
+ * stream of reference samples.
+ *
+ * Initialise with atto_rmse_init(), then feed it with any amount of chunks
+ * of sample pairs with atto_rmse_add_f() or atto_rmse_add_d().
+ *
+ * The squared errors are summed with Kahan compensated summation, so the
+ * result does not drift even for billions of samples.
+ */
+typedef struct
+{
+    size_t count;         /**< Amount of sample pairs accumulated so far. */
+    double sum_sq;        /**< Compensated sum of the squared errors. */
+    double compensation;  /**< Kahan compensation term of sum_sq. */
+    double max_abs_error; /**< Largest absolute error so far. */
+} atto_rmse_t;
+
+/**
+ * Clears the running statistics, ready to accumulate a new stream.
+ *
+ * @param stats running statistics to clear. Not NULL.
+ */
+void
+atto_stats_init(atto_stats_t* stats);
+
+/**
+ * Accumulates a chunk of single-precision samples into the running statistics.
+ *
+ * @param stats running statistics to update. Not NULL.
+ * @param samples chunk of samples. May be NULL only if \p len is 0.
+ * @param len amount of samples in the chunk.
+ */
+void
+atto_stats_add_f(atto_stats_t* stats, const float* samples, size_t len);
+
+/**
+ * Accumulates a chunk of double-precision samples into the running statistics.
+ *
+ * @param stats running statistics to update. Not NULL.
+ * @param samples chunk of samples. May be NULL only if \p len is 0.
+ * @param len amount of samples in the chunk.
+ */
+void
+atto_stats_add_d(atto_stats_t* stats, const double* samples, size_t len);
+
+/**
+ * Mean of all the samples accumulated so far.
+ *
+ * @param stats running statistics. Not NULL.
+ * @return the mean or NaN if no samples were accumulated yet.
+ */
+double
+atto_stats_mean(const atto_stats_t* stats);
+
+/**
+ * Population variance of all the samples accumulated so far.
+ *
+ * @param stats running statistics. Not NULL.
+ * @return the variance or NaN if no samples were accumulated yet.
+ */
+double
+atto_stats_variance(const atto_stats_t* stats);
+
+/**
+ * Population standard deviation of all the samples accumulated so far.
+ *
+ * @param stats running statistics. Not NULL.
+ * @return the standard deviation or NaN if no samples were accumulated yet.
+ */
+double
+atto_stats_stddev(const atto_stats_t* stats);
+
+/**
+ * Clears the running RMSE, ready to accumulate a new stream.
+ *
+ * @param rmse running RMSE to clear. Not NULL.
+ */
+void
+atto_rmse_init(atto_rmse_t* rmse);
+
+/**
+ * Accumulates a chunk of single-precision sample pairs into the running RMSE.
+ *
+ * @param rmse running RMSE to update. Not NULL.
+ * @param obtained chunk of samples to verify. May be NULL only if \p len is 0.
+ * @param reference chunk of expected samples. May be NULL only if \p len is 0.
+ * @param len amount of samples in each chunk.
+ */
+void
+atto_rmse_add_f(atto_rmse_t* rmse, const float* obtained, const float* reference, size_t len);
+
+/**
+ * Accumulates a chunk of double-precision sample pairs into the running RMSE.
+ *
+ * @param rmse running RMSE to update. Not NULL.
+ * @param obtained chunk of samples to verify. May be NULL only if \p len is 0.
+ * @param reference chunk of expected samples. May be NULL only if \p len is 0.
+ * @param len amount of samples in each chunk.
+ */
+void
+atto_rmse_add_d(atto_rmse_t* rmse, const double* obtained, const double* reference, size_t len);
+
+/**
+ * Root Mean Square Error of all the sample pairs accumulated so far.
+ *
+ * @param rmse running RMSE. Not NULL.
+ * @return the RMSE or NaN if no samples were accumulated yet.
+ */
+double
+atto_rmse_value(const atto_rmse_t* rmse);
+
+/**
+ * Verifies if the mean of the accumulated samples is within a given absolute
+ * tolerance from the expected value, with the same semantics as atto_ddelta().
+ *
+ * Otherwise stops the test case and reports on standard output.
+ * Fails also when no samples were accumulated.
+ *
+ * Example:
+ * ```
+ * atto_stats_t stats;
+ * atto_stats_init(&stats);
+ * atto_stats_add_f(&stats, chunk, chunk_len);  // Repeat for each chunk
+ * atto_mean_within(&stats, 0.0, 0.01);
+ * ```
+ */
+#define atto_mean_within(stats, expected, delta) \
+    atto_ddelta(atto_stats_mean(stats), (expected), (delta))
+
+/**
+ * Verifies if the variance of the accumulated samples is within a given
+ * absolute tolerance from the expected value, with the same semantics as
+ * atto_ddelta().
+ *
+ * Otherwise stops the test case and reports on standard output.
+ * Fails also when no samples were accumulated.
+ */
+#define atto_variance_within(stats, expected, delta) \
+    atto_ddelta(atto_stats_variance(stats), (expected), (delta))
+
+/**
+ * Verifies if the standard deviation of the accumulated samples is within a
+ * given absolute tolerance from the expected value, with the same semantics
+ * as atto_ddelta().
+ *
+ * Otherwise stops the test case and reports on standard output.
+ * Fails also when no samples were accumulated.
+ */
+#define atto_stddev_within(stats, expected, delta) \
+    atto_ddelta(atto_stats_stddev(stats), (expected), (delta))
+
+/**
+ * Verifies if all the accumulated samples are greater or equal to the bound.
+ *
+ * Otherwise stops the test case and reports on standard output.
+ * Fails also when no samples were accumulated.
+ */
+#define atto_min_ge(stats, bound) \
+    atto_assert((stats)->count > 0U && (stats)->min >= (double) (bound))
+
+/**
+ * Verifies if all the accumulated samples are less or equal to the bound.
+ *
+ * Otherwise stops the test case and reports on standard output.
+ * Fails also when no samples were accumulated.
+ */
+#define atto_max_le(stats, bound) \
+    atto_assert((stats)->count > 0U && (stats)->max <= (double) (bound))
+
+/**
+ * Verifies if the Root Mean Square Error of the accumulated sample pairs is
+ * less or equal to the given tolerance.
+ *
+ * Otherwise stops the test case and reports on standard output.
+ * Fails also when no samples were accumulated.
+ *
+ * Example:
+ * ```
+ * atto_rmse_t rmse;
+ * atto_rmse_init(&rmse);
+ * atto_rmse_add_d(&rmse, obtained, reference, chunk_len);  // For each chunk
+ * atto_rmse_le(&rmse, 1e-6);
+ * ```
+ */
+#define atto_rmse_le(rmse, tolerance) atto_assert(atto_rmse_value(rmse) <= fabs(tolerance))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_STATS_H */
@@ -0,0 +1,263 @@
+/**
+ * @file
+ * @internal
+ * Atto stress - multi-threaded throughput and scalability stress harness
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE /* For pthread_setaffinity_np(), sched_getaffinity(), clock_nanosleep() */
+#elif !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For nanosleep() */
+#endif
+
+#include "atto_stress.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/** State of each worker thread, on its own cache line to avoid false sharing. */
+typedef struct
+{
+    _Alignas(64) pthread_t thread;
+    size_t idx;
+    uint64_t ops;
+} stress_worker_t;
+
+/** State shared by all worker threads of the current run. */
+static struct
+{
+    atto_stress_fn op;
+    void* ctx;
+    atomic_size_t ready;
+    atomic_int started;
+    atomic_int stopped;
+    stress_worker_t workers[ATTO_STRESS_MAX_THREADS];
+} stress;
+
+/**
+ * Pins the calling thread to the idx-th CPU it may run on, wrapping around,
+ * so taskset, cgroups and containers restricting the CPUs are respected.
+ */
+static void
+pin_to_cpu(const size_t idx)
+{
+#if defined(__linux__)
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) <= 1)
+    {
+        return;
+    }
+    size_t skipped = idx % (size_t) CPU_COUNT(&allowed);
+    for (size_t cpu = 0U; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &allowed) && skipped-- == 0U)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            return;
+        }
+    }
+#else
+    (void) idx;  // Pinning is a best effort, not portable
+#endif
+}
+
+static void*
+stress_worker(void* const arg)
+{
+    stress_worker_t* const worker = arg;
+    const atto_stress_fn op = stress.op;
+    void* const ctx = stress.ctx;
+    const size_t idx = worker->idx;
+    uint64_t ops = 0U;
+
+    pin_to_cpu(idx);
+    atomic_fetch_add(&stress.ready, 1U);
+    while (!atomic_load_explicit(&stress.started, memory_order_acquire)) { sched_yield(); }
+    while (!atomic_load_explicit(&stress.stopped, memory_order_relaxed))
+    {
+        op(ctx, idx);
+        ops++;
+    }
+    worker->ops = ops;
+    return NULL;
+}
+
+/**
+ * Sleeps until the real clock of atto_time_ns() reaches the deadline.
+ *
+ * On Linux through clock_nanosleep(), which the Atto virtual clock does not
+ * replace, so the duration stays real also with its interposition enabled.
+ */
+static void
+sleep_until_ns(const uint64_t deadline_ns)
+{
+    for (uint64_t now = atto_time_ns(); now < deadline_ns; now = atto_time_ns())
+    {
+        const uint64_t left_ns = deadline_ns - now;
+        const struct timespec duration = {
+            .tv_sec = (time_t) (left_ns / 1000000000U),
+            .tv_nsec = (long) (left_ns % 1000000000U),
+        };
+#if defined(__linux__)
+        const int error = clock_nanosleep(CLOCK_MONOTONIC, 0, &duration, NULL);
+#else
+        const int error = nanosleep(&duration, NULL) == 0 ? 0 : errno;
+#endif
+        if (error != 0 && error != EINTR)
+        {
+            sched_yield();  // Cannot sleep: keep checking the clock
+        }
+    }
+}
+
+double
+atto_stress(atto_stress_result_t* const result,
+            size_t threads,
+            const uint64_t duration_ns,
+            const atto_stress_fn op,
+            void* const ctx)
+{
+    threads = threads > ATTO_STRESS_MAX_THREADS ? ATTO_STRESS_MAX_THREADS : threads;
+    memset(result, 0, sizeof(*result));
+    stress.op = op;
+    stress.ctx = ctx;
+    atomic_store(&stress.ready, 0U);
+    atomic_store(&stress.started, 0);
+    atomic_store(&stress.stopped, 0);
+
+    size_t started = 0U;
+    for (; started < threads; started++)
+    {
+        stress.workers[started].idx = started;
+        stress.workers[started].ops = 0U;
+        if (pthread_create(&stress.workers[started].thread,
+                           NULL,
+                           stress_worker,
+                           &stress.workers[started])
+            != 0)
+        {
+            break;
+        }
+    }
+    // Barrier: all threads are created and waiting before the clock starts
+    while (atomic_load(&stress.ready) < started) { sched_yield(); }
+    const uint64_t start = atto_time_ns();
+    atomic_store_explicit(&stress.started, 1, memory_order_release);
+    sleep_until_ns(start + duration_ns);
+    atomic_store_explicit(&stress.stopped, 1, memory_order_relaxed);
+    const uint64_t stop = atto_time_ns();
+    for (size_t i = 0U; i < started; i++) { pthread_join(stress.workers[i].thread, NULL); }
+    if (started < threads)
+    {
+        return 0.0;
+    }
+
+    result->threads = threads;
+    result->duration_ns = stop - start;
+    for (size_t i = 0U; i < threads; i++)
+    {
+        result->ops[i] = stress.workers[i].ops;
+        result->total_ops += stress.workers[i].ops;
+    }
+    result->throughput = (double) result->total_ops * 1e9 / (double) result->duration_ns;
+    return result->throughput;
+}
+
+void
+atto_stress_curve(atto_stress_curve_t* const curve,
+                  const size_t max_threads,
+                  const uint64_t duration_ns,
+                  const atto_stress_fn op,
+                  void* const ctx)
+{
+    static atto_stress_result_t result;  // Too large for small stacks
+
+    curve->points = 0U;
+    for (size_t threads = 1U; threads <= max_threads && curve->points < ATTO_STRESS_MAX_POINTS;
+         threads *= 2U)
+    {
+        curve->threads[curve->points] = threads;
+        curve->throughput[curve->points] = atto_stress(&result, threads, duration_ns, op, ctx);
+        curve->points++;
+        if (threads < max_threads && threads * 2U > max_threads
+            && curve->points < ATTO_STRESS_MAX_POINTS)
+        {
+            // Last point for a max_threads that is not a power of 2
+            curve->threads[curve->points] = max_threads;
+            curve->throughput[curve->points] =
+                atto_stress(&result, max_threads, duration_ns, op, ctx);
+            curve->points++;
+        }
+    }
+    for (size_t i = 0U; i < curve->points; i++)
+    {
+        const double speedup = atto_stress_speedup(curve, curve->threads[i]);
+        printf("STRESS | Threads: %3zu | Throughput: %12.0f ops/s"
+               " | Speedup: %6.2fx | Efficiency: %5.1f%%\n",
+               curve->threads[i],
+               curve->throughput[i],
+               speedup,
+               100.0 * speedup / (double) curve->threads[i]);
+    }
+}
+
+double
+atto_stress_speedup(const atto_stress_curve_t* const curve, const size_t threads)
+{
+    double single = 0.0;
+    double multi = (double) NAN;
+
+    for (size_t i = 0U; i < curve->points; i++)
+    {
+        if (curve->threads[i] == 1U)
+        {
+            single = curve->throughput[i];
+        }
+        if (curve->threads[i] == threads)
+        {
+            multi = curve->throughput[i];
+        }
+    }
+    return single > 0.0 ? multi / single : (double) NAN;
+}
+
+void
+atto_stress_print(const atto_stress_curve_t* const curve)
+{
+    for (size_t i = 0U; i < curve->points; i++)
+    {
+        printf(" | %zu threads: %.0f ops/s", curve->threads[i], curve->throughput[i]);
+    }
+}
@@ -0,0 +1,181 @@
+/**
+ * @file
+ * Atto stress - multi-threaded throughput and scalability stress harness
+ *
+ * Requires POSIX threads and C11 atomics.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_STRESS_H
+#define ATTO_STRESS_H
+
+#include "atto.h"
+#include "atto_time.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of threads a stress run can start.
+ */
+#ifndef ATTO_STRESS_MAX_THREADS
+    #define ATTO_STRESS_MAX_THREADS (64U)
+#endif
+
+/**
+ * Maximum amount of points of a scalability curve: 1, 2, 4, ... threads.
+ */
+#define ATTO_STRESS_MAX_POINTS (8U)
+
+/**
+ * Operation to stress: executed in a loop by every thread for the whole
+ * duration of the run. Each call counts as one operation.
+ *
+ * @param ctx user context, the same for all threads.
+ * @param thread_idx index of the calling thread in [0, threads).
+ */
+typedef void (*atto_stress_fn)(void* ctx, size_t thread_idx);
+
+/**
+ * Outcome of a single stress run with a fixed amount of threads.
+ */
+typedef struct
+{
+    size_t threads;                        /**< Amount of threads started. */
+    uint64_t duration_ns;                  /**< Measured duration of the run. */
+    uint64_t total_ops;                    /**< Operations of all threads. */
+    uint64_t ops[ATTO_STRESS_MAX_THREADS]; /**< Operations of each thread. */
+    double throughput;                     /**< Total operations per second. */
+} atto_stress_result_t;
+
+/**
+ * Throughput of the same operation measured at increasing amounts of
+ * threads: the scalability curve.
+ */
+typedef struct
+{
+    size_t points;                             /**< Amount of measured points. */
+    size_t threads[ATTO_STRESS_MAX_POINTS];    /**< Threads of each point. */
+    double throughput[ATTO_STRESS_MAX_POINTS]; /**< Ops per second of each point. */
+} atto_stress_curve_t;
+
+/**
+ * Runs the operation in a loop on multiple threads at the same time for a
+ * fixed duration and counts how many operations each thread completed.
+ *
+ * All threads are started first and wait on a barrier, so they begin
+ * stressing the operation at the same moment. On Linux the threads are
+ * pinned in turn to the CPUs allowed by the affinity mask of the process,
+ * e.g. as restricted by `taskset` or a container: each to a different CPU
+ * while there are enough of them, then wrapping around to share them.
+ *
+ * Not reentrant: only one stress run at a time.
+ *
+ * @param result where to store the outcome of the run. Not NULL.
+ * @param threads amount of threads in [1, #ATTO_STRESS_MAX_THREADS].
+ * @param duration_ns how long to run the operation for.
+ * @param op operation to stress. Not NULL.
+ * @param ctx user context passed to each call of \p op. May be NULL.
+ * @return the throughput in operations per second or 0 if the threads could
+ * not be started.
+ */
+double
+atto_stress(atto_stress_result_t* result,
+            size_t threads,
+            uint64_t duration_ns,
+            atto_stress_fn op,
+            void* ctx);
+
+/**
+ * Measures the scalability curve of the operation, running atto_stress() at
+ * 1, 2, 4, ... threads up to the given maximum, which is also measured when
+ * not a power of 2.
+ *
+ * Prints one `STRESS` line per point on standard output with the throughput,
+ * the speedup and the scaling efficiency compared to 1 thread.
+ *
+ * @param curve where to store the measured points. Not NULL.
+ * @param max_threads largest amount of threads to measure.
+ * @param duration_ns how long to run the operation for at each point.
+ * @param op operation to stress. Not NULL.
+ * @param ctx user context passed to each call of \p op. May be NULL.
+ */
+void
+atto_stress_curve(atto_stress_curve_t* curve,
+                  size_t max_threads,
+                  uint64_t duration_ns,
+                  atto_stress_fn op,
+                  void* ctx);
+
+/**
+ * Throughput at the given amount of threads divided by the throughput at 1
+ * thread.
+ *
+ * @param curve measured scalability curve. Not NULL.
+ * @param threads amount of threads of the point to compare.
+ * @return the speedup or NaN if either point was not measured.
+ */
+double
+atto_stress_speedup(const atto_stress_curve_t* curve, size_t threads);
+
+/**
+ * Prints the scalability curve on the current line of the standard output,
+ * without terminating the line.
+ *
+ * @param curve measured scalability curve. Not NULL.
+ */
+void
+atto_stress_print(const atto_stress_curve_t* curve);
+
+/**
+ * Verifies if the throughput at the given amount of threads is at least
+ * `min_speedup` times the throughput at 1 thread.
+ *
+ * Otherwise stops the test case and reports on standard output, including
+ * the whole curve on the `FAIL` line.
+ * Fails also when either point was not measured.
+ *
+ * Example:
+ * ```
+ * atto_stress_curve_t curve;
+ * atto_stress_curve(&curve, 8U, ATTO_MS(200), queue_push_pop, &queue);
+ * atto_stress_speedup_ge(&curve, 8U, 6.0);  // 8 threads at least 6x faster
+ * ```
+ */
+#define atto_stress_speedup_ge(curve, threads, min_speedup)                       \
+    atto_assert_details(atto_stress_speedup((curve), (threads)) >= (min_speedup), \
+                        atto_stress_print(curve))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_STRESS_H */
@@ -0,0 +1,83 @@
+/**
+ * @file
+ * Atto time - monotonic clock for the timing-related Atto modules
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_TIME_H
+#define ATTO_TIME_H
+
+#include <stdint.h> /* For uint64_t */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Converts an integer amount of nanoseconds to the unit of atto_time_ns().
+ */
+#define ATTO_NS(x) ((uint64_t) (x))
+
+/**
+ * Converts an integer amount of microseconds to the unit of atto_time_ns().
+ *
+ * Example:
+ * ```
+ * atto_latency_p(99.9, <=, ATTO_US(200), 1000, handle_request(&request));
+ * ```
+ */
+#define ATTO_US(x) ((uint64_t) (x) * 1000U)
+
+/**
+ * Converts an integer amount of milliseconds to the unit of atto_time_ns().
+ */
+#define ATTO_MS(x) ((uint64_t) (x) * 1000000U)
+
+/**
+ * Converts an integer amount of seconds to the unit of atto_time_ns().
+ */
+#define ATTO_S(x) ((uint64_t) (x) * 1000000000U)
+
+/**
+ * Current value of the monotonic clock in nanoseconds.
+ *
+ * The origin is unspecified, so the value is only useful for differences
+ * between two calls. The actual resolution depends on the platform.
+ *
+ * @return monotonic timestamp in nanoseconds.
+ */
+uint64_t
+atto_time_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_TIME_H */
@@ -0,0 +1,296 @@
+/**
+ * @file
+ * @internal
+ * Atto trace - Chrome/Perfetto trace-event timeline of the test suite
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_trace.h"
+#include <stdatomic.h> /* For atomic_size_t */
+#include <stdlib.h>    /* For atexit() */
+#if defined(_WIN32)
+    #include <process.h> /* For _getpid() */
+    #define getpid _getpid
+#else
+    #include <unistd.h> /* For getpid() */
+#endif
+
+/** One recorded event, serialised only at exit. */
+typedef struct
+{
+    const char* name;
+    const char* category;
+    uint64_t timestamp_ns;
+    char phase; /* As in the trace-event format: B(egin), E(nd), i(nstant) */
+    char failed;
+} trace_event_t;
+
+/** Events of a single thread, written only by that thread. */
+typedef struct
+{
+    size_t amount;
+    size_t dropped;
+    size_t depth;
+    trace_event_t events[ATTO_TRACE_MAX_EVENTS];
+} trace_buffer_t;
+
+static trace_buffer_t buffers[ATTO_TRACE_MAX_THREADS];
+static atomic_size_t buffers_claimed = 0U;
+static atomic_size_t unbuffered_dropped = 0U;
+static _Thread_local trace_buffer_t* thread_buffer = NULL;
+static _Thread_local int thread_unbuffered = 0;
+static atomic_int enabled = 0;
+static int hooked = 0;
+static const char* exit_path = NULL;
+static uint64_t start_ns = 0U;
+
+/** Depth of the span of the running test case and failures before it. */
+static size_t test_depth = 0U;
+static size_t test_failures = 0U;
+
+/** Buffer of the calling thread, claimed on its first event. */
+static trace_buffer_t*
+own_buffer(void)
+{
+    if (thread_buffer == NULL && !thread_unbuffered)
+    {
+        const size_t index = atomic_fetch_add(&buffers_claimed, 1U);
+        if (index < ATTO_TRACE_MAX_THREADS)
+        {
+            thread_buffer = &buffers[index];
+        }
+        thread_unbuffered = thread_buffer == NULL;
+    }
+    if (thread_unbuffered)
+    {
+        atomic_fetch_add(&unbuffered_dropped, 1U);
+    }
+    return thread_buffer;
+}
+
+/** Appends an event with the current timestamp to the calling thread. */
+static trace_buffer_t*
+record(const char* const name, const char* const category, const char phase, const char failed)
+{
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed))
+    {
+        return NULL;
+    }
+    trace_buffer_t* const buffer = own_buffer();
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+    if (buffer->amount >= ATTO_TRACE_MAX_EVENTS)
+    {
+        buffer->dropped++;
+        return buffer;
+    }
+    trace_event_t* const event = &buffer->events[buffer->amount++];
+    event->timestamp_ns = atto_time_ns();
+    event->name = name;
+    event->category = category;
+    event->phase = phase;
+    event->failed = failed;
+    return buffer;
+}
+
+void
+atto_trace_begin(const char* const name, const char* const category)
+{
+    trace_buffer_t* const buffer = record(name, category, 'B', 0);
+    if (buffer != NULL)
+    {
+        buffer->depth++;
+    }
+}
+
+void
+atto_trace_end(void)
+{
+    trace_buffer_t* const buffer = thread_buffer;
+    if (buffer != NULL && buffer->depth > 0U)
+    {
+        record(NULL, NULL, 'E', 0);
+        buffer->depth--;
+    }
+}
+
+void
+atto_trace_instant(const char* const name)
+{
+    record(name, "marker", 'i', 0);
+}
+
+static void
+trace_before_test(const char* const test_name)
+{
+    test_failures = atto_counter_assert_failures;
+    atto_trace_begin(test_name, "test");
+    test_depth = thread_buffer == NULL ? 0U : thread_buffer->depth;
+}
+
+static void
+trace_after_test(const char* const test_name)
+{
+    (void) test_name;
+    trace_buffer_t* const buffer = thread_buffer;
+    if (buffer == NULL || test_depth == 0U)
+    {
+        return;
+    }
+    while (buffer->depth > test_depth) { atto_trace_end(); }  // Left early
+    const char failed = atto_counter_assert_failures != test_failures;
+    if (failed)
+    {
+        atto_trace_instant("FAIL");
+    }
+    if (buffer->depth == test_depth && record(NULL, NULL, 'E', failed) != NULL)
+    {
+        buffer->depth--;
+    }
+}
+
+static void
+write_at_exit(void)
+{
+    atto_trace_write(exit_path);
+}
+
+int
+atto_trace_enable(const char* const path)
+{
+    if (exit_path == NULL)
+    {
+        // The exit handler only once the hooks are in, not to write without a path
+        if (!hooked && atto_hook_add(trace_before_test, trace_after_test) != 0)
+        {
+            return 1;
+        }
+        hooked = 1;
+        if (atexit(write_at_exit) != 0)
+        {
+            return 1;
+        }
+        start_ns = atto_time_ns();
+    }
+    exit_path = path;
+    atomic_store(&enabled, 1);
+    return 0;
+}
+
+/** Writes a JSON string, escaping what needs to be escaped. */
+static void
+write_json_string(FILE* const file, const char* str)
+{
+    fputc('"', file);
+    for (; *str != '\0'; str++)
+    {
+        const unsigned char c = (unsigned char) *str;
+        if (c == '"' || c == '\\')
+        {
+            fprintf(file, "\\%c", c);
+        }
+        else if (c < 0x20U)
+        {
+            fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+int
+atto_trace_write(const char* const path)
+{
+    FILE* const file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return 1;
+    }
+    size_t claimed = atomic_load(&buffers_claimed);
+    claimed = claimed < ATTO_TRACE_MAX_THREADS ? claimed : ATTO_TRACE_MAX_THREADS;
+    size_t written = 0U;
+    size_t dropped = atomic_load(&unbuffered_dropped);
+    const long pid = (long) getpid();
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t t = 0U; t < claimed; t++)
+    {
+        const trace_buffer_t* const buffer = &buffers[t];
+        const size_t tid = t + 1U;
+        fprintf(file,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%zu,"
+                "\"args\":{\"name\":\"Thread %zu\"}}",
+                written == 0U ? "" : ",\n",
+                pid,
+                tid,
+                tid);
+        written++;
+        for (size_t e = 0U; e < buffer->amount; e++)
+        {
+            const trace_event_t* const event = &buffer->events[e];
+            const uint64_t relative_ns = event->timestamp_ns - start_ns;
+            fprintf(file, ",\n{\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%ld,\"tid\":%zu",
+                    event->phase,
+                    (unsigned long long) (relative_ns / 1000U),
+                    (unsigned int) (relative_ns % 1000U),
+                    pid,
+                    tid);
+            if (event->name != NULL)
+            {
+                fprintf(file, ",\"name\":");
+                write_json_string(file, event->name);
+            }
+            if (event->category != NULL)
+            {
+                fprintf(file, ",\"cat\":");
+                write_json_string(file, event->category);
+            }
+            if (event->phase == 'i')
+            {
+                fprintf(file, ",\"s\":\"t\"");
+            }
+            if (event->failed)
+            {
+                fprintf(file, ",\"args\":{\"failed\":true}");
+            }
+            fprintf(file, "}");
+            written++;
+        }
+        dropped += buffer->dropped;
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    const int error = fclose(file) != 0;
+    printf("TRACE | File: %s | Events: %zu | Dropped: %zu\n", path, written, dropped);
+    return error;
+}
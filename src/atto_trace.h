@@ -0,0 +1,165 @@
+/**
+ * @file
+ * Atto trace - Chrome/Perfetto trace-event timeline of the test suite
+ *
+ * Requires C11 atomics and thread-local storage.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_TRACE_H
+#define ATTO_TRACE_H
+
+#include "atto.h"
+#include "atto_time.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of threads recording events, each into its own buffer.
+ * Events of further threads are dropped.
+ */
+#ifndef ATTO_TRACE_MAX_THREADS
+    #define ATTO_TRACE_MAX_THREADS (16U)
+#endif
+
+/**
+ * Maximum amount of events recorded by each thread. Further events are
+ * dropped.
+ */
+#ifndef ATTO_TRACE_MAX_EVENTS
+    #define ATTO_TRACE_MAX_EVENTS (4096U)
+#endif
+
+/**
+ * Starts recording a trace, written as trace-event JSON to the given file
+ * at the exit of the process.
+ *
+ * Each test case launched with atto_run() becomes a span on the timeline of
+ * its thread. A test case with failed assertions gets a `FAIL` marker and a
+ * `failed` argument on its span. The file can be opened in
+ * <https://ui.perfetto.dev> or `chrome://tracing`.
+ *
+ * Events are recorded with a timestamp into preallocated per-thread buffers
+ * without locks or I/O. They are serialised only at exit, so tracing barely
+ * affects the timings it records.
+ *
+ * Only the events of the calling process are written. The ones recorded in
+ * forked worker processes, e.g. by atto_vec_run() or atto_fuzz_replay() with
+ * more than one worker, are lost with the worker and not counted as dropped,
+ * so trace runs with a single worker.
+ *
+ * Example:
+ * ```
+ * atto_trace_enable("atto_trace.json");
+ * atto_run(test_parser);
+ * ```
+ *
+ * @param path file to write at exit. Must remain valid until then. Not NULL.
+ * @return 0 on success, 1 if the hooks or the exit handler could not be
+ * registered.
+ */
+int
+atto_trace_enable(const char* path);
+
+/**
+ * Opens a span on the timeline of the calling thread, nested in any span
+ * still open on it. Does nothing if tracing is not enabled.
+ *
+ * @param name name of the span. Must remain valid until the trace is
+ * written, e.g. a string literal. Not NULL.
+ * @param category category of the span, e.g. `"fixture"` or `"bench"`.
+ * Must remain valid until the trace is written. Not NULL.
+ */
+void
+atto_trace_begin(const char* name, const char* category);
+
+/**
+ * Closes the innermost span open on the calling thread. Does nothing if
+ * tracing is not enabled.
+ */
+void
+atto_trace_end(void);
+
+/**
+ * Marks a point in time on the timeline of the calling thread. Does nothing
+ * if tracing is not enabled.
+ *
+ * @param name name of the marker. Must remain valid until the trace is
+ * written. Not NULL.
+ */
+void
+atto_trace_instant(const char* name);
+
+/**
+ * Writes all events recorded so far as trace-event JSON.
+ *
+ * Called automatically at exit when enabled with atto_trace_enable(). Must
+ * not run concurrently with threads still recording events.
+ *
+ * Prints a `TRACE` line with the file, the amount of events and the amount
+ * of dropped events, if any.
+ *
+ * @param path file to overwrite. Not NULL.
+ * @return 0 on success, 1 if the file could not be written.
+ */
+int
+atto_trace_write(const char* path);
+
+/**
+ * Executes a body of code within a span on the timeline, e.g. a fixture
+ * setup or a benchmark.
+ *
+ * The body is the last argument and may contain commas. If it leaves the
+ * span early, e.g. with a failing assertion, the span is closed at the end
+ * of the test case launched with atto_run().
+ *
+ * Example:
+ * ```
+ * atto_trace_span("load_fixtures", "fixture", load_fixtures(&db));
+ * atto_trace_span("parse_header", "bench",
+ *                 atto_bench("parse_header", 100U, 5.0, parse_header(data)));
+ * ```
+ */
+#define atto_trace_span(name, category, ...)  \
+    do                                        \
+    {                                         \
+        atto_trace_begin((name), (category)); \
+        __VA_ARGS__;                          \
+        atto_trace_end();                     \
+    }                                         \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_TRACE_H */
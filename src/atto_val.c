@@ -0,0 +1,78 @@
+/**
+ * @file
+ * @internal
+ * Atto val - typed assertions evaluating each operand once and printing both
+ * values on failure
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atto_val.h"
+
+/** Prints a single value according to its kind. */
+static void
+print_value(const atto_val_t* const val)
+{
+    switch (val->kind)
+    {
+        case ATTO_VAL_SIGNED:
+            printf("%jd", val->as.s);
+            break;
+        case ATTO_VAL_UNSIGNED:
+            printf("%ju", val->as.u);
+            break;
+        case ATTO_VAL_FLOATING:
+            printf("%.*Lg", val->digits, val->as.f);
+            break;
+        case ATTO_VAL_POINTER:
+            printf("%p", val->as.p);
+            break;
+        case ATTO_VAL_STRING:
+            if (val->as.str == NULL)
+            {
+                printf("NULL");
+            }
+            else
+            {
+                printf("\"%s\"", val->as.str);
+            }
+            break;
+        default:
+            printf("?");
+            break;
+    }
+}
+
+void
+atto_val_print(const char* const comparison, const atto_val_t* const a, const atto_val_t* const b)
+{
+    printf(" | %s | Left: ", comparison);
+    print_value(a);
+    printf(" | Right: ");
+    print_value(b);
+}
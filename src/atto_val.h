@@ -0,0 +1,428 @@
+/**
+ * @file
+ * Atto val - typed assertions evaluating each operand once and printing both
+ * values on failure
+ *
+ * Requires C11 for `_Generic`, so it is not available in C++.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_VAL_H
+#define ATTO_VAL_H
+
+#include "atto.h"
+#include <float.h>  /* For FLT_DECIMAL_DIG, DBL_DECIMAL_DIG, LDBL_DECIMAL_DIG */
+#include <stdint.h> /* For intmax_t, uintmax_t, uintptr_t */
+
+#if defined(__cplusplus) || !defined(__STDC_VERSION__) || __STDC_VERSION__ < 201112L
+    #error "Atto val requires C11"
+#endif
+
+/**
+ * Result of atto_val_cmp() when the values cannot be ordered, as any
+ * comparison involving a NaN.
+ */
+#define ATTO_VAL_UNORDERED (2)
+
+/**
+ * Kind of value stored in an #atto_val_t.
+ */
+typedef enum
+{
+    ATTO_VAL_SIGNED,   /**< Any signed integer, including `char`. */
+    ATTO_VAL_UNSIGNED, /**< Any unsigned integer, including `bool`. */
+    ATTO_VAL_FLOATING, /**< `float`, `double` or `long double`. */
+    ATTO_VAL_POINTER,  /**< Any pointer that is not a string. */
+    ATTO_VAL_STRING,   /**< `char*` or `const char*`, compared by content. */
+} atto_val_kind_t;
+
+/**
+ * Operand of a typed assertion, evaluated once and stored with its kind.
+ */
+typedef struct
+{
+    atto_val_kind_t kind; /**< Which member of the union is set. */
+    int digits;           /**< Significant digits printing a floating value. */
+    union
+    {
+        intmax_t s;      /**< Value of #ATTO_VAL_SIGNED. */
+        uintmax_t u;     /**< Value of #ATTO_VAL_UNSIGNED. */
+        long double f;   /**< Value of #ATTO_VAL_FLOATING. */
+        const void* p;   /**< Value of #ATTO_VAL_POINTER. */
+        const char* str; /**< Value of #ATTO_VAL_STRING. */
+    } as;                /**< The value. */
+} atto_val_t;
+
+/**
+ * Stores a signed integer operand.
+ *
+ * @param val where to store the operand. Not NULL.
+ * @param value the operand.
+ */
+static inline void
+atto_val_set_signed(atto_val_t* const val, const intmax_t value)
+{
+    val->kind = ATTO_VAL_SIGNED;
+    val->as.s = value;
+}
+
+/**
+ * Stores an unsigned integer operand.
+ *
+ * @param val where to store the operand. Not NULL.
+ * @param value the operand.
+ */
+static inline void
+atto_val_set_unsigned(atto_val_t* const val, const uintmax_t value)
+{
+    val->kind = ATTO_VAL_UNSIGNED;
+    val->as.u = value;
+}
+
+/**
+ * Stores a `float` operand.
+ *
+ * @param val where to store the operand. Not NULL.
+ * @param value the operand.
+ */
+static inline void
+atto_val_set_float(atto_val_t* const val, const float value)
+{
+    val->kind = ATTO_VAL_FLOATING;
+    val->digits = FLT_DECIMAL_DIG;
+    val->as.f = (long double) value;
+}
+
+/**
+ * Stores a `double` operand.
+ *
+ * @param val where to store the operand. Not NULL.
+ * @param value the operand.
+ */
+static inline void
+atto_val_set_double(atto_val_t* const val, const double value)
+{
+    val->kind = ATTO_VAL_FLOATING;
+    val->digits = DBL_DECIMAL_DIG;
+    val->as.f = (long double) value;
+}
+
+/**
+ * Stores a `long double` operand.
+ *
+ * @param val where to store the operand. Not NULL.
+ * @param value the operand.
+ */
+static inline void
+atto_val_set_long_double(atto_val_t* const val, const long double value)
+{
+    val->kind = ATTO_VAL_FLOATING;
+    val->digits = LDBL_DECIMAL_DIG;
+    val->as.f = value;
+}
+
+/**
+ * Stores a pointer operand.
+ *
+ * @param val where to store the operand. Not NULL.
+ * @param value the operand.
+ */
+static inline void
+atto_val_set_pointer(atto_val_t* const val, const void* const value)
+{
+    val->kind = ATTO_VAL_POINTER;
+    val->as.p = value;
+}
+
+/**
+ * Stores a string operand.
+ *
+ * @param val where to store the operand. Not NULL.
+ * @param value the operand, may be NULL.
+ */
+static inline void
+atto_val_set_string(atto_val_t* const val, const char* const value)
+{
+    val->kind = ATTO_VAL_STRING;
+    val->as.str = value;
+}
+
+/**
+ * Evaluates the expression once and stores it into the #atto_val_t variable,
+ * choosing the kind from the type of the expression.
+ */
+#define ATTO_VAL_SET(val, expression)                        \
+    _Generic((expression),                                   \
+        _Bool: atto_val_set_unsigned,                        \
+        char: atto_val_set_signed,                           \
+        signed char: atto_val_set_signed,                    \
+        short: atto_val_set_signed,                          \
+        int: atto_val_set_signed,                            \
+        long: atto_val_set_signed,                           \
+        long long: atto_val_set_signed,                      \
+        unsigned char: atto_val_set_unsigned,                \
+        unsigned short: atto_val_set_unsigned,               \
+        unsigned int: atto_val_set_unsigned,                 \
+        unsigned long: atto_val_set_unsigned,                \
+        unsigned long long: atto_val_set_unsigned,           \
+        float: atto_val_set_float,                           \
+        double: atto_val_set_double,                         \
+        long double: atto_val_set_long_double,               \
+        char*: atto_val_set_string,                          \
+        const char*: atto_val_set_string,                    \
+        default: atto_val_set_pointer)(&(val), (expression))
+
+/**
+ * Integer or pointer operand as an unsigned integer, for mixed comparisons.
+ *
+ * @param val operand that is neither floating nor a negative signed integer.
+ * @return the operand as unsigned integer.
+ */
+static inline uintmax_t
+atto_val_as_unsigned(const atto_val_t* const val)
+{
+    switch (val->kind)
+    {
+        case ATTO_VAL_SIGNED:
+            return (uintmax_t) val->as.s;
+        case ATTO_VAL_UNSIGNED:
+            return val->as.u;
+        case ATTO_VAL_FLOATING:
+            return (uintmax_t) val->as.f;
+        case ATTO_VAL_POINTER:
+            return (uintmax_t) (uintptr_t) val->as.p;
+        case ATTO_VAL_STRING:
+            return (uintmax_t) (uintptr_t) val->as.str;
+        default:
+            return 0U;
+    }
+}
+
+/**
+ * Any operand as a floating value, for comparisons involving floats.
+ *
+ * @param val operand.
+ * @return the operand as `long double`.
+ */
+static inline long double
+atto_val_as_floating(const atto_val_t* const val)
+{
+    switch (val->kind)
+    {
+        case ATTO_VAL_SIGNED:
+            return (long double) val->as.s;
+        case ATTO_VAL_FLOATING:
+            return val->as.f;
+        case ATTO_VAL_UNSIGNED:
+        case ATTO_VAL_POINTER:
+        case ATTO_VAL_STRING:
+        default:
+            return (long double) atto_val_as_unsigned(val);
+    }
+}
+
+/**
+ * Compares two operands by their mathematical value.
+ *
+ * Unlike the C operators, a negative signed integer is always smaller than
+ * any unsigned integer. Two non-NULL strings are compared by content with
+ * `strcmp()`, everything else involving a pointer by address.
+ *
+ * Inlined, so when the kinds are known at compile time only the relevant
+ * comparison remains on the passing path.
+ *
+ * @param a left operand. Not NULL.
+ * @param b right operand. Not NULL.
+ * @return -1 if \p a is smaller, 0 if equal, 1 if greater or
+ * #ATTO_VAL_UNORDERED if either is NaN.
+ */
+static inline int
+atto_val_cmp(const atto_val_t* const a, const atto_val_t* const b)
+{
+    if (a->kind == ATTO_VAL_FLOATING || b->kind == ATTO_VAL_FLOATING)
+    {
+        const long double x = atto_val_as_floating(a);
+        const long double y = atto_val_as_floating(b);
+        if (isless(x, y))
+        {
+            return -1;
+        }
+        if (isgreater(x, y))
+        {
+            return 1;
+        }
+        return x == y ? 0 : ATTO_VAL_UNORDERED;
+    }
+    if (a->kind == ATTO_VAL_STRING && b->kind == ATTO_VAL_STRING && a->as.str != NULL
+        && b->as.str != NULL)
+    {
+        const int order = strcmp(a->as.str, b->as.str);
+        return (order > 0) - (order < 0);
+    }
+    const int a_negative = a->kind == ATTO_VAL_SIGNED && a->as.s < 0;
+    const int b_negative = b->kind == ATTO_VAL_SIGNED && b->as.s < 0;
+    if (a_negative && b_negative)
+    {
+        return (a->as.s > b->as.s) - (a->as.s < b->as.s);
+    }
+    if (a_negative || b_negative)
+    {
+        return a_negative ? -1 : 1;
+    }
+    const uintmax_t x = atto_val_as_unsigned(a);
+    const uintmax_t y = atto_val_as_unsigned(b);
+    return (x > y) - (x < y);
+}
+
+/**
+ * Prints the compared expressions and their values on the current line of
+ * the standard output, without terminating the line.
+ *
+ * Format: `| count == expected | Left: 3 | Right: 4`
+ *
+ * @param comparison source code of the comparison, e.g. `"count == expected"`.
+ * @param a value of the left operand. Not NULL.
+ * @param b value of the right operand. Not NULL.
+ */
+void
+atto_val_print(const char* comparison, const atto_val_t* a, const atto_val_t* b);
+
+/**
+ * Evaluates both operands once, compares them with atto_val_cmp() and checks
+ * the `holds` condition on the result, available as `atto_val_order`.
+ * The `comparison` is the source code text printed on failure.
+ *
+ * Base of all typed assertions. The values are formatted only on failure.
+ */
+#define ATTO_VAL_ASSERT(a, b, comparison, holds)                                            \
+    do                                                                                      \
+    {                                                                                       \
+        atto_val_t atto_val_a;                                                              \
+        atto_val_t atto_val_b;                                                              \
+        ATTO_VAL_SET(atto_val_a, a);                                                        \
+        ATTO_VAL_SET(atto_val_b, b);                                                        \
+        const int atto_val_order = atto_val_cmp(&atto_val_a, &atto_val_b);                  \
+        atto_assert_details(holds, atto_val_print((comparison), &atto_val_a, &atto_val_b)); \
+    }                                                                                       \
+    while (0)
+
+/**
+ * Verifies if the two values are equal, evaluating each of them once.
+ *
+ * Works with any mix of integers, floating point values, pointers and
+ * strings, the latter compared by content. Otherwise stops the test case and
+ * reports on standard output, including both values on the `FAIL` line.
+ *
+ * Example:
+ * ```
+ * atto_val_eq(parse_int("42"), 42);    // Passes
+ * atto_val_eq(-1, 0xFFFFFFFFU);        // Fails, unlike atto_eq()
+ * atto_val_eq(name, "atto");           // Compares the content
+ * atto_val_eq(queue_len(&queue), 3U);
+ * // FAIL | File: test.c:12 | Test case: test_queue | queue_len(&queue) == 3U
+ * //      | Left: 2 | Right: 3
+ * ```
+ */
+#define atto_val_eq(a, b) ATTO_VAL_ASSERT(a, b, #a " == " #b, atto_val_order == 0)
+
+/**
+ * Verifies if the two values are different, evaluating each of them once.
+ *
+ * As atto_val_eq(). NaN is different from any value, including NaN.
+ *
+ * Example:
+ * ```
+ * atto_val_neq(strdup("abc"), NULL);  // Passes
+ * atto_val_neq(NAN, NAN);             // Passes
+ * atto_val_neq("abc", "abc");         // Fails
+ * ```
+ */
+#define atto_val_neq(a, b) ATTO_VAL_ASSERT(a, b, #a " != " #b, atto_val_order != 0)
+
+/**
+ * Verifies if the first value is smaller than the second, evaluating each of
+ * them once.
+ *
+ * As atto_val_eq(). Fails if either value is NaN.
+ *
+ * Example:
+ * ```
+ * atto_val_lt(-1, 0U);     // Passes, unlike atto_lt()
+ * atto_val_lt("ab", "b");  // Passes
+ * atto_val_lt(2.0, 1);     // Fails
+ * ```
+ */
+#define atto_val_lt(a, b) ATTO_VAL_ASSERT(a, b, #a " < " #b, atto_val_order == -1)
+
+/**
+ * Verifies if the first value is smaller than or equal to the second,
+ * evaluating each of them once.
+ *
+ * As atto_val_eq(). Fails if either value is NaN.
+ *
+ * Example:
+ * ```
+ * atto_val_le(1, 1.0f);   // Passes
+ * atto_val_le(1U, -1);    // Fails
+ * ```
+ */
+#define atto_val_le(a, b)                                                            \
+    ATTO_VAL_ASSERT(a, b, #a " <= " #b, atto_val_order == -1 || atto_val_order == 0)
+
+/**
+ * Verifies if the first value is greater than the second, evaluating each of
+ * them once.
+ *
+ * As atto_val_eq(). Fails if either value is NaN.
+ *
+ * Example:
+ * ```
+ * atto_val_gt(0U, -1);   // Passes, unlike atto_gt()
+ * atto_val_gt(1.0, NAN); // Fails
+ * ```
+ */
+#define atto_val_gt(a, b) ATTO_VAL_ASSERT(a, b, #a " > " #b, atto_val_order == 1)
+
+/**
+ * Verifies if the first value is greater than or equal to the second,
+ * evaluating each of them once.
+ *
+ * As atto_val_eq(). Fails if either value is NaN.
+ *
+ * Example:
+ * ```
+ * atto_val_ge(elapsed_ms(), 100U);
+ * // FAIL | File: test.c:12 | Test case: test_timeout | elapsed_ms() >= 100U
+ * //      | Left: 99 | Right: 100
+ * ```
+ */
+#define atto_val_ge(a, b)                                                           \
+    ATTO_VAL_ASSERT(a, b, #a " >= " #b, atto_val_order == 1 || atto_val_order == 0)
+
+#endif /* ATTO_VAL_H */
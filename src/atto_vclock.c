@@ -0,0 +1,242 @@
+/**
+ * @file
+ * @internal
+ * Atto vclock - virtual clock to run time-dependent test cases without
+ * real sleeps
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(ATTO_VCLOCK_INTERPOSE) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE /* For RTLD_NEXT */
+#elif !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For nanosleep() */
+#endif
+
+#include "atto_vclock.h"
+#include <errno.h>
+#include <time.h>
+#if defined(ATTO_VCLOCK_INTERPOSE)
+    #include <dlfcn.h>
+    #include <unistd.h>
+#endif
+
+static struct
+{
+    int enabled;
+    uint64_t now_ns;        // Virtual monotonic time
+    uint64_t start_ns;      // Real monotonic time at enabling
+    struct timespec epoch;  // Real wall-clock time at enabling
+    atto_vclock_sleeper_fn sleeper;
+} vclock;
+
+#if defined(ATTO_VCLOCK_INTERPOSE)
+typedef int (*clock_gettime_fn)(clockid_t, struct timespec*);
+typedef int (*nanosleep_fn)(const struct timespec*, struct timespec*);
+
+static clock_gettime_fn real_clock_gettime = NULL;
+static nanosleep_fn real_nanosleep = NULL;
+
+static void
+resolve_real_functions(void)
+{
+    if (real_clock_gettime == NULL)
+    {
+        // Converting from void* through a union, as ISO C forbids the cast
+        union
+        {
+            void* object;
+            clock_gettime_fn function;
+        } clock_symbol = {.object = dlsym(RTLD_NEXT, "clock_gettime")};
+        union
+        {
+            void* object;
+            nanosleep_fn function;
+        } sleep_symbol = {.object = dlsym(RTLD_NEXT, "nanosleep")};
+        real_nanosleep = sleep_symbol.function;
+        real_clock_gettime = clock_symbol.function;
+    }
+}
+
+    #define REAL_CLOCK_GETTIME(id, ts) (resolve_real_functions(), real_clock_gettime((id), (ts)))
+    #define REAL_NANOSLEEP(req, rem)   (resolve_real_functions(), real_nanosleep((req), (rem)))
+#else
+    #define REAL_CLOCK_GETTIME(id, ts) clock_gettime((id), (ts))
+    #define REAL_NANOSLEEP(req, rem)   nanosleep((req), (rem))
+#endif
+
+/** Real time of the monotonic clock replaced by the virtual one. */
+static uint64_t
+real_monotonic_ns(void)
+{
+    struct timespec ts;
+
+    REAL_CLOCK_GETTIME(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000U + (uint64_t) ts.tv_nsec;
+}
+
+void
+atto_vclock_enable(void)
+{
+    vclock.start_ns = real_monotonic_ns();
+    vclock.now_ns = vclock.start_ns;
+    REAL_CLOCK_GETTIME(CLOCK_REALTIME, &vclock.epoch);
+    vclock.enabled = 1;
+}
+
+void
+atto_vclock_disable(void)
+{
+    vclock.enabled = 0;
+}
+
+int
+atto_vclock_is_enabled(void)
+{
+    return vclock.enabled;
+}
+
+uint64_t
+atto_vclock_now_ns(void)
+{
+    return vclock.enabled ? vclock.now_ns : real_monotonic_ns();
+}
+
+static void
+real_sleep_ns(const uint64_t duration_ns)
+{
+    struct timespec remaining = {
+        .tv_sec = (time_t) (duration_ns / 1000000000U),
+        .tv_nsec = (long) (duration_ns % 1000000000U),
+    };
+    while (REAL_NANOSLEEP(&remaining, &remaining) != 0 && errno == EINTR) {}
+}
+
+void
+atto_vclock_sleep_ns(const uint64_t duration_ns)
+{
+    if (!vclock.enabled)
+    {
+        real_sleep_ns(duration_ns);
+    }
+    else if (vclock.sleeper == NULL || !vclock.sleeper(duration_ns))
+    {
+        vclock.now_ns += duration_ns;
+    }
+}
+
+void
+atto_vclock_advance_ns(const uint64_t duration_ns)
+{
+    if (vclock.enabled)
+    {
+        vclock.now_ns += duration_ns;
+    }
+}
+
+void
+atto_vclock_set_sleeper(const atto_vclock_sleeper_fn sleeper)
+{
+    vclock.sleeper = sleeper;
+}
+
+#if defined(ATTO_VCLOCK_INTERPOSE)
+
+static uint64_t
+timespec_to_ns(const struct timespec* const ts)
+{
+    return (uint64_t) ts->tv_sec * 1000000000U + (uint64_t) ts->tv_nsec;
+}
+
+static void
+ns_to_timespec(const uint64_t ns, struct timespec* const ts)
+{
+    ts->tv_sec = (time_t) (ns / 1000000000U);
+    ts->tv_nsec = (long) (ns % 1000000000U);
+}
+
+// Replacements of the C library functions, found first by the dynamic linker
+
+int
+clock_gettime(const clockid_t id, struct timespec* const ts)
+{
+    if (vclock.enabled)
+    {
+        switch (id)
+        {
+            case CLOCK_MONOTONIC:
+            case CLOCK_MONOTONIC_COARSE:
+            case CLOCK_BOOTTIME:
+                ns_to_timespec(vclock.now_ns, ts);
+                return 0;
+            case CLOCK_REALTIME:
+            case CLOCK_REALTIME_COARSE:
+                ns_to_timespec(timespec_to_ns(&vclock.epoch) + (vclock.now_ns - vclock.start_ns),
+                               ts);
+                return 0;
+            default:
+                break;  // Raw monotonic and CPU-time clocks stay real
+        }
+    }
+    return REAL_CLOCK_GETTIME(id, ts);
+}
+
+int
+nanosleep(const struct timespec* const duration, struct timespec* const remaining)
+{
+    if (!vclock.enabled)
+    {
+        return REAL_NANOSLEEP(duration, remaining);
+    }
+    atto_vclock_sleep_ns(timespec_to_ns(duration));
+    if (remaining != NULL)
+    {
+        remaining->tv_sec = 0;
+        remaining->tv_nsec = 0;
+    }
+    return 0;
+}
+
+int
+usleep(const useconds_t duration_us)
+{
+    const struct timespec duration = {
+        .tv_sec = (time_t) (duration_us / 1000000U),
+        .tv_nsec = (long) (duration_us % 1000000U) * 1000L,
+    };
+    return nanosleep(&duration, NULL);
+}
+
+unsigned int
+sleep(const unsigned int duration_s)
+{
+    const struct timespec duration = {.tv_sec = (time_t) duration_s, .tv_nsec = 0};
+    return nanosleep(&duration, NULL) == 0 ? 0U : duration_s;
+}
+
+#endif
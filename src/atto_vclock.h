@@ -0,0 +1,143 @@
+/**
+ * @file
+ * Atto vclock - virtual clock to run time-dependent test cases without
+ * real sleeps
+ *
+ * Optional interposition of `clock_gettime()`, `nanosleep()`, `usleep()` and
+ * `sleep()` requires Linux.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_VCLOCK_H
+#define ATTO_VCLOCK_H
+
+#include "atto.h"
+#include <stdint.h> /* For uint64_t */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Function handling a sleep on the virtual clock instead of simply advancing
+ * it, e.g. by suspending the calling coroutine.
+ *
+ * @param duration_ns how long to sleep in virtual nanoseconds.
+ * @return non-zero if the sleep was handled, 0 to let the virtual clock
+ * advance immediately.
+ */
+typedef int (*atto_vclock_sleeper_fn)(uint64_t duration_ns);
+
+/**
+ * Switches to virtual time, starting from the current real time.
+ *
+ * From now on atto_vclock_now_ns() only advances when something sleeps on
+ * the virtual clock or with atto_vclock_advance_ns(), so timeouts, retries
+ * and backoffs complete instantly and deterministically.
+ *
+ * When the source file is compiled with `ATTO_VCLOCK_INTERPOSE` defined on
+ * Linux, the test executable also replaces `clock_gettime()` (except
+ * `CLOCK_MONOTONIC_RAW` and the CPU-time clocks), `nanosleep()`, `usleep()`
+ * and `sleep()` of the C library, so the code under test uses the virtual
+ * clock without changes. The real clock of atto_time_ns(), used to report
+ * the durations of the test cases, is never virtual.
+ *
+ * Not thread-safe: meant for the single-threaded test cases, also when run
+ * as coroutines by the Atto async module.
+ */
+void
+atto_vclock_enable(void);
+
+/**
+ * Switches back to real time.
+ */
+void
+atto_vclock_disable(void);
+
+/**
+ * Whether the virtual time is enabled.
+ *
+ * @return non-zero if enabled, 0 otherwise.
+ */
+int
+atto_vclock_is_enabled(void);
+
+/**
+ * Current value of the virtual monotonic clock in nanoseconds, or of the real
+ * `CLOCK_MONOTONIC` when the virtual time is disabled.
+ *
+ * The virtual clock starts from the real `CLOCK_MONOTONIC`, so timestamps
+ * taken before enabling, while enabled and after disabling are comparable,
+ * although disabling can move the clock back by the virtual time skipped.
+ * Not comparable with atto_time_ns(), which uses `CLOCK_MONOTONIC_RAW`.
+ *
+ * @return monotonic timestamp in nanoseconds.
+ */
+uint64_t
+atto_vclock_now_ns(void);
+
+/**
+ * Sleeps on the virtual clock for the given duration.
+ *
+ * With virtual time, it returns immediately having advanced the virtual
+ * clock, unless a sleeper is installed with atto_vclock_set_sleeper() and it
+ * handles the sleep. With real time, it really sleeps.
+ *
+ * @param duration_ns how long to sleep in nanoseconds.
+ */
+void
+atto_vclock_sleep_ns(uint64_t duration_ns);
+
+/**
+ * Advances the virtual clock by the given duration, without sleeping.
+ *
+ * Does nothing when the virtual time is disabled.
+ *
+ * @param duration_ns how much to advance the virtual clock by.
+ */
+void
+atto_vclock_advance_ns(uint64_t duration_ns);
+
+/**
+ * Installs a function handling the sleeps on the virtual clock.
+ *
+ * Used by the Atto async module to suspend the sleeping coroutine until all
+ * other coroutines are blocked as well, before advancing the time.
+ *
+ * @param sleeper the sleep handler or NULL to remove it.
+ */
+void
+atto_vclock_set_sleeper(atto_vclock_sleeper_fn sleeper);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_VCLOCK_H */
@@ -0,0 +1,497 @@
+/**
+ * @file
+ * @internal
+ * Atto vec - test vectors read lazily from memory-mapped KAT or binary files
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For posix_madvise() */
+#endif
+
+#include "atto_vec.h"
+#include "atto_pool.h"
+#include <fcntl.h>    /* For open() */
+#include <stdint.h>   /* For SIZE_MAX */
+#include <sys/mman.h> /* For mmap() */
+#include <sys/stat.h> /* For fstat() */
+#include <unistd.h>   /* For close() */
+
+/** First bytes of a binary test-vector file, including the format version. */
+static const char binary_magic[8] = {'A', 'T', 'T', 'O', 'V', 'E', 'C', '1'};
+
+/**
+ * Amount of cursors saved while counting the records, so each worker starts
+ * parsing right at its chunk instead of from the first record.
+ */
+#define VEC_CHECKPOINTS (16U * ATTO_VEC_MAX_WORKERS)
+
+/** Records tested in parallel, split into chunks starting at checkpoints. */
+typedef struct
+{
+    const atto_vec_file_t* file;
+    const char* path;
+    atto_vec_body_fn body;
+    void* ctx;
+    size_t stride;
+    size_t total;
+} vec_job_t;
+
+/** Cursors before every stride-th record, saved by count_records(). */
+static atto_vec_cursor_t checkpoints[VEC_CHECKPOINTS];
+
+int
+atto_vec_open(atto_vec_file_t* const file, const char* const path)
+{
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return 1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return 1;
+    }
+    file->size = (size_t) info.st_size;
+    file->data = "";
+    if (file->size > 0U)
+    {
+        void* const mapped = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(fd);
+            return 1;
+        }
+        posix_madvise(mapped, file->size, POSIX_MADV_SEQUENTIAL);
+        file->data = mapped;
+    }
+    close(fd);  // The mapping stays valid
+    file->binary = file->size >= sizeof(binary_magic)
+                   && memcmp(file->data, binary_magic, sizeof(binary_magic)) == 0;
+    return 0;
+}
+
+void
+atto_vec_close(atto_vec_file_t* const file)
+{
+    if (file->size > 0U)
+    {
+        munmap((void*) file->data, file->size);
+    }
+    file->data = "";
+    file->size = 0U;
+}
+
+void
+atto_vec_rewind(const atto_vec_file_t* const file, atto_vec_cursor_t* const cursor)
+{
+    cursor->offset = file->binary ? sizeof(binary_magic) : 0U;
+    cursor->index = 0U;
+    cursor->line = file->binary ? 0U : 1U;
+    cursor->section = NULL;
+    cursor->section_len = 0U;
+    cursor->error = 0;
+}
+
+/** Whether the byte is a space or tab. */
+static int
+is_blank(const char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+/** Parses the next record of a text file, line by line. */
+static int
+next_text(const atto_vec_file_t* const file,
+          atto_vec_cursor_t* const cursor,
+          atto_vec_record_t* const record)
+{
+    while (cursor->offset < file->size)
+    {
+        const char* line = file->data + cursor->offset;
+        const size_t remaining = file->size - cursor->offset;
+        const char* const newline = memchr(line, '\n', remaining);
+        size_t len = newline == NULL ? remaining : (size_t) (newline - line);
+        const size_t next = cursor->offset + len + (newline != NULL);
+        const size_t line_number = cursor->line;
+        while (len > 0U && (is_blank(*line) || *line == '\r'))
+        {
+            line++;
+            len--;
+        }
+        while (len > 0U && (is_blank(line[len - 1U]) || line[len - 1U] == '\r')) { len--; }
+
+        if (len > 0U && line[0] == '[' && record->fields_amount > 0U)
+        {
+            break;  // Section of the next record: parse it next time
+        }
+        cursor->offset = next;
+        cursor->line++;
+        if (len == 0U)
+        {
+            if (record->fields_amount > 0U)
+            {
+                break;  // Blank line ending the record
+            }
+            continue;
+        }
+        if (line[0] == '#')
+        {
+            continue;
+        }
+        if (line[0] == '[')
+        {
+            const char* const closing = memchr(line, ']', len);
+            cursor->section = line + 1;
+            cursor->section_len = closing == NULL ? len - 1U : (size_t) (closing - line) - 1U;
+            continue;
+        }
+        const char* const equals = memchr(line, '=', len);
+        if (equals == NULL)
+        {
+            continue;
+        }
+        size_t name_len = (size_t) (equals - line);
+        while (name_len > 0U && is_blank(line[name_len - 1U])) { name_len--; }
+        const char* value = equals + 1;
+        size_t value_len = len - (size_t) (value - line);
+        while (value_len > 0U && is_blank(*value))
+        {
+            value++;
+            value_len--;
+        }
+        if (record->fields_amount == 0U)
+        {
+            record->line = line_number;
+        }
+        if (record->fields_amount < ATTO_VEC_MAX_FIELDS)
+        {
+            atto_vec_field_t* const field = &record->fields[record->fields_amount++];
+            field->name = line;
+            field->name_len = name_len;
+            field->value = value;
+            field->value_len = value_len;
+        }
+    }
+    return record->fields_amount > 0U;
+}
+
+/** Parses the next record of a binary file. */
+static int
+next_binary(const atto_vec_file_t* const file,
+            atto_vec_cursor_t* const cursor,
+            atto_vec_record_t* const record)
+{
+    const unsigned char* const data = (const unsigned char*) file->data;
+    size_t offset = cursor->offset;
+    if (offset >= file->size)
+    {
+        return 0;
+    }
+    const size_t fields = data[offset++];
+    for (size_t i = 0U; i < fields; i++)
+    {
+        if (offset + 1U > file->size || offset + 1U + data[offset] + 4U > file->size)
+        {
+            cursor->error = 1;
+            cursor->offset = file->size;
+            return 0;
+        }
+        const size_t name_len = data[offset++];
+        const char* const name = file->data + offset;
+        offset += name_len;
+        const size_t value_len = (size_t) data[offset] | (size_t) data[offset + 1U] << 8U
+                                 | (size_t) data[offset + 2U] << 16U
+                                 | (size_t) data[offset + 3U] << 24U;
+        offset += 4U;
+        if (value_len > file->size - offset)
+        {
+            cursor->error = 1;
+            cursor->offset = file->size;
+            return 0;
+        }
+        if (record->fields_amount < ATTO_VEC_MAX_FIELDS)
+        {
+            atto_vec_field_t* const field = &record->fields[record->fields_amount++];
+            field->name = name;
+            field->name_len = name_len;
+            field->value = file->data + offset;
+            field->value_len = value_len;
+        }
+        offset += value_len;
+    }
+    cursor->offset = offset;
+    return 1;
+}
+
+int
+atto_vec_next(const atto_vec_file_t* const file,
+              atto_vec_cursor_t* const cursor,
+              atto_vec_record_t* const record)
+{
+    record->fields_amount = 0U;
+    record->line = 0U;
+    record->binary = file->binary;
+    const int found = file->binary ? next_binary(file, cursor, record)
+                                   : next_text(file, cursor, record);
+    if (found)
+    {
+        record->index = cursor->index++;
+        record->section = cursor->section;
+        record->section_len = cursor->section_len;
+    }
+    return found;
+}
+
+const atto_vec_field_t*
+atto_vec_field(const atto_vec_record_t* const record, const char* const name)
+{
+    const size_t name_len = strlen(name);
+    for (size_t i = 0U; i < record->fields_amount; i++)
+    {
+        const atto_vec_field_t* const field = &record->fields[i];
+        if (field->name_len == name_len && memcmp(field->name, name, name_len) == 0)
+        {
+            return field;
+        }
+    }
+    return NULL;
+}
+
+/** Value of a hex digit or -1 if not a hex digit. */
+static int
+hex_digit(const char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+size_t
+atto_vec_bytes(const atto_vec_record_t* const record,
+               const char* const name,
+               unsigned char* const out,
+               const size_t out_len)
+{
+    const atto_vec_field_t* const field = atto_vec_field(record, name);
+    if (field == NULL)
+    {
+        return SIZE_MAX;
+    }
+    if (record->binary)
+    {
+        if (field->value_len > out_len)
+        {
+            return SIZE_MAX;
+        }
+        memcpy(out, field->value, field->value_len);
+        return field->value_len;
+    }
+    if (field->value_len % 2U != 0U || field->value_len / 2U > out_len)
+    {
+        return SIZE_MAX;
+    }
+    for (size_t i = 0U; i < field->value_len / 2U; i++)
+    {
+        const int high = hex_digit(field->value[2U * i]);
+        const int low = hex_digit(field->value[2U * i + 1U]);
+        if (high < 0 || low < 0)
+        {
+            return SIZE_MAX;
+        }
+        out[i] = (unsigned char) (high << 4 | low);
+    }
+    return field->value_len / 2U;
+}
+
+int
+atto_vec_uint(const atto_vec_record_t* const record,
+              const char* const name,
+              unsigned long long* const value)
+{
+    const atto_vec_field_t* const field = atto_vec_field(record, name);
+    if (field == NULL || field->value_len == 0U)
+    {
+        return 1;
+    }
+    unsigned long long parsed = 0U;
+    for (size_t i = 0U; i < field->value_len; i++)
+    {
+        const char c = field->value[i];
+        if (c < '0' || c > '9' || parsed > (~0ULL - 9U) / 10U)
+        {
+            return 1;
+        }
+        parsed = parsed * 10U + (unsigned long long) (c - '0');
+    }
+    *value = parsed;
+    return 0;
+}
+
+/** Tests up to the given amount of records from the cursor on, reporting failed ones. */
+static size_t
+run_range(const atto_vec_file_t* const file,
+          const char* const path,
+          const atto_vec_body_fn body,
+          void* const ctx,
+          atto_vec_cursor_t cursor,
+          const size_t amount)
+{
+    atto_vec_record_t record;
+    size_t tested = 0U;
+    while (tested < amount && atto_vec_next(file, &cursor, &record))
+    {
+        const size_t failures = atto_counter_assert_failures;
+        body(&record, ctx);
+        tested++;
+        if (atto_counter_assert_failures != failures)
+        {
+            printf("VECTOR | File: %s | Record: %zu | Line: %zu\n",
+                   path,
+                   record.index,
+                   record.line);
+        }
+    }
+    return tested;
+}
+
+/**
+ * Counts the records, saving the cursor before every stride-th one into
+ * checkpoints. When they are full, every other one is dropped and the
+ * stride doubled, so they stay evenly spread over any amount of records.
+ *
+ * @return the stride between the checkpoints.
+ */
+static size_t
+count_records(const atto_vec_file_t* const file, size_t* const total)
+{
+    atto_vec_cursor_t cursor;
+    atto_vec_record_t record;
+    size_t stride = 1U;
+    size_t saved = 0U;
+    atto_vec_rewind(file, &cursor);
+    do
+    {
+        if (saved == VEC_CHECKPOINTS && cursor.index == saved * stride)
+        {
+            for (size_t i = 0U; i < saved / 2U; i++) { checkpoints[i] = checkpoints[2U * i]; }
+            saved /= 2U;
+            stride *= 2U;
+        }
+        if (cursor.index % stride == 0U)
+        {
+            checkpoints[saved++] = cursor;
+        }
+    }
+    while (atto_vec_next(file, &cursor, &record));
+    *total = cursor.index;
+    return stride;
+}
+
+/**
+ * Tests the chunk of records of one worker.
+ *
+ * The chunks start at checkpoints of count_records(), so each record is
+ * parsed once by the counting and once by its worker only. They are thus
+ * balanced up to a stride, a small fraction of a chunk.
+ */
+static size_t
+run_chunk(void* const job_ctx, const size_t worker, const size_t workers)
+{
+    const vec_job_t* const job = job_ctx;
+    const size_t first = worker * job->total / workers / job->stride;
+    const size_t end = (worker + 1U) * job->total / workers / job->stride;
+    const size_t amount = worker + 1U == workers ? SIZE_MAX : (end - first) * job->stride;
+    return run_range(job->file, job->path, job->body, job->ctx, checkpoints[first], amount);
+}
+
+/** Reports the chunk of a crashed worker. */
+static void
+chunk_crashed(void* const job_ctx, const size_t worker)
+{
+    const vec_job_t* const job = job_ctx;
+    printf("FAIL | File: %s:%d | Test case: %s | Vector file: %s | Worker: %zu | Crashed\n",
+           __FILE__,
+           __LINE__,
+           atto_current_test == NULL ? "-" : atto_current_test,
+           job->path,
+           worker);
+}
+
+size_t
+atto_vec_run(const char* const path,
+             const atto_vec_body_fn body,
+             void* const ctx,
+             size_t workers)
+{
+    atto_vec_file_t file;
+    if (atto_vec_open(&file, path) != 0)
+    {
+        printf("FAIL | File: %s:%d | Test case: %s | Vector file: %s | Cannot be mapped\n",
+               __FILE__,
+               __LINE__,
+               atto_current_test == NULL ? "-" : atto_current_test,
+               path);
+        atto_counter_assert_failures++;
+        atto_at_least_one_fail = 1;
+        return 0U;
+    }
+    vec_job_t job = {
+        .file = &file,
+        .path = path,
+        .body = body,
+        .ctx = ctx,
+        .stride = 1U,
+        .total = 0U,
+    };
+    workers = workers > ATTO_VEC_MAX_WORKERS ? ATTO_VEC_MAX_WORKERS : workers;
+    if (workers > 1U)
+    {
+        job.stride = count_records(&file, &job.total);
+    }
+    else
+    {
+        atto_vec_rewind(&file, &checkpoints[0]);  // One chunk of all records
+    }
+    const size_t tested = atto_pool_run(run_chunk, chunk_crashed, &job, workers);
+    atto_vec_close(&file);
+    return tested;
+}
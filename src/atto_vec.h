@@ -0,0 +1,256 @@
+/**
+ * @file
+ * Atto vec - test vectors read lazily from memory-mapped KAT or binary files
+ *
+ * Requires POSIX `mmap()` and `fork()`.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-Clause License
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. Neither the name of nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific
+ *    prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDER AND CONTRIBUTORS “AS IS”
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATTO_VEC_H
+#define ATTO_VEC_H
+
+#include "atto.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Maximum amount of fields of a record. Further fields are ignored.
+ */
+#ifndef ATTO_VEC_MAX_FIELDS
+    #define ATTO_VEC_MAX_FIELDS (16U)
+#endif
+
+/**
+ * Maximum amount of worker processes of atto_vec_run().
+ */
+#ifndef ATTO_VEC_MAX_WORKERS
+    #define ATTO_VEC_MAX_WORKERS (64U)
+#endif
+
+/**
+ * A `name = value` field of a record, pointing straight into the mapped file.
+ *
+ * Neither the name nor the value are null-terminated.
+ */
+typedef struct
+{
+    const char* name;  /**< Name of the field, e.g. `Key`. */
+    size_t name_len;   /**< Length of the name in bytes. */
+    const char* value; /**< Hex text or raw bytes of a binary file. */
+    size_t value_len;  /**< Length of the value in bytes. */
+} atto_vec_field_t;
+
+/**
+ * One test vector: a group of fields, pointing straight into the mapped file.
+ */
+typedef struct
+{
+    size_t index;                                 /**< Position in the file, from 0. */
+    size_t line;                                  /**< Line of the first field, 0 if binary. */
+    const char* section;                          /**< Last `[section]` header, not terminated. */
+    size_t section_len;                           /**< Length of the section, 0 if none. */
+    int binary;                                   /**< 1 if raw values from a binary file. */
+    size_t fields_amount;                         /**< Amount of fields. */
+    atto_vec_field_t fields[ATTO_VEC_MAX_FIELDS]; /**< The fields in file order. */
+} atto_vec_record_t;
+
+/**
+ * Memory-mapped test-vector file.
+ */
+typedef struct
+{
+    const char* data; /**< Content of the file. */
+    size_t size;      /**< Size of the file in bytes. */
+    int binary;       /**< 1 if in the binary format, 0 if text. */
+} atto_vec_file_t;
+
+/**
+ * Position of the next record to parse in a test-vector file.
+ */
+typedef struct
+{
+    size_t offset;       /**< Offset of the next byte to parse. */
+    size_t index;        /**< Index of the next record. */
+    size_t line;         /**< Line of the next byte to parse, from 1. */
+    const char* section; /**< Last `[section]` header seen. */
+    size_t section_len;  /**< Length of the section, 0 if none. */
+    int error;           /**< 1 if a truncated binary record was found. */
+} atto_vec_cursor_t;
+
+/**
+ * Test body called once per record by atto_vec_run().
+ *
+ * Atto assertions in it fail the current record only: the following records
+ * are still tested.
+ *
+ * @param record the record to test.
+ * @param ctx user context. May be NULL.
+ */
+typedef void (*atto_vec_body_fn)(const atto_vec_record_t* record, void* ctx);
+
+/**
+ * Maps a test-vector file into memory, read-only.
+ *
+ * Two formats are supported, detected automatically:
+ * - Text, as the NIST Known Answer Test (KAT) files: `Name = value` lines,
+ *   records separated by blank lines, `#` comments and `[section]` headers.
+ * - Binary: the 8 bytes `ATTOVEC1`, then per record 1 byte with the amount
+ *   of fields, then per field 1 byte with the name length, the name, 4 bytes
+ *   with the value length (little endian) and the raw value.
+ *
+ * @param file where to store the mapping. Not NULL.
+ * @param path file to map. Not NULL.
+ * @return 0 on success, 1 if the file could not be opened or mapped.
+ */
+int
+atto_vec_open(atto_vec_file_t* file, const char* path);
+
+/**
+ * Unmaps a test-vector file. All records pointing into it become invalid.
+ *
+ * @param file mapping to release. Not NULL.
+ */
+void
+atto_vec_close(atto_vec_file_t* file);
+
+/**
+ * Sets the cursor to the first record of the file.
+ *
+ * @param file mapped file. Not NULL.
+ * @param cursor cursor to initialise. Not NULL.
+ */
+void
+atto_vec_rewind(const atto_vec_file_t* file, atto_vec_cursor_t* cursor);
+
+/**
+ * Parses the next record, without copying nor decoding any value.
+ *
+ * @param file mapped file. Not NULL.
+ * @param cursor position to parse from, advanced past the record. Not NULL.
+ * @param record where to store the record. Not NULL.
+ * @return 1 if a record was parsed, 0 at the end of the file.
+ */
+int
+atto_vec_next(const atto_vec_file_t* file, atto_vec_cursor_t* cursor, atto_vec_record_t* record);
+
+/**
+ * Finds a field of the record by name, case-sensitive.
+ *
+ * @param record record to search in. Not NULL.
+ * @param name name of the field. Not NULL.
+ * @return the first field with the name or NULL if missing.
+ */
+const atto_vec_field_t*
+atto_vec_field(const atto_vec_record_t* record, const char* name);
+
+/**
+ * Copies the bytes of a field, decoding them from hex in text files.
+ *
+ * An empty value gives 0 bytes. Both upper and lower case hex digits are
+ * accepted.
+ *
+ * @param record record to read from. Not NULL.
+ * @param name name of the field. Not NULL.
+ * @param out where to store the bytes. Not NULL.
+ * @param out_len capacity of \p out in bytes.
+ * @return amount of bytes stored or `SIZE_MAX` if the field is missing, is
+ * not valid hex or does not fit into \p out.
+ */
+size_t
+atto_vec_bytes(const atto_vec_record_t* record,
+               const char* name,
+               unsigned char* out,
+               size_t out_len);
+
+/**
+ * Parses a field as an unsigned decimal integer, e.g. `COUNT`.
+ *
+ * @param record record to read from. Not NULL.
+ * @param name name of the field. Not NULL.
+ * @param value where to store the integer. Not NULL.
+ * @return 0 on success, 1 if the field is missing or not a decimal integer.
+ */
+int
+atto_vec_uint(const atto_vec_record_t* record, const char* name, unsigned long long* value);
+
+/**
+ * Calls the test body once per record of a test-vector file.
+ *
+ * When a record fails any assertion, prints a `VECTOR` line with the record
+ * index and its line in the file right after the `FAIL` line:
+ *
+ * ```
+ * FAIL | File: test_aes.c:31 | Test case: check_record
+ * VECTOR | File: AESGCMEncrypt128.rsp | Record: 4177 | Line: 20884
+ * ```
+ *
+ * With more than 1 worker, the records are split into contiguous chunks,
+ * each tested by a forked worker process sharing the same mapping. The
+ * counters of passed and failed assertions of the workers are added to the
+ * counters of the calling process at the end.
+ *
+ * Example:
+ * ```
+ * static void
+ * check_record(const atto_vec_record_t* record, void* ctx)
+ * {
+ *     unsigned char key[16], pt[64], ct[64], out[64];
+ *     atto_eq(atto_vec_bytes(record, "Key", key, sizeof(key)), sizeof(key));
+ *     const size_t len = atto_vec_bytes(record, "PT", pt, sizeof(pt));
+ *     atto_eq(atto_vec_bytes(record, "CT", ct, sizeof(ct)), len);
+ *     encrypt(key, pt, len, out);
+ *     atto_memeq(out, ct, len);
+ * }
+ *
+ * static void
+ * test_kat(void)
+ * {
+ *     atto_gt(atto_vec_run("AESGCMEncrypt128.rsp", check_record, NULL, 8U), 0U);
+ * }
+ * ```
+ *
+ * @param path test-vector file. Not NULL.
+ * @param body test body. Not NULL.
+ * @param ctx user context passed to \p body. May be NULL.
+ * @param workers amount of worker processes in [1, #ATTO_VEC_MAX_WORKERS],
+ * 0 or 1 to test all records in the calling process.
+ * @return amount of tested records, 0 if the file could not be mapped, which
+ * also counts as a failed assertion with a `FAIL` line.
+ */
+size_t
+atto_vec_run(const char* path, atto_vec_body_fn body, void* ctx, size_t workers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATTO_VEC_H */
@@ -282,6 +282,48 @@ test_minusinf_nan(void)
     SHOULD_FAIL(atto_minusinf(NAN));
 }
 
+static void
+test_inf_long_double(void)
+{
+    atto_plusinf((long double) INFINITY);
+    atto_minusinf(-(long double) INFINITY);
+#if LDBL_MAX_EXP > DBL_MAX_EXP
+    // Infinite only once cast to double
+    SHOULD_FAIL(atto_plusinf((long double) DBL_MAX * 2.0L));
+#else
+    SHOULD_FAIL(atto_plusinf(LDBL_MAX));
+#endif
+}
+
+static void
+test_minusinf_long_double(void)
+{
+#if LDBL_MAX_EXP > DBL_MAX_EXP
+    SHOULD_FAIL(atto_minusinf((long double) -DBL_MAX * 2.0L));
+#else
+    SHOULD_FAIL(atto_minusinf(-LDBL_MAX));
+#endif
+}
+
+/** Counts its calls, to verify how many times an argument is evaluated. */
+static size_t evaluations = 0;
+
+static double
+evaluated_value(const double value)
+{
+    evaluations++;
+    return value;
+}
+
+static void
+test_inf_evaluates_value_once(void)
+{
+    evaluations = 0;
+    atto_plusinf(evaluated_value((double) INFINITY));
+    atto_minusinf(evaluated_value((double) -INFINITY));
+    atto_eq(evaluations, 2U);
+}
+
 static void
 test_notfinite(void)
 {
@@ -488,6 +530,62 @@ test_fail(void)
     SHOULD_FAIL(atto_fail());
 }
 
+static size_t hook_before_calls = 0;
+static size_t hook_after_calls = 0;
+static const char* hook_last_name = NULL;
+
+static void
+hook_before(const char* const test_name)
+{
+    hook_before_calls++;
+    hook_last_name = test_name;
+}
+
+static void
+hook_after(const char* const test_name)
+{
+    hook_after_calls++;
+    hook_last_name = test_name;
+}
+
+static void
+test_run_sets_current_test(void)
+{
+    atto_streq(atto_current_test, "test_run_sets_current_test", 100);
+    atto_eq(hook_before_calls, 1U);
+    atto_eq(hook_after_calls, 0U);
+}
+
+static void
+test_run_failing(void)
+{
+    SHOULD_FAIL(atto_fail());
+}
+
+static void
+test_run_with_hooks(void)
+{
+    atto_eq(atto_current_test, NULL);
+    atto_eq(atto_hook_add(hook_before, hook_after), 0);
+    atto_run(test_run_sets_current_test);
+    atto_eq(hook_before_calls, 1U);
+    atto_eq(hook_after_calls, 1U);
+    atto_run(test_run_failing);
+    atto_eq(hook_before_calls, 2U);
+    atto_eq(hook_after_calls, 2U);  // Also after a failure
+    atto_streq(hook_last_name, "test_run_failing", 100);
+    atto_eq(atto_current_test, NULL);
+}
+
+static void
+test_hooks_limit(void)
+{
+    size_t added = 1U;  // Already one from the previous test case
+    while (atto_hook_add(NULL, NULL) == 0) { added++; }
+    atto_eq(added, ATTO_MAX_HOOKS);
+    atto_eq(atto_hook_add(NULL, NULL), 1);
+}
+
 static void
 test_at_the_end_some_tests_have_failed(void)
 {
@@ -534,6 +632,9 @@ main(void)
     test_minusinf_finite_float();
     test_minusinf_finite_double();
     test_minusinf_nan();
+    test_inf_long_double();
+    test_minusinf_long_double();
+    test_inf_evaluates_value_once();
     test_notfinite();
     test_notfinite_finite_float();
     test_notfinite_finite_double();
@@ -552,6 +653,8 @@ main(void)
     test_zeros();
     test_nzeros();
     test_fail();
+    test_run_with_hooks();
+    test_hooks_limit();
     test_at_the_end_some_tests_have_failed();
     atto_report();
 
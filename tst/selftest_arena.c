@@ -0,0 +1,100 @@
+/**
+ * @file
+ * Example usage of Atto arena and also the test for Atto arena itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_arena.h"
+#include <stdint.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+/** Kept across test cases to verify the poisoning after the reset. */
+static unsigned char* previous_allocation = NULL;
+
+static void
+test_allocations_are_aligned(void)
+{
+    for (size_t size = 1U; size < 100U; size += 7U)
+    {
+        unsigned char* const data = atto_alloc(size);
+        atto_neq(data, NULL);
+        atto_eq((uintptr_t) data % ATTO_ARENA_ALIGNMENT, 0U);
+        memset(data, 0x11, size);
+    }
+    atto_ge(atto_arena_used(), 15U * ATTO_ARENA_ALIGNMENT);
+}
+
+static void
+test_allocate_and_keep(void)
+{
+    previous_allocation = atto_alloc(64U);
+    atto_neq(previous_allocation, NULL);
+    memset(previous_allocation, 0x00, 64U);
+    atto_zeros(previous_allocation, 64U);
+}
+
+static void
+test_memory_is_released_and_poisoned(void)
+{
+    atto_eq(atto_arena_used(), 0U);
+    for (size_t i = 0U; i < 64U; i++)
+    {
+        atto_eq(previous_allocation[i], ATTO_ARENA_POISON_BYTE);
+    }
+    // Same memory handed out again
+    atto_eq(atto_alloc(1U), previous_allocation);
+}
+
+static void
+test_exhaustion(void)
+{
+    atto_neq(atto_alloc(ATTO_ARENA_SIZE / 2U), NULL);
+    atto_eq(atto_alloc(ATTO_ARENA_SIZE), NULL);
+    atto_eq(atto_alloc(SIZE_MAX), NULL);
+    atto_neq(atto_alloc(ATTO_ARENA_SIZE / 4U), NULL);
+    atto_ge(atto_arena_high_water(), ATTO_ARENA_SIZE / 2U + ATTO_ARENA_SIZE / 4U);
+}
+
+static void
+test_failing_test_still_releases(void)
+{
+    atto_neq(atto_alloc(1000U), NULL);
+    SHOULD_FAIL(atto_fail());
+}
+
+static void
+test_custom_buffer(void)
+{
+    static unsigned char buffer[256];
+    atto_arena_use(buffer, sizeof(buffer));
+    unsigned char* const data = atto_alloc(100U);
+    atto_assert(data >= buffer && data < buffer + sizeof(buffer));
+    atto_eq(atto_alloc(sizeof(buffer)), NULL);
+    atto_arena_reset();
+    atto_eq(data[0], ATTO_ARENA_POISON_BYTE);
+    atto_arena_use(NULL, 0U);
+    atto_neq(atto_alloc(ATTO_ARENA_SIZE / 2U), NULL);
+}
+
+int
+main(void)
+{
+    atto_run(test_allocations_are_aligned);
+    atto_run(test_allocate_and_keep);
+    atto_run(test_memory_is_released_and_poisoned);
+    atto_run(test_exhaustion);
+    atto_run(test_failing_test_still_releases);
+    atto_run(test_custom_buffer);
+    atto_arena_report();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
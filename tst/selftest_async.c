@@ -0,0 +1,197 @@
+/**
+ * @file
+ * Example usage of Atto async and also the test for Atto async itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_async.h"
+#include "atto_time.h"
+#include "atto_vclock.h"
+#include <unistd.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define READERS  (100U)
+#define SLEEPERS (100U)
+#define WAIT     ATTO_MS(50)
+
+static int pipe_fds[READERS][2];
+static size_t readers_done = 0U;
+static size_t sleepers_done = 0U;
+static int code_after_failure_executed = 0;
+
+static void
+test_pipe_reader(void)
+{
+    static size_t next_reader = 0U;
+    const size_t idx = next_reader++;
+    char byte = 0;
+
+    atto_eq(atto_async_wait_fd(pipe_fds[idx][0], ATTO_ASYNC_READ), 0);
+    atto_eq(read(pipe_fds[idx][0], &byte, 1U), 1);
+    atto_eq(byte, (char) idx);
+    readers_done++;
+}
+
+static void
+test_pipe_writer(void)
+{
+    atto_async_sleep_ns(WAIT);
+    for (size_t i = 0U; i < READERS; i++)
+    {
+        const char byte = (char) i;
+        atto_eq(atto_async_wait_fd(pipe_fds[i][1], ATTO_ASYNC_WRITE), 0);
+        atto_eq(write(pipe_fds[i][1], &byte, 1U), 1);
+        atto_async_yield();
+    }
+}
+
+static void
+test_sleeper(void)
+{
+    atto_streq(atto_current_test, "test_sleeper", 100);
+    atto_async_sleep_ns(WAIT);
+    atto_streq(atto_current_test, "test_sleeper", 100);
+    sleepers_done++;
+}
+
+static void
+test_failing_coroutine(void)
+{
+    atto_async_yield();
+    SHOULD_FAIL(atto_fail());
+    code_after_failure_executed = 1;
+}
+
+static void
+test_waits_overlap(void)
+{
+    for (size_t i = 0U; i < READERS; i++)
+    {
+        atto_eq(pipe(pipe_fds[i]), 0);
+        atto_eq(atto_async(test_pipe_reader), 0);
+    }
+    for (size_t i = 0U; i < SLEEPERS; i++) { atto_eq(atto_async(test_sleeper), 0); }
+    atto_eq(atto_async(test_pipe_writer), 0);
+    atto_eq(atto_async(test_failing_coroutine), 0);
+
+    const uint64_t start = atto_time_ns();
+    atto_eq(atto_async_run(), 0);
+    const uint64_t elapsed = atto_time_ns() - start;
+
+    atto_eq(readers_done, READERS);
+    atto_eq(sleepers_done, SLEEPERS);
+    atto_false(code_after_failure_executed);
+    atto_eq(atto_current_test, NULL);
+    atto_ge(elapsed, WAIT);
+    atto_lt(elapsed, 10U * WAIT);  // Sequentially it would take 100x WAIT
+    for (size_t i = 0U; i < READERS; i++)
+    {
+        close(pipe_fds[i][0]);
+        close(pipe_fds[i][1]);
+    }
+}
+
+static void
+test_outside_of_coroutines(void)
+{
+    int fds[2];
+    const char byte = 42;
+
+    atto_eq(pipe(fds), 0);
+    atto_eq(write(fds[1], &byte, 1U), 1);
+    atto_eq(atto_async_wait_fd(fds[0], ATTO_ASYNC_READ), 0);
+    const uint64_t start = atto_time_ns();
+    atto_async_sleep_ns(ATTO_MS(1));
+    atto_ge(atto_time_ns() - start, ATTO_MS(1));
+    atto_async_yield();
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static uint64_t wake_order[10];
+static size_t woken = 0U;
+
+static void
+test_long_sleeper(void)
+{
+    static size_t next_sleeper = 0U;
+    const uint64_t duration = ATTO_S(10U - next_sleeper++);  // Last wakes first
+
+    atto_async_sleep_ns(duration);
+    wake_order[woken++] = duration;
+}
+
+static void
+test_virtual_time_jumps_when_all_blocked(void)
+{
+    atto_vclock_enable();
+    for (size_t i = 0U; i < 10U; i++) { atto_eq(atto_async(test_long_sleeper), 0); }
+    const uint64_t virtual_start = atto_vclock_now_ns();
+    const uint64_t start = atto_time_ns();
+    atto_eq(atto_async_run(), 0);
+    const uint64_t elapsed = atto_time_ns() - start;
+    const uint64_t virtual_elapsed = atto_vclock_now_ns() - virtual_start;
+    atto_vclock_disable();
+
+    atto_eq(woken, 10U);
+    for (size_t i = 0U; i < 10U; i++) { atto_eq(wake_order[i], ATTO_S(i + 1U)); }
+    atto_eq(virtual_elapsed, ATTO_S(10));
+    atto_lt(elapsed, ATTO_S(1));
+}
+
+static void
+test_spawn_limit(void)
+{
+    size_t spawned = 0U;
+    while (atto_async(test_sleeper) == 0) { spawned++; }
+    atto_eq(spawned, ATTO_ASYNC_MAX_TASKS);
+    sleepers_done = 0U;
+    atto_eq(atto_async_run(), 0);
+    atto_eq(sleepers_done, ATTO_ASYNC_MAX_TASKS);
+}
+
+static size_t spawned_done = 0U;
+
+static void
+test_spawned_child(void)
+{
+    atto_async_yield();
+    spawned_done++;
+}
+
+static void
+test_spawning_parent(void)
+{
+    atto_eq(atto_async(test_spawned_child), 0);
+    atto_async_yield();
+    atto_eq(atto_async(test_spawned_child), 0);
+}
+
+static void
+test_spawn_from_coroutine(void)
+{
+    atto_eq(atto_async(test_spawning_parent), 0);
+    atto_eq(atto_async_run(), 0);
+    atto_eq(spawned_done, 2U);
+}
+
+int
+main(void)
+{
+    test_waits_overlap();
+    test_outside_of_coroutines();
+    test_virtual_time_jumps_when_all_blocked();
+    test_spawn_limit();
+    test_spawn_from_coroutine();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file
+ * Example usage of Atto bench and also the test for Atto bench itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_bench.h"
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define BASELINE_FILE "selftest_bench.txt"
+#define SAMPLES       (100U)
+
+static uint64_t baseline[SAMPLES];
+static uint64_t samples[SAMPLES];
+
+/** Deterministic timings around a median, with +-5% of uniform noise. */
+static void
+fake_timings(uint64_t* const timings, const uint64_t median_ns, uint32_t seed)
+{
+    for (size_t i = 0U; i < SAMPLES; i++)
+    {
+        seed = seed * 1664525U + 1013904223U;
+        const uint64_t noise = (uint64_t) (seed >> 16U) % (median_ns / 10U + 1U);
+        timings[i] = median_ns - median_ns / 20U + noise;
+    }
+}
+
+static void
+test_mann_whitney(void)
+{
+    fake_timings(baseline, 1000U, 1U);
+    fake_timings(samples, 1000U, 2U);
+    atto_gt(atto_bench_p_slower(baseline, SAMPLES, samples, SAMPLES), 0.01);
+    atto_gt(atto_bench_p_slower(baseline, SAMPLES, baseline, SAMPLES), 0.4);
+    fake_timings(samples, 1100U, 2U);
+    atto_lt(atto_bench_p_slower(baseline, SAMPLES, samples, SAMPLES), 0.001);
+    // Faster is never significantly slower
+    atto_gt(atto_bench_p_slower(samples, SAMPLES, baseline, SAMPLES), 0.99);
+    atto_eq(atto_bench_p_slower(baseline, 0U, samples, SAMPLES), 1.0);
+}
+
+static void
+test_without_baseline_records_and_passes(void)
+{
+    remove(BASELINE_FILE);
+    atto_bench_clear();
+    atto_eq(atto_bench_load(BASELINE_FILE), 1);
+    fake_timings(baseline, 1000U, 1U);
+    atto_bench_samples("parse_header", baseline, SAMPLES, 5.0);
+    volatile uint32_t sum = 0U;
+    atto_bench("sum_loop", 20U, 5.0, for (uint32_t i = 0U; i < 1000U; i++) { sum += i; });
+    atto_eq(atto_bench_save(BASELINE_FILE), 0);
+}
+
+static void
+test_significant_regression_fails(void)
+{
+    atto_bench_clear();
+    atto_eq(atto_bench_load(BASELINE_FILE), 0);
+    fake_timings(samples, 1124U, 2U);
+    SHOULD_FAIL(atto_bench_samples("parse_header", samples, SAMPLES, 5.0));
+}
+
+static void
+test_regression_below_threshold_passes(void)
+{
+    atto_bench_clear();
+    atto_eq(atto_bench_load(BASELINE_FILE), 0);
+    fake_timings(samples, 1030U, 2U);
+    atto_eq(atto_bench_regressed("parse_header", samples, SAMPLES, 5.0), 0);
+    atto_lt(atto_bench_p_slower(baseline, SAMPLES, samples, SAMPLES), 0.01);  // But significant
+    atto_eq(atto_bench_regressed("parse_header", samples, SAMPLES, 1.0), 1);
+}
+
+static void
+test_insignificant_slowdown_passes(void)
+{
+    static const uint64_t noisy[] = {900U, 2000U, 1000U, 3000U, 1200U};
+    atto_bench_clear();
+    atto_eq(atto_bench_load(BASELINE_FILE), 0);
+    atto_bench_samples("parse_header", noisy, sizeof(noisy) / sizeof(noisy[0]), 5.0);
+}
+
+static void
+test_save_keeps_other_baselines(void)
+{
+    atto_bench_clear();
+    atto_eq(atto_bench_load(BASELINE_FILE), 0);
+    fake_timings(samples, 1000U, 3U);
+    atto_bench_samples("parse_header", samples, SAMPLES, 5.0);
+    atto_eq(atto_bench_save(BASELINE_FILE), 0);
+    atto_eq(fopen(BASELINE_FILE ".tmp", "r"), NULL);  // Renamed into place
+    atto_bench_clear();
+    atto_eq(atto_bench_load(BASELINE_FILE), 0);
+    // The loop still has its baseline, so a much slower run regresses
+    fake_timings(samples, ATTO_S(1), 4U);
+    atto_eq(atto_bench_regressed("sum_loop", samples, 20U, 5.0), 1);
+    remove(BASELINE_FILE);
+}
+
+int
+main(void)
+{
+    test_mann_whitney();
+    test_without_baseline_records_and_passes();
+    test_significant_regression_fails();
+    test_regression_below_threshold_passes();
+    test_insignificant_slowdown_passes();
+    test_save_keeps_other_baselines();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file
+ * Example usage of Atto check and also the test for Atto check itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_check.h"
+#include <pthread.h>
+
+static size_t expected_failures_counter = 0;
+
+#define THREADS          (4U)
+#define FAILS_PER_THREAD  (1000U)
+
+static unsigned int evaluations = 0U;
+
+/** Counts its evaluations, then returns the given value. */
+static int
+evaluated(const int value)
+{
+    evaluations++;
+    return value;
+}
+
+/** Reports the queued failures, which are all expected. */
+static size_t
+flush_expected(void)
+{
+    printf("Expected failures:\n");
+    const size_t reported = atto_check_flush();
+    expected_failures_counter += reported;
+    return reported;
+}
+
+/** Not a test case: the check does not stop a function returning a value. */
+static int
+checked_division(const int a, const int b)
+{
+    atto_check(ATTO_LEVEL_CANARY, b != 0);
+    return b == 0 ? 0 : a / b;
+}
+
+static void
+test_failures_are_queued(void)
+{
+    atto_eq(checked_division(6, 0), 0);
+    atto_eq(checked_division(6, 3), 2);
+    atto_check(ATTO_LEVEL_DEBUG, 1 + 1 == 3);
+    atto_eq(atto_check_failures(), 2U);
+    atto_eq(flush_expected(), 2U);
+    atto_eq(atto_check_flush(), 0U);
+}
+
+static void
+test_levels_below_threshold_are_skipped(void)
+{
+    atto_check_set_threshold(ATTO_LEVEL_SOAK);
+    evaluations = 0U;
+    atto_check(ATTO_LEVEL_PARANOID, evaluated(0));
+    atto_check(ATTO_LEVEL_DEBUG, evaluated(0));
+    atto_check(ATTO_LEVEL_SOAK, evaluated(1));
+    atto_check(ATTO_LEVEL_CANARY, evaluated(1));
+    atto_eq(evaluations, 2U);
+    atto_eq(atto_check_flush(), 0U);
+    atto_check_set_threshold(ATTO_LEVEL_PARANOID);
+}
+
+static void
+test_sampled_every_nth(void)
+{
+    evaluations = 0U;
+    for (size_t i = 0U; i < 100U; i++)
+    {
+        atto_check_sampled(ATTO_LEVEL_SOAK, 10U, evaluated(i != 55U));
+    }
+    atto_eq(evaluations, 10U);  // Hits 0, 10, 20, ...
+    atto_eq(atto_check_flush(), 0U);  // Hit 55 would fail, but is not sampled
+    for (size_t i = 0U; i < 3U; i++)
+    {
+        atto_check_sampled(ATTO_LEVEL_SOAK, 1U, evaluated(0));
+    }
+    atto_eq(evaluations, 13U);
+    atto_eq(flush_expected(), 3U);
+    for (size_t i = 0U; i < 3U; i++)
+    {
+        atto_check_sampled(ATTO_LEVEL_SOAK, 0U, evaluated(0));  // Never
+    }
+    atto_eq(evaluations, 13U);
+    atto_eq(atto_check_flush(), 0U);
+}
+
+static void*
+failing_thread(void* const arg)
+{
+    (void) arg;
+    for (size_t i = 0U; i < FAILS_PER_THREAD; i++)
+    {
+        atto_check(ATTO_LEVEL_CANARY, i == FAILS_PER_THREAD);
+    }
+    return NULL;
+}
+
+static void
+test_concurrent_failures_and_drops(void)
+{
+    pthread_t threads[THREADS];
+    const size_t before = atto_check_failures();
+    for (size_t i = 0U; i < THREADS; i++)
+    {
+        atto_eq(pthread_create(&threads[i], NULL, failing_thread, NULL), 0);
+    }
+    for (size_t i = 0U; i < THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    atto_eq(atto_check_failures() - before, THREADS * FAILS_PER_THREAD);
+    // The ring keeps ATTO_CHECK_RING_SIZE of them, the others are dropped
+    atto_eq(flush_expected(), THREADS * FAILS_PER_THREAD);
+}
+
+int
+main(void)
+{
+    test_failures_are_queued();
+    test_levels_below_threshold_are_skipped();
+    test_sampled_every_nth();
+    test_concurrent_failures_and_drops();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file
+ * Example usage of Atto complexity and also the test for Atto complexity itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_complexity.h"
+#include <math.h>
+#include <stdint.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define MAX_N (1U << 15U)
+
+static uint32_t values[MAX_N];
+static volatile uint32_t sink;
+
+static void
+fill_values(const size_t n)
+{
+    for (size_t i = 0U; i < n; i++) { values[i] = (uint32_t) (i * 2654435761U); }
+}
+
+/** Linear, at the same cost per element whatever the caches and the vector units. */
+static void
+sum_values(const size_t n)
+{
+    for (size_t i = 0U; i < n; i++) { sink += values[i]; }
+}
+
+/** Counts the pairs of equal values, the naive way. */
+static void
+count_equal_pairs(const size_t n)
+{
+    for (size_t i = 0U; i < n; i++)
+    {
+        for (size_t j = i + 1U; j < n; j++)
+        {
+            sink += values[i] == values[j];
+        }
+    }
+}
+
+/** Fits exact timings of the given class, disturbed by +-3% of noise. */
+static void
+fit_synthetic(atto_complexity_result_t* const result, const double exponent, const int log_factor)
+{
+    static const double noise[] = {0.03, -0.02, 0.01, -0.03, 0.02, 0.0, -0.01};
+    result->points = sizeof(noise) / sizeof(noise[0]);
+    for (size_t i = 0U; i < result->points; i++)
+    {
+        const double n = (double) (256U << i);
+        result->n[i] = 256U << i;
+        result->ns[i] = 7.0 * pow(n, exponent) * (log_factor ? log2(n) : 1.0) * (1.0 + noise[i]);
+    }
+    atto_complexity_fit(result);
+}
+
+static void
+test_fit_recognises_each_class(void)
+{
+    atto_complexity_result_t result;
+    fit_synthetic(&result, 0.0, 0);
+    atto_eq(result.best, ATTO_O_1);
+    fit_synthetic(&result, 0.0, 1);
+    atto_eq(result.best, ATTO_O_LOG_N);
+    fit_synthetic(&result, 1.0, 0);
+    atto_eq(result.best, ATTO_O_N);
+    atto_fdelta((float) result.coefficient[ATTO_O_N], 7.0F, 0.2F);
+    atto_lt(result.error[ATTO_O_N], 0.03);
+    fit_synthetic(&result, 1.0, 1);
+    atto_eq(result.best, ATTO_O_N_LOG_N);
+    fit_synthetic(&result, 2.0, 0);
+    atto_eq(result.best, ATTO_O_N_SQUARED);
+}
+
+static void
+test_names(void)
+{
+    atto_streq(atto_complexity_name(ATTO_O_N_LOG_N), "O(n log n)", 16U);
+    atto_streq(atto_complexity_name((atto_complexity_class_t) 99), "O(?)", 16U);
+}
+
+static void
+test_measured_linear(void)
+{
+    static const size_t sizes[] = {1U << 10U, 1U << 11U, 1U << 12U, 1U << 13U, 1U << 14U, MAX_N};
+    atto_complexity(fill_values, sum_values, sizes, ATTO_O_N);
+}
+
+static void
+test_measured_quadratic_is_too_slow(void)
+{
+    static const size_t sizes[] = {128U, 256U, 512U, 1024U, 2048U};
+    atto_complexity_result_t result;
+    atto_complexity_measure(&result, fill_values, count_equal_pairs, sizes, 5U);
+    atto_eq(result.points, 5U);
+    atto_eq(result.n[4], 2048U);
+    atto_eq(result.best, ATTO_O_N_SQUARED);
+    SHOULD_FAIL(atto_complexity(fill_values, count_equal_pairs, sizes, ATTO_O_N_LOG_N));
+}
+
+int
+main(void)
+{
+    test_fit_recognises_each_class();
+    test_names();
+    test_measured_linear();
+    test_measured_quadratic_is_too_slow();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file
+ * Example usage of Atto ct and also the test for Atto ct itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_ct.h"
+#include <stdint.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define TAG_LEN (256U)
+
+static uint8_t secret[TAG_LEN];
+static uint64_t prng_state = 42U;
+static volatile int sink;
+
+static uint8_t
+next_byte(void)
+{
+    prng_state = prng_state * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+    return (uint8_t) (prng_state >> 56U);
+}
+
+/** Class A: always the same input, equal to the secret. */
+static void
+gen_fixed(uint8_t* const input, const size_t size)
+{
+    (void) size;
+    memcpy(input, secret, TAG_LEN);
+}
+
+/** Class B: a fresh random input each time. */
+static void
+gen_random(uint8_t* const input, const size_t size)
+{
+    (void) size;
+    for (size_t i = 0U; i < TAG_LEN; i++) { input[i] = next_byte(); }
+}
+
+/** Compares the whole input with the secret, whatever their content. */
+static void
+equal_constant_time(const uint8_t* const bytes, const size_t size)
+{
+    (void) size;
+    uint8_t difference = 0U;
+    for (size_t i = 0U; i < TAG_LEN; i++)
+    {
+        difference = (uint8_t) (difference | (bytes[i] ^ secret[i]));
+    }
+    sink = difference == 0U;
+}
+
+/** Stops at the first byte differing from the secret, leaking its position. */
+static void
+equal_early_exit(const uint8_t* const input, const size_t size)
+{
+    const volatile uint8_t* const bytes = input;
+    (void) size;
+    size_t i = 0U;
+    while (i < TAG_LEN && bytes[i] == secret[i]) { i++; }
+    sink = i == TAG_LEN;
+}
+
+static void
+test_cycles_increase(void)
+{
+    const uint64_t before = atto_ct_cycles();
+    equal_constant_time(secret, TAG_LEN);
+    atto_ge(atto_ct_cycles(), before);
+}
+
+static void
+test_constant_time_passes(void)
+{
+    for (size_t i = 0U; i < TAG_LEN; i++) { secret[i] = next_byte(); }
+    atto_constant_time(gen_fixed, gen_random, equal_constant_time, 50000U);
+}
+
+static void
+test_early_exit_leaks(void)
+{
+    atto_ct_result_t result;
+    atto_gt(atto_ct_measure(&result, gen_fixed, gen_random, equal_early_exit, 20000U),
+            ATTO_CT_T_THRESHOLD);
+    atto_gt(result.t, 0.0);  // Equal inputs are slower
+    atto_eq(result.measurements, 20000U);
+    atto_le(result.samples_a + result.samples_b, 20000U - ATTO_CT_CALIBRATION);
+    SHOULD_FAIL(atto_constant_time(gen_fixed, gen_random, equal_early_exit, 20000U));
+}
+
+static void
+test_interleaving(void)
+{
+    atto_ct_result_t result;
+    // Too few measurements for the cropped tests and for a verdict
+    const size_t measurements = ATTO_CT_CALIBRATION + 500U;
+    atto_ct_measure(&result, gen_fixed, gen_random, equal_constant_time, measurements);
+    atto_true(result.insufficient);
+    atto_eq(result.crop_cycles, UINT64_MAX);
+    atto_eq(result.samples_a + result.samples_b, 500U);
+    atto_gt(result.samples_a, 150U);
+    atto_gt(result.samples_b, 150U);
+}
+
+static void
+test_too_few_measurements(void)
+{
+    atto_ct_result_t result;
+    atto_inf(atto_ct_measure(&result, gen_fixed, gen_random, equal_early_exit, 10U));
+    atto_true(result.insufficient);
+    atto_eq(result.samples_a, 0U);
+    atto_eq(result.samples_b, 0U);
+    atto_eq(result.percentile, 100.0);
+    // Only calibration: no sample left, so t = 0 must not pass
+    SHOULD_FAIL(atto_constant_time(gen_fixed, gen_random, equal_early_exit, ATTO_CT_CALIBRATION));
+}
+
+static void
+test_crops_are_recalibrated(void)
+{
+    atto_ct_result_t result;
+    atto_ct_measure(&result, gen_fixed, gen_random, equal_constant_time, 20000U);
+    atto_false(result.insufficient);
+    // Stopped during the calibration: no thresholds of the previous run
+    atto_ct_measure(&result, gen_fixed, gen_random, equal_constant_time, 500U);
+    atto_eq(result.crop_cycles, UINT64_MAX);
+    atto_eq(result.samples_a + result.samples_b, 0U);
+}
+
+int
+main(void)
+{
+    test_cycles_increase();
+    test_constant_time_passes();
+    test_early_exit_leaks();
+    test_interleaving();
+    test_too_few_measurements();
+    test_crops_are_recalibrated();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,227 @@
+/**
+ * @file
+ * Example usage of Atto diff and also the test for Atto diff itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_diff.h"
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define FLOATS (16U)
+#define SEED   (UINT64_C(0xA770))
+
+/** Random floats in [0, 1), never cancelling each other out when summed. */
+static void
+random_floats(const uint64_t seed, const size_t index, void* const input, const size_t input_size)
+{
+    float* const floats = input;
+    uint64_t state = atto_diff_state(seed, index);
+    for (size_t i = 0U; i < input_size / sizeof(float); i++)
+    {
+        floats[i] = (float) (atto_diff_next(&state) >> 40U) / (float) (1U << 24U);
+    }
+}
+
+/** Reference: sums the floats in order. */
+static void
+sum_in_order(const void* const input, void* const output)
+{
+    const float* const floats = input;
+    float sum = 0.0F;
+    for (size_t i = 0U; i < FLOATS; i++) { sum += floats[i]; }
+    memcpy(output, &sum, sizeof(sum));
+}
+
+/** Optimised: sums the floats in 4 interleaved lanes, as a vectorised kernel. */
+static void
+sum_in_lanes(const void* const input, void* const output)
+{
+    const float* const floats = input;
+    float lanes[4] = {0.0F, 0.0F, 0.0F, 0.0F};
+    for (size_t i = 0U; i < FLOATS; i++) { lanes[i % 4U] += floats[i]; }
+    const float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    memcpy(output, &sum, sizeof(sum));
+}
+
+/** Reference: amount of set bits of a 64-bit word, bit by bit. */
+static void
+popcount_reference(const void* const input, void* const output)
+{
+    uint64_t word;
+    memcpy(&word, input, sizeof(word));
+    uint32_t count = 0U;
+    for (; word != 0U; word >>= 1U) { count += (uint32_t) (word & 1U); }
+    memcpy(output, &count, sizeof(count));
+}
+
+/** Optimised: SWAR popcount, with a bug when the lowest byte is 0xFF. */
+static void
+popcount_buggy(const void* const input, void* const output)
+{
+    uint64_t word;
+    memcpy(&word, input, sizeof(word));
+    const int bug = (word & 0xFFU) == 0xFFU;
+    word -= (word >> 1U) & UINT64_C(0x5555555555555555);
+    word = (word & UINT64_C(0x3333333333333333)) + ((word >> 2U) & UINT64_C(0x3333333333333333));
+    word = (word + (word >> 4U)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+    uint32_t count = (uint32_t) ((word * UINT64_C(0x0101010101010101)) >> 56U);
+    count -= (uint32_t) bug;
+    memcpy(output, &count, sizeof(count));
+}
+
+/** Index of the first input the buggy popcount gets wrong, searched serially. */
+static size_t
+first_buggy_index(void)
+{
+    for (size_t index = 0U;; index++)
+    {
+        unsigned char input[sizeof(uint64_t)];
+        atto_diff_random_bytes(SEED, index, input, sizeof(input));
+        if (input[0] == 0xFFU)
+        {
+            return index;
+        }
+    }
+}
+
+static void
+test_comparators(void)
+{
+    const float one = 1.0F;
+    const float next = nextafterf(1.0F, 2.0F);
+    const float zeros[2] = {0.0F, -0.0F};
+    const float nans[2] = {NAN, NAN};
+    atto_true(atto_diff_exact(&one, &one, sizeof(float), 0.0));
+    atto_false(atto_diff_exact(&one, &next, sizeof(float), 0.0));
+    atto_false(atto_diff_exact(&zeros[0], &zeros[1], sizeof(float), 0.0));
+    atto_true(atto_diff_ulp(&one, &next, sizeof(float), 1.0));
+    atto_false(atto_diff_ulp(&one, &next, sizeof(float), 0.0));
+    atto_true(atto_diff_ulp(&zeros[0], &zeros[1], sizeof(float), 0.0));
+    atto_true(atto_diff_ulp(&nans[0], &nans[1], sizeof(float), 0.0));
+    atto_false(atto_diff_ulp(&one, &nans[0], sizeof(float), 1e9));
+    atto_true(atto_diff_fdelta(&one, &next, sizeof(float), 1e-6));
+    atto_false(atto_diff_fdelta(&one, &next, sizeof(float), 1e-9));
+    atto_false(atto_diff_fdelta(&nans[0], &one, sizeof(float), 1e9));
+}
+
+static void
+test_inputs_depend_on_seed_and_index_only(void)
+{
+    uint64_t a[4];
+    uint64_t b[4];
+    atto_diff_random_bytes(SEED, 7U, a, sizeof(a));
+    atto_diff_random_bytes(SEED, 8U, b, sizeof(b));
+    atto_false(memcmp(a, b, sizeof(a)) == 0);
+    atto_diff_random_bytes(SEED, 7U, b, sizeof(b));
+    atto_memeq(a, b, sizeof(a));
+    atto_diff_random_bytes(SEED + 1U, 7U, b, sizeof(b));
+    atto_false(memcmp(a, b, sizeof(a)) == 0);
+}
+
+static void
+test_reordered_sum_within_ulp(void)
+{
+    const atto_diff_config_t config = {
+        .input_size = FLOATS * sizeof(float),
+        .output_size = sizeof(float),
+        .cmp = atto_diff_ulp,
+        .tolerance = 16.0,
+        .seed = SEED,
+        .threads = 4U,
+    };
+    atto_differential(&config, sum_in_order, sum_in_lanes, random_floats, 200U);
+    atto_diff_result_t result;
+    atto_eq(atto_diff_run(&result, &config, sum_in_order, sum_in_lanes, random_floats, 200U), 1);
+    atto_eq(result.compared, 200U * result.batch_inputs);
+    atto_false(result.diverged);
+}
+
+static void
+test_reordered_sum_not_exact(void)
+{
+    const atto_diff_config_t config = {
+        .input_size = FLOATS * sizeof(float),
+        .output_size = sizeof(float),
+        .seed = SEED,
+    };
+    SHOULD_FAIL(atto_differential(&config, sum_in_order, sum_in_lanes, random_floats, 200U));
+}
+
+static void
+test_first_divergence_whatever_the_threads(void)
+{
+    const size_t expected = first_buggy_index();
+    atto_diff_config_t config = {
+        .input_size = sizeof(uint64_t),
+        .output_size = sizeof(uint32_t),
+        .seed = SEED,
+        .threads = 1U,
+    };
+    atto_diff_result_t result;
+    for (; config.threads <= 8U; config.threads *= 2U)
+    {
+        atto_eq(atto_diff_run(&result,
+                              &config,
+                              popcount_reference,
+                              popcount_buggy,
+                              atto_diff_random_bytes,
+                              100U),
+                0);
+        atto_true(result.diverged);
+        atto_eq(result.first_index, expected);
+        atto_eq(result.seed, SEED);
+    }
+    // The seed and index regenerate the diverging input
+    unsigned char input[sizeof(uint64_t)];
+    atto_diff_random_bytes(result.seed, result.first_index, input, sizeof(input));
+    uint32_t ref_output;
+    uint32_t opt_output;
+    popcount_reference(input, &ref_output);
+    popcount_buggy(input, &opt_output);
+    atto_neq(ref_output, opt_output);
+    SHOULD_FAIL(atto_differential(
+        &config, popcount_reference, popcount_buggy, atto_diff_random_bytes, 100U));
+}
+
+static void
+test_input_larger_than_batch(void)
+{
+    const atto_diff_config_t config = {
+        .input_size = ATTO_DIFF_BATCH_SIZE,
+        .output_size = sizeof(uint32_t),
+    };
+    atto_diff_result_t result;
+    atto_eq(atto_diff_run(&result,
+                          &config,
+                          popcount_reference,
+                          popcount_reference,
+                          atto_diff_random_bytes,
+                          1U),
+            0);
+    atto_eq(result.batch_inputs, 0U);
+    atto_eq(result.compared, 0U);
+    SHOULD_FAIL(atto_differential(
+        &config, popcount_reference, popcount_reference, atto_diff_random_bytes, 1U));
+}
+
+int
+main(void)
+{
+    test_comparators();
+    test_inputs_depend_on_seed_and_index_only();
+    test_reordered_sum_within_ulp();
+    test_reordered_sum_not_exact();
+    test_first_divergence_whatever_the_threads();
+    test_input_larger_than_batch();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
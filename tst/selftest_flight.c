@@ -0,0 +1,174 @@
+/**
+ * @file
+ * Example usage of Atto flight and also the test for Atto flight itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "atto_flight.h"
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+/** Dump of the flight recorder or of a crashed child process. */
+static char output[64U * 1024U];
+
+/** Reads everything from the file descriptor into the output buffer. */
+static size_t
+read_all(const int fd)
+{
+    size_t len = 0U;
+    ssize_t got;
+    while ((got = read(fd, output + len, sizeof(output) - 1U - len)) > 0)
+    {
+        len += (size_t) got;
+    }
+    output[len] = '\0';
+    return len;
+}
+
+/** Dumps the flight recorder into the output buffer. */
+static void
+dump_to_output(void)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        output[0] = '\0';
+        return;
+    }
+    atto_flight_dump(fds[1]);
+    close(fds[1]);
+    read_all(fds[0]);
+    close(fds[0]);
+}
+
+/** Amount of lines in the output buffer. */
+static size_t
+output_lines(void)
+{
+    size_t lines = 0U;
+    for (const char* c = output; *c != '\0'; c++) { lines += *c == '\n'; }
+    return lines;
+}
+
+static void
+test_records_last_sites(void)
+{
+    char site[128];
+    atto_flight_clear();
+    atto_true(1);
+    const int line = __LINE__ + 1;
+    atto_eq(1 + 1, 2);
+    dump_to_output();
+    snprintf(site, sizeof(site), "selftest_flight.c:%d | Age: ", line);
+    atto_neq(strstr(output, "Last 2 of 2 passed assertions"), NULL);
+    atto_neq(strstr(output, site), NULL);
+    atto_neq(strstr(output, "Test case: test_records_last_sites"), NULL);
+    atto_eq(output_lines(), 3U);
+}
+
+static void
+test_ring_keeps_most_recent(void)
+{
+    atto_flight_clear();
+    for (size_t i = 0U; i < 3U * ATTO_FLIGHT_SIZE; i++) { atto_lt(i, 3U * ATTO_FLIGHT_SIZE); }
+    const size_t recorded = atto_flight_recorded();
+    dump_to_output();
+    atto_eq(recorded, 3U * ATTO_FLIGHT_SIZE);
+    atto_eq(output_lines(), ATTO_FLIGHT_SIZE + 1U);
+    char oldest[64];
+    snprintf(oldest, sizeof(oldest), "FLIGHT | #%u |", 2U * ATTO_FLIGHT_SIZE);
+    atto_neq(strstr(output, oldest), NULL);
+}
+
+static void
+failing_assertion(void)
+{
+    SHOULD_FAIL(atto_fail());
+}
+
+static void
+test_failures_are_not_recorded(void)
+{
+    atto_flight_clear();
+    failing_assertion();
+    atto_eq(atto_flight_recorded(), 0U);
+}
+
+static void
+passing_assertion(void)
+{
+    atto_true(1);
+}
+
+/** Runs a crashing child process and captures its standard output. */
+static int
+crash_in_child(const int signal_number)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return -1;
+    }
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        atto_flight_install();
+        atto_flight_clear();
+        passing_assertion();
+        if (signal_number == SIGABRT)
+        {
+            abort();
+        }
+        raise(signal_number);
+        _exit(0);
+    }
+    close(fds[1]);
+    read_all(fds[0]);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) ? WTERMSIG(status) : -1;
+}
+
+static void
+test_crash_dumps_recorder(void)
+{
+    char header[32];
+    atto_eq(crash_in_child(SIGSEGV), SIGSEGV);  // Still crashes
+    snprintf(header, sizeof(header), "FLIGHT | Signal: %d\n", SIGSEGV);
+    atto_neq(strstr(output, header), NULL);
+    atto_neq(strstr(output, "Last 1 of 1 passed assertions"), NULL);
+    atto_neq(strstr(output, "selftest_flight.c:"), NULL);
+
+    atto_eq(crash_in_child(SIGABRT), SIGABRT);
+    snprintf(header, sizeof(header), "FLIGHT | Signal: %d\n", SIGABRT);
+    atto_neq(strstr(output, header), NULL);
+}
+
+int
+main(void)
+{
+    atto_run(test_records_last_sites);
+    atto_run(test_ring_keeps_most_recent);
+    atto_run(test_failures_are_not_recorded);
+    atto_run(test_crash_dumps_recorder);
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file
+ * Example usage of Atto fuzz and also the test for Atto fuzz itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For fork(), mkdir() */
+#endif
+
+#include "atto_fuzz.h"
+#include <signal.h>   /* For SIGABRT */
+#include <sys/stat.h> /* For mkdir() */
+#include <sys/wait.h> /* For waitpid() */
+#include <unistd.h>   /* For fork(), rmdir() */
+
+#define CORPUS_DIR "selftest_fuzz_corpus"
+#define MAX_INPUT  (512U)
+
+/** Run-length encoding in (count, byte) pairs, with a bug: runs over 255 overflow. */
+static size_t
+rle_encode(const uint8_t* const data, const size_t size, uint8_t* const out)
+{
+    size_t out_len = 0U;
+    for (size_t i = 0U; i < size;)
+    {
+        size_t run = 1U;
+        while (i + run < size && data[i + run] == data[i]) { run++; }
+        out[out_len++] = (uint8_t) run;
+        out[out_len++] = data[i];
+        i += run;
+    }
+    return out_len;
+}
+
+/** Run-length decoding of (count, byte) pairs. */
+static size_t
+rle_decode(const uint8_t* const data, const size_t size, uint8_t* const out)
+{
+    size_t out_len = 0U;
+    for (size_t i = 0U; i + 1U < size; i += 2U)
+    {
+        memset(out + out_len, data[i + 1U], data[i]);
+        out_len += data[i];
+    }
+    return out_len;
+}
+
+ATTO_FUZZ_TARGET(fuzz_rle_round_trip, data, size)
+{
+    uint8_t encoded[2U * MAX_INPUT];
+    uint8_t decoded[MAX_INPUT];
+    if (size > MAX_INPUT)
+    {
+        return;
+    }
+    const size_t encoded_len = rle_encode(data, size, encoded);
+    atto_le(encoded_len, 2U * size);
+    atto_eq(rle_decode(encoded, encoded_len, decoded), size);
+    atto_memeq(decoded, data, size);
+}
+
+#ifndef ATTO_FUZZING
+
+static size_t expected_failures_counter = 0;
+
+/** Writes a whole file. */
+static void
+write_file(const char* const path, const void* const data, const size_t len)
+{
+    FILE* const file = fopen(path, "wb");
+    if (file != NULL)
+    {
+        fwrite(data, 1U, len, file);
+        fclose(file);
+    }
+}
+
+static void
+create_corpus(void)
+{
+    uint8_t long_run[300];
+    memset(long_run, 'a', sizeof(long_run));
+    mkdir(CORPUS_DIR, 0700);
+    mkdir(CORPUS_DIR "/subdir", 0700);
+    write_file(CORPUS_DIR "/empty", "", 0U);
+    write_file(CORPUS_DIR "/short", "x", 1U);
+    write_file(CORPUS_DIR "/mixed", "aaabccccd", 9U);
+    write_file(CORPUS_DIR "/crash-long-run", long_run, sizeof(long_run));
+    write_file(CORPUS_DIR "/.hidden", long_run, sizeof(long_run));
+}
+
+static void
+test_replay_sequentially(void)
+{
+    create_corpus();
+    const size_t failures = atto_counter_assert_failures;
+    printf("Expected failure: ");
+    atto_eq(atto_fuzz_replay(fuzz_rle_round_trip, CORPUS_DIR, 1U), 4U);
+    const size_t new_failures = atto_counter_assert_failures - failures;
+    expected_failures_counter += new_failures;
+    atto_eq(new_failures, 1U);
+}
+
+static void
+test_replay_in_parallel(void)
+{
+    const size_t passes = atto_counter_assert_passes;
+    const size_t failures = atto_counter_assert_failures;
+    // Workers print their own failure, but cannot count it as expected here
+    printf("Expected failure: ");
+    const size_t replayed = atto_fuzz_replay(fuzz_rle_round_trip, CORPUS_DIR, 3U);
+    const size_t new_failures = atto_counter_assert_failures - failures;
+    const size_t passes_of_workers = atto_counter_assert_passes - passes;
+    expected_failures_counter += new_failures;
+    atto_eq(replayed, 4U);
+    atto_eq(new_failures, 1U);
+    atto_eq(passes_of_workers, 3U * 3U + 1U);  // The failing input passes only 1
+}
+
+static void
+test_missing_corpus(void)
+{
+    const size_t failures = atto_counter_assert_failures;
+    printf("Expected failure: ");
+    atto_eq(atto_fuzz_replay(fuzz_rle_round_trip, "does_not_exist", 2U), 0U);
+    expected_failures_counter++;
+    atto_eq(atto_counter_assert_failures, failures + 1U);
+    remove(CORPUS_DIR "/empty");
+    remove(CORPUS_DIR "/short");
+    remove(CORPUS_DIR "/mixed");
+    remove(CORPUS_DIR "/crash-long-run");
+    remove(CORPUS_DIR "/.hidden");
+    rmdir(CORPUS_DIR "/subdir");
+    rmdir(CORPUS_DIR);
+}
+
+int
+main(void)
+{
+    test_replay_sequentially();
+    test_replay_in_parallel();
+    test_missing_corpus();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
+
+#else
+
+/*
+ * Built as a fuzzer, but without libFuzzer: calls the entry point directly
+ * and checks that a failed assertion aborts the process.
+ */
+int
+main(void)
+{
+    uint8_t long_run[300];
+    memset(long_run, 'a', sizeof(long_run));
+    if (LLVMFuzzerTestOneInput((const uint8_t*) "aaabccccd", 9U) != 0)
+    {
+        return 1;
+    }
+    fflush(stdout);
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        printf("Expected failure: ");
+        LLVMFuzzerTestOneInput(long_run, sizeof(long_run));
+        _exit(0);  // Not reached when aborting
+    }
+    int status = 0;
+    if (child < 0 || waitpid(child, &status, 0) != child)
+    {
+        return 1;
+    }
+    const int aborted = WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+    printf("FUZZ | Failed assertion aborted: %s\n", aborted ? "yes" : "no");
+    atto_report();
+    return !aborted || atto_at_least_one_fail;
+}
+
+#endif
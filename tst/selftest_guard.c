@@ -0,0 +1,139 @@
+/**
+ * @file
+ * Example usage of Atto guard and also the test for Atto guard itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L /* For fork(), sysconf() */
+#endif
+
+#include "atto_guard.h"
+#include <signal.h>   /* For SIGSEGV */
+#include <stdint.h>   /* For uintptr_t */
+#include <sys/wait.h> /* For waitpid() */
+#include <unistd.h>   /* For fork(), sysconf() */
+
+// Volatile, otherwise its increment may be moved after the faulting access
+static volatile size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+/** Set by the faulting test cases after the fault, which must never happen. */
+static volatile int resumed_after_fault = 0;
+
+static uintptr_t
+page_offset(const volatile void* const address)
+{
+    return (uintptr_t) address % (uintptr_t) sysconf(_SC_PAGESIZE);
+}
+
+static void
+test_buffers_touch_the_guard_page(void)
+{
+    volatile uint8_t* const right = atto_guarded_alloc(13U);
+    volatile uint8_t* const left = atto_guarded_alloc_edge(13U, ATTO_GUARD_LEFT);
+    atto_neq(right, NULL);
+    atto_neq(left, NULL);
+    atto_eq(page_offset(right + 13U), 0U);
+    atto_eq(page_offset(left), 0U);
+    for (size_t i = 0U; i < 13U; i++)
+    {
+        atto_eq(right[i], 0U);
+        right[i] = (uint8_t) i;
+        left[i] = (uint8_t) i;
+    }
+    atto_eq(right[12], 12U);
+    atto_eq(left[12], 12U);
+    atto_neq(atto_guarded_alloc(0U), NULL);
+    atto_guarded_free(NULL);  // No-op
+    uint8_t not_guarded[4];
+    atto_guarded_free(not_guarded);  // Also a no-op
+}
+
+static void
+test_overflow_is_a_failure(void)
+{
+    volatile uint8_t* const buffer = atto_guarded_alloc(16U);
+    atto_neq(buffer, NULL);
+    buffer[15] = 1U;
+    SHOULD_FAIL(buffer[16] = 1U);
+    resumed_after_fault = 1;
+}
+
+static void
+test_underflow_is_a_failure(void)
+{
+    volatile uint8_t* const buffer = atto_guarded_alloc_edge(16U, ATTO_GUARD_LEFT);
+    atto_neq(buffer, NULL);
+    SHOULD_FAIL(buffer[-1] = 1U);
+    resumed_after_fault = 1;
+}
+
+static void
+test_use_after_free_is_a_failure(void)
+{
+    volatile uint8_t* const buffer = atto_guarded_alloc(16U);
+    atto_neq(buffer, NULL);
+    atto_guarded_free((void*) buffer);
+    SHOULD_FAIL(atto_eq(buffer[3], 0U));
+    resumed_after_fault = 1;
+}
+
+static void
+test_faults_were_recovered(void)
+{
+    atto_eq(resumed_after_fault, 0);
+    atto_eq(atto_counter_assert_failures, 3U);
+}
+
+static void
+test_capacity(void)
+{
+    for (size_t i = 0U; i < ATTO_GUARD_MAX_BUFFERS; i++)
+    {
+        atto_neq(atto_guarded_alloc(1U), NULL);
+    }
+    atto_eq(atto_guarded_alloc(1U), NULL);
+    atto_guard_release();
+    atto_neq(atto_guarded_alloc(1U), NULL);
+}
+
+static void
+test_fault_without_recovery_terminates(void)
+{
+    fflush(stdout);
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        volatile uint8_t* const buffer = atto_guarded_alloc(8U);
+        printf("Expected crash: ");
+        fflush(stdout);
+        buffer[8] = 1U;
+        _exit(0);  // Not reached
+    }
+    int status = 0;
+    atto_eq(waitpid(child, &status, 0), child);
+    atto_true(WIFSIGNALED(status));
+    atto_true(WTERMSIG(status) == SIGSEGV || WTERMSIG(status) == SIGBUS);
+}
+
+int
+main(void)
+{
+    atto_guard_run(test_buffers_touch_the_guard_page);
+    atto_guard_run(test_overflow_is_a_failure);
+    atto_guard_run(test_underflow_is_a_failure);
+    atto_guard_run(test_use_after_free_is_a_failure);
+    atto_run(test_faults_were_recovered);
+    atto_run(test_capacity);
+    atto_run(test_fault_without_recovery_terminates);
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
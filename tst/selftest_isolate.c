@@ -0,0 +1,183 @@
+/**
+ * @file
+ * Example usage of Atto isolate and also the test for Atto isolate itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#define _POSIX_C_SOURCE 200809L /* For setenv() */
+
+#include "atto_bench.h"
+#include "atto_check.h"
+#include "atto_isolate.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Copy-relocated from the C library into the executable. */
+extern char** environ;
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define TABLE_LEN (4096U)
+
+/** Leaking state, in .data. */
+static int counter = 5;
+/** Leaking state over multiple pages, in .bss. */
+static int table[TABLE_LEN];
+/** Shared on purpose across test cases. */
+static int test_cases_run = 0;
+
+static void
+test_leaves_state_behind(void)
+{
+    test_cases_run++;
+    counter = 100;
+    table[0] = 1;
+    table[TABLE_LEN - 1U] = 2;
+    atto_eq(counter, 100);
+}
+
+static void
+test_finds_state_as_before(void)
+{
+    test_cases_run++;
+    atto_eq(counter, 9);
+    atto_eq(table[0], 0);
+    atto_eq(table[TABLE_LEN - 1U], 0);
+    counter = 10;
+}
+
+static void
+test_reads_only(void)
+{
+    volatile int copy = counter;
+    (void) copy;
+}
+
+static void
+test_fails_after_writing(void)
+{
+    counter = 50;
+    SHOULD_FAIL(atto_fail());
+}
+
+/** Changes the state of other Atto modules and of the C library. */
+static void
+test_uses_other_modules(void)
+{
+    counter = 20;
+    atto_check(ATTO_LEVEL_CANARY, counter < 10);  // Queued, reported later
+    uint64_t samples[16];
+    for (size_t i = 0U; i < 16U; i++)
+    {
+        samples[i] = 1000U + i;
+    }
+    atto_eq(atto_bench_regressed("isolated_bench", samples, 16U, 10.0), 0);
+    atto_eq(setenv("ATTO_ISOLATE_SELFTEST", "1", 1), 0);
+}
+
+/** Whether the environment has the entry, reading the executable's copy. */
+static int
+in_environ(const char* const entry)
+{
+    for (char** variable = environ; *variable != NULL; variable++)
+    {
+        if (strcmp(*variable, entry) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** Whether a line of the text file starts with the prefix. */
+static int
+file_has_line(const char* const path, const char* const prefix)
+{
+    FILE* const file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    char line[256];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file) != NULL)
+    {
+        found = strncmp(line, prefix, strlen(prefix)) == 0;
+    }
+    fclose(file);
+    return found;
+}
+
+static void
+test_setup(void)
+{
+    atto_eq(atto_isolate_module("no-such-module.so"), 1);
+    atto_eq(atto_isolate_module(NULL), 0);
+    // Already isolated: no segments nor excluded ranges added again
+    for (size_t i = 0U; i < ATTO_ISOLATE_MAX_SEGMENTS; i++)
+    {
+        atto_eq(atto_isolate_module(NULL), 0);
+    }
+    atto_eq(atto_isolate_exclude(&test_cases_run, sizeof(test_cases_run)), 0);
+    atto_eq(atto_isolate_exclude(&expected_failures_counter, sizeof(expected_failures_counter)),
+            0);
+    printf("Soft-dirty bits: %d\n", atto_isolate_soft_dirty());
+}
+
+/** Not launched with atto_run(), so not isolated itself. */
+static void
+test_isolation(void)
+{
+    atto_run(test_leaves_state_behind);
+    atto_eq(counter, 5);
+    atto_eq(table[0], 0);
+    atto_eq(table[TABLE_LEN - 1U], 0);
+    atto_ge(atto_isolate_last_restored(), 2U);
+    // Changed outside of test cases: kept
+    counter = 9;
+    atto_run(test_finds_state_as_before);
+    atto_eq(counter, 9);
+    atto_eq(test_cases_run, 2);
+    atto_run(test_reads_only);
+    atto_eq(atto_isolate_last_restored(), 0U);
+    atto_run(test_fails_after_writing);
+    atto_eq(counter, 9);
+    atto_eq(atto_counter_assert_failures, 1U);
+}
+
+/** Not launched with atto_run(), so not isolated itself. */
+static void
+test_other_modules_kept(void)
+{
+    atto_run(test_uses_other_modules);
+    atto_eq(counter, 9);
+    atto_eq(atto_check_failures(), 1U);
+    printf("Expected failures:\n");
+    const size_t flushed = atto_check_flush();
+    expected_failures_counter += flushed;
+    atto_eq(flushed, 1U);
+    const int bench_saved = atto_bench_save("atto_selftest_isolate_bench.txt");
+    atto_eq(bench_saved, 0);
+    atto_eq(file_has_line("atto_selftest_isolate_bench.txt", "isolated_bench 16 "), 1);
+    remove("atto_selftest_isolate_bench.txt");
+    atto_eq(in_environ("ATTO_ISOLATE_SELFTEST=1"), 1);
+    atto_neq(getenv("ATTO_ISOLATE_SELFTEST"), NULL);
+}
+
+int
+main(void)
+{
+    test_setup();
+    test_isolation();
+    test_other_modules_kept();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
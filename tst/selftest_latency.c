@@ -0,0 +1,115 @@
+/**
+ * @file
+ * Example usage of Atto latency and also the test for Atto latency itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_latency.h"
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+static atto_latency_t hist;
+
+static void
+busy_wait_ns(const uint64_t duration_ns)
+{
+    const uint64_t start = atto_time_ns();
+    while (atto_time_ns() - start < duration_ns) {}
+}
+
+static void
+test_time_is_monotonic(void)
+{
+    const uint64_t first = atto_time_ns();
+    const uint64_t second = atto_time_ns();
+    atto_ge(second, first);
+    atto_eq(ATTO_US(200), 200000U);
+    atto_eq(ATTO_MS(3), 3000000U);
+    atto_eq(ATTO_S(1), 1000000000U);
+}
+
+static void
+test_latency_empty(void)
+{
+    atto_latency_init(&hist);
+    atto_eq(hist.total, 0U);
+    atto_eq(atto_latency_percentile(&hist, 50.0), 0U);
+    SHOULD_FAIL(atto_latency_hist_p(&hist, 50.0, <=, ATTO_S(1)));
+}
+
+static void
+test_latency_small_values_are_exact(void)
+{
+    atto_latency_init(&hist);
+    for (uint64_t i = 1U; i <= ATTO_LATENCY_SUB_BUCKETS; i++) { atto_latency_record(&hist, i); }
+    atto_eq(hist.min_ns, 1U);
+    atto_eq(hist.max_ns, ATTO_LATENCY_SUB_BUCKETS);
+    atto_eq(atto_latency_percentile(&hist, 0.0), 1U);
+    atto_eq(atto_latency_percentile(&hist, 50.0), ATTO_LATENCY_SUB_BUCKETS / 2U);
+    atto_eq(atto_latency_percentile(&hist, 100.0), ATTO_LATENCY_SUB_BUCKETS);
+    atto_eq(atto_latency_percentile(&hist, 1000.0), ATTO_LATENCY_SUB_BUCKETS);
+}
+
+static void
+test_latency_relative_error(void)
+{
+    const double max_relative_error = 1.0 / ATTO_LATENCY_SUB_BUCKETS;
+
+    atto_latency_init(&hist);
+    for (uint64_t i = 1U; i <= 100000U; i++) { atto_latency_record(&hist, i * 1000U); }
+    const uint64_t p50 = atto_latency_percentile(&hist, 50.0);
+    const uint64_t p99 = atto_latency_percentile(&hist, 99.0);
+    const uint64_t p999 = atto_latency_percentile(&hist, 99.9);
+    atto_ge(p50, 50000000U);
+    atto_le((double) p50, 50000000.0 * (1.0 + max_relative_error));
+    atto_ge(p99, 99000000U);
+    atto_le((double) p99, 99000000.0 * (1.0 + max_relative_error));
+    atto_ge(p999, 99900000U);
+    atto_le(p999, 100000000U);  // Clipped to the exact max
+    atto_latency_hist_p(&hist, 99.9, <=, ATTO_MS(100));
+    atto_latency_hist_p(&hist, 50.0, <, ATTO_MS(60));
+    SHOULD_FAIL(atto_latency_hist_p(&hist, 99.0, <=, ATTO_MS(90)));
+}
+
+static void
+test_latency_huge_values(void)
+{
+    atto_latency_init(&hist);
+    atto_latency_record(&hist, UINT64_MAX);
+    atto_latency_record(&hist, 0U);
+    atto_eq(atto_latency_percentile(&hist, 50.0), 0U);
+    atto_eq(atto_latency_percentile(&hist, 100.0), UINT64_MAX);
+}
+
+static void
+test_latency_body(void)
+{
+    volatile unsigned int counter = 0U;
+
+    atto_latency_p(99.0, <=, ATTO_MS(100), 1000, counter++);
+    atto_eq(counter, 1000U);
+    atto_latency_p(50.0, >=, ATTO_US(2), 10, busy_wait_ns(ATTO_US(2)), counter++);
+    atto_eq(counter, 1010U);
+    SHOULD_FAIL(atto_latency_p(50.0, <=, ATTO_US(1), 10, busy_wait_ns(ATTO_US(5))));
+}
+
+int
+main(void)
+{
+    test_time_is_monotonic();
+    test_latency_empty();
+    test_latency_small_values_are_exact();
+    test_latency_relative_error();
+    test_latency_huge_values();
+    test_latency_body();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file
+ * Example usage of Atto mem and also the test for Atto mem itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_mem.h"
+#include <stdlib.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define LEAK_SIZE (16U * 1024U * 1024U)
+
+/** Simulates an unbounded cache, keeping the memory until the end. */
+static unsigned char* leaked = NULL;
+
+static void
+leak_memory(void)
+{
+    leaked = malloc(LEAK_SIZE);
+    if (leaked != NULL)
+    {
+        memset(leaked, 0xAB, LEAK_SIZE);  // Touch it, so it becomes resident
+    }
+}
+
+static void
+test_rss_is_available(void)
+{
+    const size_t rss = atto_mem_rss();
+    atto_gt(rss, 0U);
+    atto_ge(atto_mem_peak_rss(), rss / 2U);  // Coarser, so not exactly ordered
+}
+
+static void
+test_max_rss_growth_passes(void)
+{
+    volatile size_t sum = 0U;
+    atto_max_rss_growth(1024U * 1024U, for (size_t i = 0; i < 1000U; i++) { sum += i; });
+    atto_eq(sum, 499500U);
+}
+
+static void
+test_max_rss_growth_fails(void)
+{
+    SHOULD_FAIL(atto_max_rss_growth(1024U * 1024U, leak_memory()));
+}
+
+static void
+test_tracked_leak(void)
+{
+    const size_t peak_before = atto_mem_peak_rss();
+    free(leaked);
+    leak_memory();
+    leak_memory();  // Leaks the previous one
+    atto_ge(atto_mem_peak_rss(), peak_before);
+}
+
+static void
+test_track(void)
+{
+    atto_eq(atto_mem_track(), 0);
+}
+
+int
+main(void)
+{
+    test_rss_is_available();
+    test_max_rss_growth_passes();
+    test_max_rss_growth_fails();
+    test_track();
+    atto_run(test_tracked_leak);
+    atto_run(test_rss_is_available);
+    free(leaked);
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file
+ * Example usage of Atto pool and also the test for Atto pool itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_pool.h"
+#include <stdlib.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define ITEMS (1000U)
+
+/** Indexes of the workers reported as crashed. */
+static size_t crashed_workers[ATTO_POOL_MAX_WORKERS];
+static size_t crashed_amount = 0U;
+
+static void
+check_item(const size_t item, const size_t* const failing_item)
+{
+    if (failing_item != NULL && item == *failing_item)
+    {
+        SHOULD_FAIL(atto_fail());
+    }
+    atto_lt(item, ITEMS);
+}
+
+/** Checks every item with index `worker` modulo `workers`. */
+static size_t
+check_share(void* const ctx, const size_t worker, const size_t workers)
+{
+    size_t checked = 0U;
+    for (size_t i = worker; i < ITEMS; i += workers)
+    {
+        check_item(i, ctx);
+        checked++;
+    }
+    return checked;
+}
+
+/** Crashes in the last worker only. */
+static size_t
+crash_last(void* const ctx, const size_t worker, const size_t workers)
+{
+    (void) ctx;
+    if (worker + 1U == workers)
+    {
+        abort();
+    }
+    return 1U;
+}
+
+static void
+record_crash(void* const ctx, const size_t worker)
+{
+    (void) ctx;
+    printf("POOL | Worker: %zu | Crashed\n", worker);
+    crashed_workers[crashed_amount++] = worker;
+}
+
+static void
+test_counters_are_merged(void)
+{
+    const size_t passes = atto_counter_assert_passes;
+    const size_t checked = atto_pool_run(check_share, record_crash, NULL, 4U);
+    const size_t passes_of_workers = atto_counter_assert_passes - passes;
+    atto_eq(checked, ITEMS);
+    atto_eq(passes_of_workers, ITEMS);
+    atto_eq(crashed_amount, 0U);
+}
+
+static void
+test_single_worker_runs_here(void)
+{
+    const size_t passes = atto_counter_assert_passes;
+    const size_t checked = atto_pool_run(check_share, record_crash, NULL, 1U);
+    const size_t passes_here = atto_counter_assert_passes - passes;
+    atto_eq(checked, ITEMS);
+    atto_eq(passes_here, ITEMS);
+    atto_eq(atto_pool_run(check_share, record_crash, NULL, 0U), ITEMS);
+}
+
+static void
+test_failures_of_workers_are_counted(void)
+{
+    const size_t failing_item = 123U;
+    const size_t failures = atto_counter_assert_failures;
+    // A worker prints its own failure, but cannot count it as expected here
+    const size_t checked = atto_pool_run(check_share, record_crash, (void*) &failing_item, 4U);
+    const size_t new_failures = atto_counter_assert_failures - failures;
+    expected_failures_counter += new_failures;
+    atto_eq(checked, ITEMS);
+    atto_eq(new_failures, 1U);
+}
+
+static void
+test_crashed_worker_is_a_failure(void)
+{
+    const size_t failures = atto_counter_assert_failures;
+    printf("Expected failure: ");
+    const size_t checked = atto_pool_run(crash_last, record_crash, NULL, 3U);
+    const size_t new_failures = atto_counter_assert_failures - failures;
+    expected_failures_counter += new_failures;
+    atto_eq(checked, 2U);
+    atto_eq(new_failures, 1U);
+    atto_eq(crashed_amount, 1U);
+    atto_eq(crashed_workers[0], 2U);
+}
+
+int
+main(void)
+{
+    test_counters_are_merged();
+    test_single_worker_runs_here();
+    test_failures_of_workers_are_counted();
+    test_crashed_worker_is_a_failure();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
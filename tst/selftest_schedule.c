@@ -0,0 +1,222 @@
+/**
+ * @file
+ * Example usage of Atto schedule and also the test for Atto schedule itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_schedule.h"
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define TIMING_FILE "selftest_schedule.bin"
+
+/** Names of the test cases in the order they were launched. */
+static const char* launched[8];
+static size_t launched_amount = 0U;
+
+static void
+record_launch(const char* const name)
+{
+    launched[launched_amount++] = name;
+}
+
+static void
+test_short(void)
+{
+    record_launch("test_short");
+    atto_true(1);
+}
+
+static void
+test_medium(void)
+{
+    record_launch("test_medium");
+    atto_true(1);
+}
+
+static void
+test_long(void)
+{
+    record_launch("test_long");
+    atto_true(1);
+}
+
+static void
+test_failing(void)
+{
+    record_launch("test_failing");
+    SHOULD_FAIL(atto_fail());
+}
+
+/** Registers the test cases again, as a new run of the test suite would. */
+static void
+register_all(void)
+{
+    atto_schedule(test_short);
+    atto_schedule(test_medium);
+    atto_schedule(test_long);
+    atto_schedule(test_failing);
+    launched_amount = 0U;
+}
+
+/**
+ * Writes the timing file with fixed durations, as a previous run would, so
+ * the expected order does not depend on the measured ones.
+ */
+static void
+write_timing_file(void)
+{
+    atto_schedule_clear();
+    register_all();
+    atto_schedule_set_duration_ns("test_short", ATTO_MS(2));
+    atto_schedule_set_duration_ns("test_medium", ATTO_MS(20));
+    atto_schedule_set_duration_ns("test_long", ATTO_MS(40));
+    atto_schedule_set_duration_ns("test_failing", ATTO_MS(10));
+    atto_eq(atto_schedule_save(TIMING_FILE), 0);
+}
+
+static void
+test_unknown_durations_keep_registration_order(void)
+{
+    remove(TIMING_FILE);
+    atto_schedule_clear();
+    register_all();
+    atto_eq(atto_schedule_load(TIMING_FILE), 1);
+    atto_schedule_run(0U, 1U);
+    atto_eq(launched_amount, 4U);
+    atto_streq(launched[0], "test_short", 20U);
+    atto_streq(launched[1], "test_medium", 20U);
+    atto_streq(launched[2], "test_long", 20U);
+    atto_streq(launched[3], "test_failing", 20U);
+    atto_gt(atto_schedule_duration_ns("test_long"), 0U);
+    atto_eq(atto_schedule_save(TIMING_FILE), 0);
+}
+
+static void
+test_known_durations_run_longest_first(void)
+{
+    write_timing_file();
+    atto_schedule_clear();
+    register_all();
+    atto_eq(atto_schedule_load(TIMING_FILE), 0);
+    atto_eq(atto_schedule_duration_ns("test_medium"), ATTO_MS(20));
+    atto_schedule_run(0U, 1U);
+    atto_eq(launched_amount, 4U);
+    atto_streq(launched[0], "test_long", 20U);
+    atto_streq(launched[1], "test_medium", 20U);
+    atto_streq(launched[2], "test_failing", 20U);
+    atto_streq(launched[3], "test_short", 20U);
+}
+
+static void
+test_shards_are_balanced(void)
+{
+    // LPT on 2 shards: long (40) | medium (20) + failing (10) + short (2)
+    atto_schedule_clear();
+    register_all();
+    atto_eq(atto_schedule_load(TIMING_FILE), 0);
+    atto_schedule_run(0U, 2U);
+    atto_eq(launched_amount, 1U);
+    atto_streq(launched[0], "test_long", 20U);
+    atto_eq(atto_schedule_load(TIMING_FILE), 0);  // As the other shard would
+    launched_amount = 0U;
+    atto_schedule_run(1U, 2U);
+    atto_eq(launched_amount, 3U);
+    atto_streq(launched[0], "test_medium", 20U);
+    atto_streq(launched[1], "test_failing", 20U);
+    atto_streq(launched[2], "test_short", 20U);
+}
+
+static void
+test_shard_files_are_merged(void)
+{
+    char path_of_shard[FILENAME_MAX];
+
+    // Each shard as a separate process: loads the shared file, saves its own
+    write_timing_file();
+    atto_schedule_clear();
+    register_all();
+    atto_eq(atto_schedule_load(TIMING_FILE), 0);
+    atto_schedule_run(0U, 2U);
+    atto_eq(atto_schedule_save_shard(TIMING_FILE, 0U), 0);
+    const uint64_t long_ns = atto_schedule_duration_ns("test_long");
+    atto_schedule_clear();
+    register_all();
+    atto_eq(atto_schedule_load(TIMING_FILE), 0);
+    atto_schedule_run(1U, 2U);
+    atto_eq(atto_schedule_save_shard(TIMING_FILE, 1U), 0);
+    atto_streq(launched[0], "test_medium", 20U);  // Same assignment as shard 0
+    const uint64_t short_ns = atto_schedule_duration_ns("test_short");
+    atto_eq(atto_schedule_duration_ns("test_long"), ATTO_MS(40));  // Not by this shard
+
+    atto_eq(atto_schedule_merge(TIMING_FILE, 2U), 0);
+    atto_schedule_clear();
+    atto_eq(atto_schedule_load(TIMING_FILE), 0);
+    atto_eq(atto_schedule_duration_ns("test_long"), long_ns);
+    atto_eq(atto_schedule_duration_ns("test_short"), short_ns);
+    snprintf(path_of_shard, sizeof(path_of_shard), "%s.0", TIMING_FILE);
+    atto_eq(fopen(path_of_shard, "rb"), NULL);
+}
+
+static void
+test_stale_durations_are_dropped(void)
+{
+    static char names[ATTO_SCHEDULE_MAX_TESTS][24];
+
+    // A full file of test cases since deleted or renamed
+    atto_schedule_clear();
+    for (size_t i = 0U; i < ATTO_SCHEDULE_MAX_TESTS; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "test_deleted_%zu", i);
+        atto_eq(atto_schedule_add(test_short, names[i]), 0);
+        atto_schedule_set_duration_ns(names[i], ATTO_MS(1));
+    }
+    atto_eq(atto_schedule_save(TIMING_FILE), 0);
+    atto_schedule_clear();
+    register_all();
+    atto_eq(atto_schedule_load(TIMING_FILE), 0);
+    atto_eq(atto_schedule_duration_ns("test_deleted_0"), ATTO_MS(1));
+    atto_schedule_run(0U, 1U);
+    atto_eq(atto_schedule_save(TIMING_FILE), 0);
+
+    atto_schedule_clear();
+    atto_eq(atto_schedule_load(TIMING_FILE), 0);
+    atto_gt(atto_schedule_duration_ns("test_long"), 0U);
+    atto_gt(atto_schedule_duration_ns("test_short"), 0U);
+    atto_eq(atto_schedule_duration_ns("test_deleted_0"), 0U);
+}
+
+static void
+test_corrupted_file_is_ignored(void)
+{
+    FILE* const file = fopen(TIMING_FILE, "wb");
+    atto_neq(file, NULL);
+    fputs("not a timing file", file);
+    fclose(file);
+    atto_schedule_clear();
+    register_all();
+    atto_eq(atto_schedule_load(TIMING_FILE), 1);
+    atto_eq(atto_schedule_duration_ns("test_long"), 0U);
+    remove(TIMING_FILE);
+}
+
+int
+main(void)
+{
+    test_unknown_durations_keep_registration_order();
+    test_known_durations_run_longest_first();
+    test_shards_are_balanced();
+    test_shard_files_are_merged();
+    test_stale_durations_are_dropped();
+    test_corrupted_file_is_ignored();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,224 @@
+/**
+ * @file
+ * Example usage of Atto server and also the test for Atto server itself.
+ *
+ * The suite tst/selftest_server_suite.c is built as a shared object and its
+ * path passed in ATTO_SELFTEST_SUITE.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#define _POSIX_C_SOURCE 200809L /* For mkdtemp() */
+
+#include "atto_server.h"
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static size_t expected_failures_counter = 0;
+
+static char directory[] = "/tmp/atto_server_XXXXXX";
+static char suite_path[sizeof(directory) + 16U];
+static char socket_path[sizeof(directory) + 16U];
+
+/** Copies the built suite into place as a new file, as a rebuild does. */
+static int
+rebuild_suite(void)
+{
+    char temporary[sizeof(suite_path) + 4U];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", suite_path);
+    FILE* const source = fopen(ATTO_SELFTEST_SUITE, "rb");
+    FILE* const destination = fopen(temporary, "wb");
+    int error = source == NULL || destination == NULL;
+    char buffer[4096];
+    size_t read = 0U;
+    while (!error && (read = fread(buffer, 1U, sizeof(buffer), source)) > 0U)
+    {
+        error = fwrite(buffer, 1U, read, destination) != read;
+    }
+    if (source != NULL)
+    {
+        fclose(source);
+    }
+    if (destination != NULL)
+    {
+        error |= fclose(destination) != 0;
+    }
+    return error || rename(temporary, suite_path) != 0;
+}
+
+static void
+test_load(void)
+{
+    atto_eq(rebuild_suite(), 0);
+    atto_eq(atto_server_load("/no/such/suite.so"), 1);
+    atto_eq(atto_server_load(suite_path), 0);
+    atto_eq(atto_server_command("list\n"), 0);
+    atto_eq(atto_server_command("dance\n"), 1);
+    atto_eq(atto_server_command("load\n"), 1);
+}
+
+/** Assertions of the suite passed during the last counted command. */
+static size_t suite_passes = 0U;
+
+/** Executes a command, counting the assertions of the suite it passed. */
+static int
+counted_command(const char* const command)
+{
+    const size_t passes = atto_counter_assert_passes;
+    const int result = atto_server_command(command);
+    suite_passes = atto_counter_assert_passes - passes;
+    return result;
+}
+
+static void
+test_run(void)
+{
+    char command[sizeof(suite_path) + 32U];
+    snprintf(command, sizeof(command), "run %s\n", suite_path);
+    atto_eq(counted_command(command), 0);
+    atto_eq(suite_passes, 2U);
+    // Not rebuilt: its static variables were not reset
+    printf("Expected failure: ");
+    expected_failures_counter++;
+    const size_t failures = atto_counter_assert_failures;
+    atto_eq(counted_command(command), 0);
+    atto_eq(atto_counter_assert_failures, failures + 1U);
+    snprintf(command, sizeof(command), "run %s test_passing\n", suite_path);
+    atto_eq(counted_command(command), 0);
+    atto_eq(suite_passes, 1U);
+    snprintf(command, sizeof(command), "run %s test_missing\n", suite_path);
+    atto_eq(atto_server_command(command), 1);
+}
+
+/** Replaces the suite with a file which is not a shared object. */
+static int
+break_suite(void)
+{
+    char temporary[sizeof(suite_path) + 4U];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", suite_path);
+    FILE* const destination = fopen(temporary, "wb");
+    if (destination == NULL)
+    {
+        return 1;
+    }
+    int error = fputs("not a shared object\n", destination) < 0;
+    error |= fclose(destination) != 0;
+    return error || rename(temporary, suite_path) != 0;
+}
+
+static void
+test_rerun_only_rebuilt(void)
+{
+    atto_eq(counted_command("run\n"), 0);
+    atto_eq(suite_passes, 0U);
+    atto_eq(rebuild_suite(), 0);
+    atto_eq(counted_command("run\n"), 0);
+    // Reloaded, so passing again
+    atto_eq(suite_passes, 2U);
+    atto_eq(counted_command("run\n"), 0);
+    atto_eq(suite_passes, 0U);
+}
+
+static void
+test_failed_reload_keeps_suite(void)
+{
+    char command[sizeof(suite_path) + 32U];
+    snprintf(command, sizeof(command), "run %s test_passing\n", suite_path);
+    atto_eq(break_suite(), 0);
+    atto_eq(counted_command("run\n"), 1);
+    // Deleted, so not rebuilt anymore: the old suite is still loaded
+    atto_eq(unlink(suite_path), 0);
+    atto_eq(counted_command(command), 0);
+    atto_eq(suite_passes, 1U);
+    atto_eq(rebuild_suite(), 0);
+    atto_eq(counted_command("run\n"), 0);
+    atto_eq(suite_passes, 2U);
+}
+
+/** Client in a child process: sends a command, returns 0 if the reply contains the text. */
+static int
+send_command(const char* const command, const char* const expected_reply)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+    const int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    int connected = -1;
+    for (int attempt = 0; attempt < 500 && connected != 0; attempt++)
+    {
+        connected = connect(client, (const struct sockaddr*) &address, sizeof(address));
+        if (connected != 0)
+        {
+            const struct timespec pause = {.tv_sec = 0, .tv_nsec = 10000000};
+            nanosleep(&pause, NULL);
+        }
+    }
+    char reply[4096];
+    size_t length = 0U;
+    ssize_t received = 0;
+    if (connected != 0 || write(client, command, strlen(command)) < 0)
+    {
+        close(client);
+        return 1;
+    }
+    while ((received = read(client, reply + length, sizeof(reply) - 1U - length)) > 0)
+    {
+        length += (size_t) received;
+    }
+    reply[length] = '\0';
+    close(client);
+    return strstr(reply, expected_reply) == NULL;
+}
+
+static void
+test_serve_over_socket(void)
+{
+    fflush(stdout);
+    const pid_t client = fork();
+    if (client == 0)
+    {
+        char too_long[ATTO_SERVER_MAX_COMMAND + 16U];
+        memset(too_long, 'x', sizeof(too_long) - 1U);
+        too_long[sizeof(too_long) - 1U] = '\0';
+        const int failed = send_command("list\n", "Test case: test_runs_once_per_load\n")
+                           || send_command("list", "SERVER | Error: command too long")
+                           || send_command(too_long, "SERVER | Error: command too long")
+                           || send_command("run\n", "SERVER | Tests: 0 |")
+                           || send_command("quit\n", "");
+        _exit(failed);
+    }
+    atto_gt(client, 0);
+    atto_eq(atto_server(socket_path), 0);
+    int status = 0;
+    atto_eq(waitpid(client, &status, 0), client);
+    atto_true(WIFEXITED(status));
+    atto_eq(WEXITSTATUS(status), 0);
+    atto_eq(access(socket_path, F_OK), -1);
+}
+
+int
+main(void)
+{
+    if (mkdtemp(directory) == NULL)
+    {
+        return 1;
+    }
+    snprintf(suite_path, sizeof(suite_path), "%s/suite.so", directory);
+    snprintf(socket_path, sizeof(socket_path), "%s/atto.sock", directory);
+    test_load();
+    test_run();
+    test_rerun_only_rebuilt();
+    test_failed_reload_keeps_suite();
+    test_serve_over_socket();
+    atto_report();
+    unlink(suite_path);
+    rmdir(directory);
+    return expected_failures_counter != atto_counter_assert_failures;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file
+ * Test suite loaded by the self-test of Atto server.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_server.h"
+
+/** Reset only by reloading the suite. */
+static int runs = 0;
+
+static void
+test_passing(void)
+{
+    atto_eq(1 + 1, 2);
+}
+
+static void
+test_runs_once_per_load(void)
+{
+    runs++;
+    atto_eq(runs, 1);
+}
+
+void
+atto_suite_register(atto_suite_t* const suite)
+{
+    atto_suite_add(suite, test_passing);
+    atto_suite_add(suite, test_runs_once_per_load);
+}
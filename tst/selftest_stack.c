@@ -0,0 +1,108 @@
+/**
+ * @file
+ * Example usage of Atto stack and also the test for Atto stack itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_stack.h"
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define FRAME_BYTES (256U)
+#define DEPTH       (8U)
+
+static volatile unsigned int sink;
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+static unsigned int
+recurse(const unsigned int depth)
+{
+    volatile unsigned char frame[FRAME_BYTES];
+    for (size_t i = 0U; i < FRAME_BYTES; i++) { frame[i] = (unsigned char) depth; }
+    if (depth == 0U)
+    {
+        return frame[0];
+    }
+    return recurse(depth - 1U) + frame[FRAME_BYTES - 1U];  // Not a tail call
+}
+
+static void
+test_deep(void)
+{
+    sink = recurse(DEPTH);
+}
+
+static void
+test_shallow(void)
+{
+    sink = recurse(0U);
+}
+
+static void
+test_used_grows_with_depth(void)
+{
+    atto_stack_paint();
+    sink = recurse(0U);
+    const size_t shallow = atto_stack_used();
+    atto_stack_paint();
+    sink = recurse(DEPTH);
+    const size_t deep = atto_stack_used();
+    atto_ge(shallow, FRAME_BYTES);
+    atto_ge(deep, (DEPTH + 1U) * FRAME_BYTES);
+    atto_lt(deep, (DEPTH + 1U) * 4U * FRAME_BYTES);
+    atto_gt(deep, shallow + DEPTH * FRAME_BYTES - 1U);
+}
+
+static void
+test_max_stack(void)
+{
+    atto_max_stack(ATTO_STACK_PAINT_SIZE / 2U, sink = recurse(DEPTH));
+    SHOULD_FAIL(atto_max_stack(DEPTH * FRAME_BYTES / 2U, sink = recurse(DEPTH)));
+}
+
+static void
+test_used_saturates(void)
+{
+    atto_stack_paint();
+    sink = recurse(ATTO_STACK_PAINT_SIZE / FRAME_BYTES + 4U);
+    atto_eq(atto_stack_used(), ATTO_STACK_PAINT_SIZE);
+}
+
+static void
+test_tracked_and_dedicated_peaks(void)
+{
+    atto_eq(atto_stack_track(), 0);
+    atto_run(test_deep);
+    const size_t tracked_deep = atto_stack_last_peak();
+    atto_run(test_shallow);
+    const size_t tracked_shallow = atto_stack_last_peak();
+    atto_ge(tracked_deep, (DEPTH + 1U) * FRAME_BYTES);
+    atto_lt(tracked_shallow, tracked_deep);
+
+    const size_t dedicated_deep = atto_stack_run(test_deep);
+    const size_t dedicated_shallow = atto_stack_run(test_shallow);
+    atto_eq(atto_stack_last_peak(), dedicated_shallow);
+    atto_ge(dedicated_deep, (DEPTH + 1U) * FRAME_BYTES);
+    atto_lt(dedicated_shallow, dedicated_deep);
+}
+
+int
+main(void)
+{
+    test_used_grows_with_depth();
+    test_max_stack();
+    test_used_saturates();
+    test_tracked_and_dedicated_peaks();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
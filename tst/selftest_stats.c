@@ -0,0 +1,166 @@
+/**
+ * @file
+ * Example usage of Atto stats and also the test for Atto stats itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_stats.h"
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define STREAM_LEN   (1000000U)
+#define CHUNK_LEN    (4099U)  // Not a multiple of the block length on purpose
+
+/** Deterministic sawtooth in [-1, 1): mean 0 and variance 1/3 in the limit. */
+static double
+sawtooth(const size_t i)
+{
+    return (double) (i % 2000U) / 1000.0 - 1.0;
+}
+
+static void
+test_stats_empty(void)
+{
+    atto_stats_t stats;
+    atto_stats_init(&stats);
+    atto_eq(stats.count, 0U);
+    atto_nan(atto_stats_mean(&stats));
+    atto_nan(atto_stats_variance(&stats));
+    SHOULD_FAIL(atto_mean_within(&stats, 0.0, 1.0));
+}
+
+static void
+test_stats_empty_min(void)
+{
+    atto_stats_t stats;
+    atto_stats_init(&stats);
+    SHOULD_FAIL(atto_min_ge(&stats, -1.0));
+}
+
+static void
+test_stats_small_double(void)
+{
+    const double samples[] = {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0};
+    atto_stats_t stats;
+    atto_stats_init(&stats);
+    atto_stats_add_d(&stats, samples, 8U);
+
+    atto_eq(stats.count, 8U);
+    atto_mean_within(&stats, 5.0, 1e-12);
+    atto_variance_within(&stats, 4.0, 1e-12);
+    atto_stddev_within(&stats, 2.0, 1e-12);
+    atto_min_ge(&stats, 2.0);
+    atto_max_le(&stats, 9.0);
+    SHOULD_FAIL(atto_max_le(&stats, 8.9));
+}
+
+static void
+test_stats_small_float_chunks(void)
+{
+    const float samples[] = {2.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 7.0f, 9.0f};
+    atto_stats_t stats;
+    atto_stats_init(&stats);
+    atto_stats_add_f(&stats, samples, 3U);
+    atto_stats_add_f(&stats, NULL, 0U);
+    atto_stats_add_f(&stats, &samples[3], 5U);
+
+    atto_eq(stats.count, 8U);
+    atto_mean_within(&stats, 5.0, 1e-12);
+    atto_variance_within(&stats, 4.0, 1e-12);
+    atto_min_ge(&stats, 2.0f);
+    SHOULD_FAIL(atto_min_ge(&stats, 2.1f));
+}
+
+static void
+test_stats_stream(void)
+{
+    static double chunk[CHUNK_LEN];
+    atto_stats_t stats;
+    atto_stats_init(&stats);
+
+    for (size_t start = 0U; start < STREAM_LEN; start += CHUNK_LEN)
+    {
+        const size_t len = STREAM_LEN - start < CHUNK_LEN ? STREAM_LEN - start : CHUNK_LEN;
+        for (size_t i = 0U; i < len; i++) { chunk[i] = 1e6 + sawtooth(start + i); }
+        atto_stats_add_d(&stats, chunk, len);
+    }
+    atto_eq(stats.count, STREAM_LEN);
+    // Large offset on purpose: a naive sum of squares would lose all digits
+    atto_mean_within(&stats, 1e6 - 0.0005, 1e-9);
+    atto_variance_within(&stats, 1.0 / 3.0, 1e-6);
+    atto_min_ge(&stats, 1e6 - 1.0);
+    atto_max_le(&stats, 1e6 + 1.0);
+    SHOULD_FAIL(atto_mean_within(&stats, 1e6, 1e-6));
+}
+
+static void
+test_rmse_empty(void)
+{
+    atto_rmse_t rmse;
+    atto_rmse_init(&rmse);
+    atto_nan(atto_rmse_value(&rmse));
+    SHOULD_FAIL(atto_rmse_le(&rmse, 1.0));
+}
+
+static void
+test_rmse_double(void)
+{
+    const double obtained[] = {1.0, 2.0, 3.0, 4.0, 5.0};
+    const double reference[] = {1.0, 2.0, 3.0, 4.0, 7.0};
+    atto_rmse_t rmse;
+    atto_rmse_init(&rmse);
+    atto_rmse_add_d(&rmse, obtained, reference, 5U);
+
+    atto_dapprox(atto_rmse_value(&rmse), sqrt(4.0 / 5.0));
+    atto_dapprox(rmse.max_abs_error, 2.0);
+    atto_rmse_le(&rmse, 0.9);
+    atto_rmse_le(&rmse, -0.9);
+    SHOULD_FAIL(atto_rmse_le(&rmse, 0.8));
+}
+
+static void
+test_rmse_float_stream(void)
+{
+    static float obtained[CHUNK_LEN];
+    static float reference[CHUNK_LEN];
+    atto_rmse_t rmse;
+    atto_rmse_init(&rmse);
+
+    for (size_t start = 0U; start < STREAM_LEN; start += CHUNK_LEN)
+    {
+        const size_t len = STREAM_LEN - start < CHUNK_LEN ? STREAM_LEN - start : CHUNK_LEN;
+        for (size_t i = 0U; i < len; i++)
+        {
+            reference[i] = (float) sawtooth(start + i);
+            obtained[i] = reference[i] + ((start + i) % 2U ? 1e-3f : -1e-3f);
+        }
+        atto_rmse_add_f(&rmse, obtained, reference, len);
+    }
+    atto_eq(rmse.count, STREAM_LEN);
+    atto_ddelta(atto_rmse_value(&rmse), 1e-3, 1e-6);
+    atto_rmse_le(&rmse, 1.001e-3);
+    SHOULD_FAIL(atto_rmse_le(&rmse, 0.999e-3));
+}
+
+int
+main(void)
+{
+    test_stats_empty();
+    test_stats_empty_min();
+    test_stats_small_double();
+    test_stats_small_float_chunks();
+    test_stats_stream();
+    test_rmse_empty();
+    test_rmse_double();
+    test_rmse_float_stream();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
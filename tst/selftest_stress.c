@@ -0,0 +1,98 @@
+/**
+ * @file
+ * Example usage of Atto stress and also the test for Atto stress itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_stress.h"
+#include <pthread.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define DURATION ATTO_MS(20)
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint64_t value;
+} locked_counter_t;
+
+static void
+increment_locked(void* const ctx, const size_t thread_idx)
+{
+    locked_counter_t* const counter = ctx;
+    (void) thread_idx;
+    pthread_mutex_lock(&counter->lock);
+    counter->value++;
+    pthread_mutex_unlock(&counter->lock);
+}
+
+static void
+do_nothing(void* const ctx, const size_t thread_idx)
+{
+    (void) ctx;
+    (void) thread_idx;
+}
+
+static void
+test_stress_counts_every_operation(void)
+{
+    static atto_stress_result_t result;
+    locked_counter_t counter = {PTHREAD_MUTEX_INITIALIZER, 0U};
+
+    const double throughput = atto_stress(&result, 3U, DURATION, increment_locked, &counter);
+    atto_gt(throughput, 0.0);
+    atto_eq(result.threads, 3U);
+    atto_ge(result.duration_ns, DURATION);
+    atto_eq(result.total_ops, counter.value);
+    atto_eq(result.total_ops, result.ops[0] + result.ops[1] + result.ops[2]);
+    atto_eq(result.ops[3], 0U);
+    atto_dapprox(result.throughput, throughput);
+}
+
+static void
+test_stress_curve_points(void)
+{
+    atto_stress_curve_t curve;
+
+    atto_stress_curve(&curve, 6U, DURATION, do_nothing, NULL);
+    atto_eq(curve.points, 4U);
+    atto_eq(curve.threads[0], 1U);
+    atto_eq(curve.threads[1], 2U);
+    atto_eq(curve.threads[2], 4U);
+    atto_eq(curve.threads[3], 6U);
+    atto_gt(curve.throughput[3], 0.0);
+    atto_dapprox(atto_stress_speedup(&curve, 1U), 1.0);
+    atto_nan(atto_stress_speedup(&curve, 3U));
+    atto_stress_speedup_ge(&curve, 1U, 1.0);
+    SHOULD_FAIL(atto_stress_speedup_ge(&curve, 3U, 0.0));
+}
+
+static void
+test_stress_scaling_failure(void)
+{
+    atto_stress_curve_t curve;
+
+    atto_stress_curve(&curve, 2U, DURATION, do_nothing, NULL);
+    atto_eq(curve.points, 2U);
+    // No operation can scale 1000x on 2 threads
+    SHOULD_FAIL(atto_stress_speedup_ge(&curve, 2U, 1000.0));
+}
+
+int
+main(void)
+{
+    test_stress_counts_every_operation();
+    test_stress_curve_points();
+    test_stress_scaling_failure();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
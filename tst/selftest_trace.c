@@ -0,0 +1,124 @@
+/**
+ * @file
+ * Example usage of Atto trace and also the test for Atto trace itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_trace.h"
+#include <pthread.h>
+#include <unistd.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define TRACE_FILE "selftest_trace.json"
+#define WORKERS    (3U)
+
+/** Content of the written trace file. */
+static char trace[256U * 1024U];
+
+static void
+busy_us(const uint64_t us)
+{
+    const uint64_t end = atto_time_ns() + ATTO_US(us);
+    while (atto_time_ns() < end) { }
+}
+
+static void
+load_fixtures(void)
+{
+    busy_us(200U);
+}
+
+static void
+test_with_fixture(void)
+{
+    atto_trace_span("load_fixtures", "fixture", load_fixtures());
+    atto_trace_span("bench_loop", "bench", busy_us(300U));
+    atto_true(1);
+}
+
+static void
+test_failing_inside_span(void)
+{
+    atto_trace_span("failing_span", "fixture", SHOULD_FAIL(atto_fail()));
+}
+
+static void*
+worker(void* const arg)
+{
+    (void) arg;
+    for (size_t i = 0U; i < 5U; i++) { atto_trace_span("work_item", "worker", busy_us(100U)); }
+    return NULL;
+}
+
+static void
+test_workers(void)
+{
+    pthread_t threads[WORKERS];
+    for (size_t i = 0U; i < WORKERS; i++)
+    {
+        atto_eq(pthread_create(&threads[i], NULL, worker, NULL), 0);
+    }
+    for (size_t i = 0U; i < WORKERS; i++) { pthread_join(threads[i], NULL); }
+}
+
+/** Amount of occurrences of the text in the trace. */
+static size_t
+occurrences(const char* const text)
+{
+    size_t amount = 0U;
+    for (const char* at = strstr(trace, text); at != NULL; at = strstr(at + 1, text)) { amount++; }
+    return amount;
+}
+
+static void
+test_written_trace(void)
+{
+    atto_eq(atto_trace_write(TRACE_FILE), 0);
+    FILE* const file = fopen(TRACE_FILE, "r");
+    atto_neq(file, NULL);
+    const size_t len = fread(trace, 1U, sizeof(trace) - 1U, file);
+    fclose(file);
+    trace[len] = '\0';
+
+    atto_eq(strncmp(trace, "{\"traceEvents\":[", 16U), 0);
+    atto_neq(strstr(trace, "\"name\":\"test_with_fixture\",\"cat\":\"test\""), NULL);
+    atto_neq(strstr(trace, "\"name\":\"load_fixtures\",\"cat\":\"fixture\""), NULL);
+    atto_neq(strstr(trace, "\"name\":\"bench_loop\",\"cat\":\"bench\""), NULL);
+    atto_eq(occurrences("\"name\":\"work_item\""), 5U * WORKERS);
+    atto_eq(occurrences("\"name\":\"thread_name\""), 1U + WORKERS);
+    atto_neq(strstr(trace, "\"tid\":4"), NULL);
+    char process[32];
+    snprintf(process, sizeof(process), "\"pid\":%ld,", (long) getpid());
+    atto_eq(occurrences(process), occurrences("\"pid\":"));
+    // Failure marker and failed span, closed despite leaving early
+    atto_eq(occurrences("\"name\":\"FAIL\""), 1U);
+    atto_eq(occurrences("\"args\":{\"failed\":true}"), 1U);
+    atto_eq(occurrences("\"ph\":\"B\"") - 5U * WORKERS, 7U);
+    // Only this test case, still in progress, is open
+    atto_eq(occurrences("\"ph\":\"B\""), occurrences("\"ph\":\"E\"") + 1U);
+}
+
+int
+main(void)
+{
+    atto_trace_span("not_enabled_yet", "fixture", busy_us(10U));
+    if (atto_trace_enable(TRACE_FILE) != 0)
+    {
+        return 1;
+    }
+    atto_run(test_with_fixture);
+    atto_run(test_failing_inside_span);
+    atto_run(test_workers);
+    atto_run(test_written_trace);
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
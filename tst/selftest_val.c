@@ -0,0 +1,142 @@
+/**
+ * @file
+ * Example usage of Atto val and also the test for Atto val itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_val.h"
+#include <stdbool.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+/** Counts its calls, to verify how many times an operand is evaluated. */
+static size_t evaluations = 0;
+
+static int
+evaluated_int(const int value)
+{
+    evaluations++;
+    return value;
+}
+
+static void
+test_integers(void)
+{
+    const unsigned char byte = 200U;
+    const short small = -3;
+    const size_t size = 5U;
+    atto_val_eq(1, 1);
+    atto_val_eq(byte, 200);
+    atto_val_eq(size, 5);
+    atto_val_lt(small, byte);
+    atto_val_le(small, -3L);
+    atto_val_gt(size, small);
+    atto_val_ge(true, 1U);
+    atto_val_neq('a', 'b');
+    SHOULD_FAIL(atto_val_eq(size, 6U));
+}
+
+static void
+test_signed_unsigned_mix_is_mathematical(void)
+{
+    atto_val_lt(-1, 0U);
+    atto_val_gt(0U, -1);
+    atto_val_neq(-1, 0xFFFFFFFFU);
+    atto_val_lt(INTMAX_MIN, UINTMAX_MAX);
+    SHOULD_FAIL(atto_val_eq(-1, 0xFFFFFFFFU));
+}
+
+static void
+test_floating(void)
+{
+    atto_val_eq(0.5f, 0.5);
+    atto_val_eq(2.0L, 2);
+    atto_val_lt(1, 1.5);
+    atto_val_gt(1.5f, -2);
+    atto_val_neq((double) NAN, (double) NAN);
+    SHOULD_FAIL(atto_val_lt(1.0, 0.1));
+}
+
+static void
+test_nan_is_unordered(void)
+{
+    SHOULD_FAIL(atto_val_ge((double) NAN, 0.0));
+}
+
+static void
+test_nan_is_not_equal(void)
+{
+    SHOULD_FAIL(atto_val_eq((double) NAN, (double) NAN));
+}
+
+static void
+test_strings(void)
+{
+    char buffer[8] = "atto";
+    const char* const name = "atto";
+    atto_val_eq(buffer, name);  // By content
+    atto_val_eq(name, "atto");
+    atto_val_lt("ab", "b");
+    atto_val_neq(name, NULL);
+    buffer[0] = 'A';
+    SHOULD_FAIL(atto_val_eq(buffer, "atto"));
+}
+
+static void
+test_pointers(void)
+{
+    int values[2] = {0, 0};
+    const int* const first = &values[0];
+    atto_val_eq(first, values);
+    atto_val_lt(&values[0], &values[1]);
+    atto_val_neq(first, NULL);
+    SHOULD_FAIL(atto_val_eq(first, NULL));
+}
+
+static void
+test_operands_are_evaluated_once(void)
+{
+    evaluations = 0;
+    atto_val_eq(evaluated_int(3), 3);
+    atto_val_ge(evaluated_int(4), evaluated_int(4));
+    const size_t counted = evaluations;
+    atto_val_eq(counted, 3U);
+}
+
+static void
+test_failure_evaluates_once(void)
+{
+    evaluations = 0;
+    SHOULD_FAIL(atto_val_gt(evaluated_int(1), 2));
+}
+
+static void
+test_failure_evaluated_once_verification(void)
+{
+    atto_val_eq(evaluations, 1U);
+}
+
+int
+main(void)
+{
+    test_integers();
+    test_signed_unsigned_mix_is_mathematical();
+    test_floating();
+    test_nan_is_unordered();
+    test_nan_is_not_equal();
+    test_strings();
+    test_pointers();
+    test_operands_are_evaluated_once();
+    test_failure_evaluates_once();
+    test_failure_evaluated_once_verification();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
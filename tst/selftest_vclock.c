@@ -0,0 +1,140 @@
+/**
+ * @file
+ * Example usage of Atto vclock and also the test for Atto vclock itself.
+ *
+ * Compiled with `ATTO_VCLOCK_INTERPOSE`, so the C library time functions are
+ * virtual as well.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#define _GNU_SOURCE /* For usleep() */
+#include "atto_time.h"
+#include "atto_vclock.h"
+#include <time.h>
+#include <unistd.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+static uint64_t
+monotonic_ns(const clockid_t id)
+{
+    struct timespec now;
+    clock_gettime(id, &now);
+    return (uint64_t) now.tv_sec * 1000000000U + (uint64_t) now.tv_nsec;
+}
+
+/** Example of code under test: retries with exponential backoff until the deadline. */
+static unsigned int
+retry_with_backoff(const uint64_t timeout_ns)
+{
+    const uint64_t deadline = monotonic_ns(CLOCK_MONOTONIC) + timeout_ns;
+    struct timespec backoff = {.tv_sec = 0, .tv_nsec = 100000000L};  // 100 ms
+    unsigned int attempts = 1U;
+
+    while (monotonic_ns(CLOCK_MONOTONIC) < deadline)
+    {
+        nanosleep(&backoff, NULL);
+        attempts++;
+        backoff.tv_sec *= 2;
+        backoff.tv_nsec *= 2;
+        if (backoff.tv_nsec >= 1000000000L)
+        {
+            backoff.tv_sec += 1;
+            backoff.tv_nsec -= 1000000000L;
+        }
+    }
+    return attempts;
+}
+
+static void
+test_disabled_is_real_time(void)
+{
+    atto_false(atto_vclock_is_enabled());
+    const uint64_t start = atto_vclock_now_ns();
+    atto_vclock_sleep_ns(ATTO_MS(2));
+    atto_vclock_advance_ns(ATTO_S(100));  // Ignored
+    const uint64_t elapsed = atto_vclock_now_ns() - start;
+    atto_ge(elapsed, ATTO_MS(2));
+    atto_lt(elapsed, ATTO_S(100));
+}
+
+static void
+test_virtual_sleeps_are_instant(void)
+{
+    atto_vclock_enable();
+    atto_true(atto_vclock_is_enabled());
+    const uint64_t real_start = atto_time_ns();
+    const uint64_t start = atto_vclock_now_ns();
+
+    atto_vclock_sleep_ns(ATTO_S(60));
+    atto_eq(atto_vclock_now_ns() - start, ATTO_S(60));
+    atto_vclock_advance_ns(ATTO_MS(5));
+    atto_eq(atto_vclock_now_ns() - start, ATTO_S(60) + ATTO_MS(5));
+    atto_lt(atto_time_ns() - real_start, ATTO_S(1));  // Reporting clock stays real
+    atto_vclock_disable();
+}
+
+static void
+test_interposed_functions(void)
+{
+    atto_vclock_enable();
+    const uint64_t real_start = atto_time_ns();
+    const uint64_t start = monotonic_ns(CLOCK_MONOTONIC);
+    const uint64_t wall_start = monotonic_ns(CLOCK_REALTIME);
+    atto_eq(start, atto_vclock_now_ns());
+
+    atto_eq(sleep(3600U), 0U);
+    atto_eq(usleep(250000U), 0);
+    const struct timespec duration = {.tv_sec = 1, .tv_nsec = 5};
+    atto_eq(nanosleep(&duration, NULL), 0);
+
+    const uint64_t expected = ATTO_S(3600) + ATTO_MS(250) + ATTO_S(1) + 5U;
+    atto_eq(monotonic_ns(CLOCK_MONOTONIC) - start, expected);
+    atto_eq(monotonic_ns(CLOCK_REALTIME) - wall_start, expected);
+    atto_lt(monotonic_ns(CLOCK_MONOTONIC_RAW) - real_start, ATTO_S(1));
+    atto_lt(atto_time_ns() - real_start, ATTO_S(1));
+    atto_vclock_disable();
+}
+
+static void
+test_retry_with_backoff_is_deterministic(void)
+{
+    atto_vclock_enable();
+    const uint64_t real_start = atto_time_ns();
+    // 0.1 + 0.2 + 0.4 + ... + 25.6 s > 30 s after 9 sleeps
+    atto_eq(retry_with_backoff(ATTO_S(30)), 10U);
+    atto_eq(retry_with_backoff(ATTO_S(30)), 10U);
+    atto_lt(atto_time_ns() - real_start, ATTO_S(1));
+    const unsigned int attempts = retry_with_backoff(ATTO_S(60));
+    atto_vclock_disable();
+    SHOULD_FAIL(atto_eq(attempts, 10U));
+}
+
+static void
+test_disabled_again(void)
+{
+    atto_false(atto_vclock_is_enabled());
+    const uint64_t start = monotonic_ns(CLOCK_MONOTONIC);
+    atto_eq(usleep(1000U), 0);
+    atto_ge(monotonic_ns(CLOCK_MONOTONIC) - start, ATTO_MS(1));
+}
+
+int
+main(void)
+{
+    test_disabled_is_real_time();
+    test_virtual_sleeps_are_instant();
+    test_interposed_functions();
+    test_retry_with_backoff_is_deterministic();
+    test_disabled_again();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}
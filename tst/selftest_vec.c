@@ -0,0 +1,253 @@
+/**
+ * @file
+ * Example usage of Atto vec and also the test for Atto vec itself.
+ *
+ * @copyright Copyright © 2019-2024, Matjaž Guštin <dev@matjaz.it>
+ * <https://matjaz.it>. All rights reserved.
+ * @license BSD 3-clause license.
+ */
+
+#include "atto_vec.h"
+#include <stdint.h>
+
+static size_t expected_failures_counter = 0;
+
+#define SHOULD_FAIL(failing)      \
+    printf("Expected failure: "); \
+    expected_failures_counter++;  \
+    failing
+
+#define KAT_FILE    "selftest_vec.rsp"
+#define BINARY_FILE "selftest_vec.bin"
+#define BIG_RECORDS (10000U)
+
+/** Known-answer tests of a 16-bit big-endian addition, record 3 is wrong. */
+static const char kat[] = "# Addition known answers\n"
+                          "\n"
+                          "[ADD]\n"
+                          "\n"
+                          "COUNT = 0\n"
+                          "A = 0001\n"
+                          "B = 0002\n"
+                          "SUM = 0003\n"
+                          "\n"
+                          "COUNT = 1\r\n"
+                          "A   =   00ff\r\n"
+                          "B = 0001\r\n"
+                          "SUM = 0100\r\n"
+                          "\n"
+                          "\n"
+                          "COUNT = 2\n"
+                          "A = FFFF\n"
+                          "B = 0000\n"
+                          "SUM = ffff\n"
+                          "[WRONG]\n"
+                          "COUNT = 3\n"
+                          "A = 0001\n"
+                          "B = 0001\n"
+                          "SUM = 0003\n";
+
+/** Writes a whole file. */
+static void
+write_file(const char* const path, const void* const data, const size_t len)
+{
+    FILE* const file = fopen(path, "wb");
+    if (file != NULL)
+    {
+        fwrite(data, 1U, len, file);
+        fclose(file);
+    }
+}
+
+/** Appends one field to a binary test-vector file. */
+static void
+write_binary_field(FILE* const file, const char* const name, const void* value, uint32_t len)
+{
+    const unsigned char header[4] = {(unsigned char) len,
+                                     (unsigned char) (len >> 8U),
+                                     (unsigned char) (len >> 16U),
+                                     (unsigned char) (len >> 24U)};
+    fputc((int) strlen(name), file);
+    fputs(name, file);
+    fwrite(header, 1U, sizeof(header), file);
+    fwrite(value, 1U, len, file);
+}
+
+/** Writes many addition records in the binary format, all correct. */
+static void
+write_binary_file(void)
+{
+    FILE* const file = fopen(BINARY_FILE, "wb");
+    if (file == NULL)
+    {
+        return;
+    }
+    fputs("ATTOVEC1", file);
+    for (uint32_t i = 0U; i < BIG_RECORDS; i++)
+    {
+        const unsigned char a[2] = {(unsigned char) (i >> 8U), (unsigned char) i};
+        const unsigned char b[2] = {0U, 1U};
+        const uint32_t sum = i + 1U;
+        const unsigned char s[2] = {(unsigned char) (sum >> 8U), (unsigned char) sum};
+        fputc(3, file);
+        write_binary_field(file, "A", a, 2U);
+        write_binary_field(file, "B", b, 2U);
+        write_binary_field(file, "SUM", s, 2U);
+    }
+    fclose(file);
+}
+
+static unsigned int
+big_endian_16(const unsigned char* const bytes)
+{
+    return (unsigned int) bytes[0] << 8U | (unsigned int) bytes[1];
+}
+
+/** The parameterised test body: verifies one addition. */
+static void
+check_addition(const atto_vec_record_t* const record, void* const ctx)
+{
+    unsigned char a[2];
+    unsigned char b[2];
+    unsigned char sum[2];
+    atto_eq(atto_vec_bytes(record, "A", a, sizeof(a)), 2U);
+    atto_eq(atto_vec_bytes(record, "B", b, sizeof(b)), 2U);
+    atto_eq(atto_vec_bytes(record, "SUM", sum, sizeof(sum)), 2U);
+    const unsigned int expected = big_endian_16(sum);
+    const unsigned int computed = (big_endian_16(a) + big_endian_16(b)) & 0xFFFFU;
+    if (ctx != NULL && record->index == 3U)
+    {
+        SHOULD_FAIL(atto_eq(computed, expected));
+    }
+    atto_eq(computed, expected);
+}
+
+static void
+test_parse_kat(void)
+{
+    atto_vec_file_t file;
+    atto_vec_cursor_t cursor;
+    atto_vec_record_t record;
+    unsigned long long count = 99U;
+    write_file(KAT_FILE, kat, sizeof(kat) - 1U);
+    atto_eq(atto_vec_open(&file, KAT_FILE), 0);
+    atto_eq(file.binary, 0);
+    atto_vec_rewind(&file, &cursor);
+
+    atto_eq(atto_vec_next(&file, &cursor, &record), 1);
+    atto_eq(record.index, 0U);
+    atto_eq(record.line, 5U);
+    atto_eq(record.fields_amount, 4U);
+    atto_eq(record.section_len, 3U);
+    atto_memeq(record.section, "ADD", 3U);
+    atto_eq(atto_vec_uint(&record, "COUNT", &count), 0);
+    atto_eq(count, 0U);
+    atto_eq(atto_vec_field(&record, "MISSING"), NULL);
+    const char* const name = record.fields[0].name;
+    atto_assert(name >= file.data && name < file.data + file.size);  // Zero copy
+
+    atto_eq(atto_vec_next(&file, &cursor, &record), 1);  // Windows line endings, extra spaces
+    atto_eq(record.line, 10U);
+    const atto_vec_field_t* const a = atto_vec_field(&record, "A");
+    atto_neq(a, NULL);
+    atto_eq(a->value_len, 4U);
+    atto_memeq(a->value, "00ff", 4U);
+
+    atto_eq(atto_vec_next(&file, &cursor, &record), 1);
+    atto_eq(atto_vec_uint(&record, "COUNT", &count), 0);
+    atto_eq(count, 2U);
+    atto_eq(atto_vec_next(&file, &cursor, &record), 1);  // Not separated by a blank line
+    atto_eq(record.index, 3U);
+    atto_memeq(record.section, "WRONG", 5U);
+    atto_eq(atto_vec_next(&file, &cursor, &record), 0);
+    atto_vec_close(&file);
+}
+
+static void
+test_invalid_hex(void)
+{
+    static const char bad[] = "A = 0g\nB = 123\n";
+    atto_vec_file_t file;
+    atto_vec_cursor_t cursor;
+    atto_vec_record_t record;
+    unsigned char out[4];
+    write_file(KAT_FILE, bad, sizeof(bad) - 1U);
+    atto_eq(atto_vec_open(&file, KAT_FILE), 0);
+    atto_vec_rewind(&file, &cursor);
+    atto_eq(atto_vec_next(&file, &cursor, &record), 1);
+    atto_eq(atto_vec_bytes(&record, "A", out, sizeof(out)), SIZE_MAX);
+    atto_eq(atto_vec_bytes(&record, "B", out, sizeof(out)), SIZE_MAX);
+    atto_eq(atto_vec_bytes(&record, "A", out, 0U), SIZE_MAX);
+    atto_vec_close(&file);
+}
+
+static void
+test_run_reports_failing_record(void)
+{
+    write_file(KAT_FILE, kat, sizeof(kat) - 1U);
+    atto_eq(atto_vec_run(KAT_FILE, check_addition, (void*) kat, 1U), 4U);
+}
+
+static void
+test_run_binary_in_parallel(void)
+{
+    write_binary_file();
+    const size_t passes = atto_counter_assert_passes;
+    const size_t tested = atto_vec_run(BINARY_FILE, check_addition, NULL, 4U);
+    const size_t passes_of_workers = atto_counter_assert_passes - passes;
+    atto_eq(tested, BIG_RECORDS);
+    atto_eq(passes_of_workers, 4U * BIG_RECORDS);
+}
+
+static void
+test_run_chunks_cover_all_records(void)
+{
+    // Chunk boundaries not aligned to the checkpoints, more workers than records
+    write_binary_file();
+    atto_eq(atto_vec_run(BINARY_FILE, check_addition, NULL, 7U), BIG_RECORDS);
+    atto_eq(atto_vec_run(BINARY_FILE, check_addition, NULL, ATTO_VEC_MAX_WORKERS), BIG_RECORDS);
+    write_file(KAT_FILE, kat, sizeof(kat) - 1U);
+    const size_t failures = atto_counter_assert_failures;
+    printf("Expected failure: ");
+    atto_eq(atto_vec_run(KAT_FILE, check_addition, NULL, ATTO_VEC_MAX_WORKERS), 4U);
+    expected_failures_counter += atto_counter_assert_failures - failures;
+}
+
+static void
+test_run_kat_in_parallel(void)
+{
+    write_file(KAT_FILE, kat, sizeof(kat) - 1U);
+    const size_t failures = atto_counter_assert_failures;
+    // Workers print their own failure, but cannot count it as expected here
+    printf("Expected failure: ");
+    atto_eq(atto_vec_run(KAT_FILE, check_addition, NULL, 3U), 4U);
+    const size_t new_failures = atto_counter_assert_failures - failures;
+    expected_failures_counter += new_failures;
+    atto_eq(new_failures, 1U);
+}
+
+static void
+test_missing_file(void)
+{
+    const size_t failures = atto_counter_assert_failures;
+    printf("Expected failure: ");
+    atto_eq(atto_vec_run("does_not_exist.rsp", check_addition, NULL, 1U), 0U);
+    expected_failures_counter++;
+    atto_eq(atto_counter_assert_failures, failures + 1U);
+    remove(KAT_FILE);
+    remove(BINARY_FILE);
+}
+
+int
+main(void)
+{
+    test_parse_kat();
+    test_invalid_hex();
+    test_run_reports_failing_record();
+    test_run_binary_in_parallel();
+    test_run_chunks_cover_all_records();
+    test_run_kat_in_parallel();
+    test_missing_file();
+    atto_report();
+    return expected_failures_counter != atto_counter_assert_failures;
+}